@@ -349,3 +349,20 @@ COPY tilesmodificators (tim_itemid, tim_isnotpassable, tim_isnottransparent, tim
 202686230	877	1	1	1	0	0	0
 202686231	878	1	1	1	0	0	0
 \.
+
+--
+-- statistics types timed by the server, samples of types missing here count as unknown
+--
+
+INSERT INTO statistics_types (stat_type_name)
+SELECT name FROM (VALUES
+    ('login queue'),
+    ('login load'),
+    ('logout queue'),
+    ('logout save'),
+    ('cycle effects'),
+    ('tick skew'),
+    ('tick overrun'),
+    ('cycle map journal')
+) AS types (name)
+WHERE NOT EXISTS (SELECT 1 FROM statistics_types WHERE stat_type_name = types.name);
@@ -0,0 +1,33 @@
+--
+-- Fixtures for src/loadtest: 500 accounts with one character each, named
+-- Loadbot1 to Loadbot500 with password loadbot, placed around the demo map
+-- start. Load on top of illarion.sql and demo.sql before starting the server.
+--
+
+SET client_min_messages = warning;
+
+SET search_path = accounts, pg_catalog;
+
+DELETE FROM account WHERE acc_login LIKE 'loadbot%';
+
+INSERT INTO account (acc_id, acc_login, acc_passwd, acc_email, acc_registerdate, acc_lastip, acc_state, acc_maxchars, acc_lang, acc_name)
+SELECT 900000 + n, 'loadbot' || n, 'loadbot', 'loadbot' || n || '@localhost', now(), '127.0.0.1', 3, 1, 0, 'loadbot' || n
+FROM generate_series(1, 500) AS n;
+
+SET search_path = server, pg_catalog;
+
+DELETE FROM player WHERE ply_playerid > 900000 AND ply_playerid <= 900500;
+DELETE FROM chars WHERE chr_name LIKE 'Loadbot%';
+
+INSERT INTO chars (chr_accid, chr_playerid, chr_status, chr_race, chr_sex, chr_name)
+SELECT 900000 + n, 900000 + n, 0, 0, 0, 'Loadbot' || n
+FROM generate_series(1, 500) AS n;
+
+INSERT INTO player (ply_playerid, ply_posx, ply_posy, ply_posz, ply_faceto, ply_age, ply_weight, ply_body_height, ply_hitpoints, ply_mana, ply_attitude, ply_luck, ply_strength, ply_dexterity, ply_constitution, ply_agility, ply_intelligence, ply_perception, ply_willpower, ply_essence, ply_foodlevel, ply_appearance, ply_lifestate, ply_magictype, ply_magicflagsmage, ply_magicflagspriest, ply_magicflagsbard, ply_magicflagsdruid, ply_lastmusic, ply_poison, ply_mental_capacity, ply_dob, ply_hair, ply_beard, ply_hairred, ply_hairgreen, ply_hairblue, ply_skinred, ply_skingreen, ply_skinblue)
+SELECT 900000 + n, 20 + n % 20, 20 + (n / 20) % 20, 0, 0, 50, 60, 180, 10000, 0, 0, 0, 10, 10, 10, 10, 10, 10, 10, 10, 30000, 4, 1, 0, 0, 0, 0, 0, 0, 0, 4000000, 0, 2, 1, 214, 168, 165, 198, 211, 181
+FROM generate_series(1, 500) AS n;
+
+-- the scheduler times World::turntheworld as task "turntheworld", durations
+-- are only recorded for known statistics types
+INSERT INTO statistics_types (stat_type_name)
+SELECT 'turntheworld' WHERE NOT EXISTS (SELECT 1 FROM statistics_types WHERE stat_type_name = 'turntheworld');
@@ -0,0 +1,45 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "ActivityMap.hpp"
+
+void ActivityMap::reset(uint16_t radius) {
+    this->radius = radius;
+    regions.clear();
+}
+
+void ActivityMap::addObserver(const position &pos) {
+    if (radius == 0) {
+        return;
+    }
+
+    const int minX = (pos.x - radius) >> REGION_BITS;
+    const int maxX = (pos.x + radius) >> REGION_BITS;
+    const int minY = (pos.y - radius) >> REGION_BITS;
+    const int maxY = (pos.y + radius) >> REGION_BITS;
+
+    for (int z = pos.z - ACTIVE_LEVELS; z <= pos.z + ACTIVE_LEVELS; ++z) {
+        for (int x = minX; x <= maxX; ++x) {
+            for (int y = minY; y <= maxY; ++y) {
+                regions.insert(key(x, y, z));
+            }
+        }
+    }
+}
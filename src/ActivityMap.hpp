@@ -0,0 +1,78 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _ACTIVITY_MAP_HPP_
+#define _ACTIVITY_MAP_HPP_
+
+#include <unordered_set>
+#include <stdint.h>
+#include "globals.hpp"
+
+/**
+* keeps track of the regions of the world where players are around
+*
+* The world is divided into square regions. A region is active while at
+* least one player is within the activity radius, monsters and NPCs in
+* inactive regions are not simulated. A radius of 0 keeps the whole world
+* active. Not thread-safe, only to be used from the main thread.
+*/
+class ActivityMap {
+public:
+    /**
+    * forgets all active regions
+    * @param radius distance in tiles up to which players activate regions
+    */
+    void reset(uint16_t radius);
+
+    /**
+    * activates all regions within the radius of a player
+    * @param pos the position of the player
+    */
+    void addObserver(const position &pos);
+
+    /**
+    * checks if there is a player close to a position
+    * @param pos the position to check
+    * @return true if characters at that position need to be simulated
+    */
+    bool isActive(const position &pos) const {
+        return radius == 0 || regions.find(key(pos.x >> REGION_BITS, pos.y >> REGION_BITS, pos.z)) != regions.end();
+    }
+
+    /**
+    * @return the number of active regions
+    */
+    size_t size() const {
+        return regions.size();
+    }
+
+private:
+    static const int REGION_BITS = 4;
+    static const int ACTIVE_LEVELS = 2;
+
+    static uint64_t key(int x, int y, int z) {
+        return (uint64_t(uint16_t(x)) << 32) | (uint64_t(uint16_t(y)) << 16) | uint16_t(z);
+    }
+
+    uint16_t radius = 0;
+    std::unordered_set<uint64_t> regions;
+};
+
+#endif
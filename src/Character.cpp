@@ -40,7 +40,6 @@
 #include "script/LuaWeaponScript.hpp"
 #include "script/LuaLearnScript.hpp"
 
-#include "netinterface/protocol/BBIWIServerCommands.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
 
 #define MAJOR_SKILL_GAP 100
@@ -294,6 +293,14 @@ void Character::setInvisible(bool invisible) {
     isinvisible = invisible;
 }
 
+bool Character::isAlwaysActive() const {
+    return alwaysActive;
+}
+
+void Character::setAlwaysActive(bool active) {
+    alwaysActive = active;
+}
+
 int Character::countItem(TYPE_OF_ITEM_ID itemid) const {
     int temp = 0;
 
@@ -668,11 +675,9 @@ bool Character::attack(Character *target) {
 
         if (getType() == player) {
             if (target->isAlive()) {
-                ServerCommandPointer cmd = std::make_shared<BBSendActionTC>(id, 1 , "Attacks : " + target->to_string());
-                _world->monitoringClientList->sendCommand(cmd);
+                _world->monitoringClientList->playerAction(id, 1, "Attacks : " + target->to_string());
             } else {
-                ServerCommandPointer cmd = std::make_shared<BBSendActionTC>(id, 1 , "Killed : " + target->to_string());
-                _world->monitoringClientList->sendCommand(cmd);
+                _world->monitoringClientList->playerAction(id, 1, "Killed : " + target->to_string());
             }
         }
 
@@ -696,23 +701,13 @@ std::string Character::getSkillName(TYPE_OF_SKILL_ID s) const {
 }
 
 unsigned short int Character::getSkill(TYPE_OF_SKILL_ID s) const {
-    auto iterator = skills.find(s);
-
-    if (iterator == skills.end()) {
-        return 0;
-    } else {
-        return (*iterator).second.major;
-    }
+    const skillvalue *sv = skills.find(s);
+    return sv ? sv->major : 0;
 }
 
 unsigned short int Character::getMinorSkill(TYPE_OF_SKILL_ID s) const {
-    auto iterator = skills.find(s);
-
-    if (iterator == skills.end()) {
-        return 0;
-    } else {
-        return (*iterator).second.minor;
-    }
+    const skillvalue *sv = skills.find(s);
+    return sv ? sv->minor : 0;
 }
 
 
@@ -865,67 +860,111 @@ void Character::handleAttributeChange(Character::attributeIndex attribute) {
     }
 }
 
+bool Character::findAttribute(const std::string &name, Character::attributeIndex &attribute) {
+    const auto it = attributeMap.find(name);
+
+    if (it == attributeMap.end()) {
+        return false;
+    }
+
+    attribute = it->second;
+    return true;
+}
+
 bool Character::isBaseAttribValid(const std::string &name, Attribute::attribute_t value) const {
-    try {
-        Character::attributeIndex attribute = attributeMap.at(name);
+    Character::attributeIndex attribute;
+
+    if (findAttribute(name, attribute)) {
         return isBaseAttributeValid(attribute, value);
-    } catch (...) {
-        return false;
     }
+
+    return false;
+}
+
+bool Character::isBaseAttribValid(Character::attributeIndex attribute, Attribute::attribute_t value) const {
+    return isAttribute(attribute) && isBaseAttributeValid(attribute, value);
 }
 
 bool Character::setBaseAttrib(const std::string &name, Attribute::attribute_t value) {
-    try {
-        Character::attributeIndex attribute = attributeMap.at(name);
+    Character::attributeIndex attribute;
+
+    if (findAttribute(name, attribute)) {
         return setBaseAttribute(attribute, value);
-    } catch (...) {
-        return false;
     }
+
+    return false;
+}
+
+bool Character::setBaseAttrib(Character::attributeIndex attribute, Attribute::attribute_t value) {
+    return isAttribute(attribute) && setBaseAttribute(attribute, value);
 }
 
 void Character::setAttrib(const std::string &name, Attribute::attribute_t value) {
-    try {
-        Character::attributeIndex attribute = attributeMap.at(name);
+    Character::attributeIndex attribute;
+
+    if (findAttribute(name, attribute)) {
         setAttribute(attribute, value);
-    } catch (...) {
+    }
+}
 
+void Character::setAttrib(Character::attributeIndex attribute, Attribute::attribute_t value) {
+    if (isAttribute(attribute)) {
+        setAttribute(attribute, value);
     }
 }
 
 Attribute::attribute_t Character::getBaseAttrib(const std::string &name) {
-    try {
-        Character::attributeIndex attribute = attributeMap.at(name);
+    Character::attributeIndex attribute;
+
+    if (findAttribute(name, attribute)) {
         return getBaseAttribute(attribute);
-    } catch (...) {
-        return 0;
     }
+
+    return 0;
+}
+
+Attribute::attribute_t Character::getBaseAttrib(Character::attributeIndex attribute) {
+    return isAttribute(attribute) ? getBaseAttribute(attribute) : 0;
 }
 
 
 
 bool Character::increaseBaseAttrib(const std::string &name, int amount) {
-    try {
-        Character::attributeIndex attribute = attributeMap.at(name);
+    Character::attributeIndex attribute;
+
+    if (findAttribute(name, attribute)) {
         return increaseBaseAttribute(attribute, amount);
-    } catch (...) {
-        return false;
     }
+
+    return false;
+}
+
+bool Character::increaseBaseAttrib(Character::attributeIndex attribute, int amount) {
+    return isAttribute(attribute) && increaseBaseAttribute(attribute, amount);
 }
 
 
 Attribute::attribute_t Character::increaseAttrib(const std::string &name, int amount) {
-    if (name == "sex") {
-        return getAttribute(Character::sex);
+    Character::attributeIndex attribute;
+
+    if (findAttribute(name, attribute)) {
+        return increaseAttrib(attribute, amount);
     }
 
-    try {
-        Character::attributeIndex attribute = attributeMap.at(name);
-        return increaseAttribute(attribute, amount);
-    } catch (...) {
+    return 0;
+}
+
 
+Attribute::attribute_t Character::increaseAttrib(Character::attributeIndex attribute, int amount) {
+    if (!isAttribute(attribute)) {
+        return 0;
     }
 
-    return 0;
+    if (attribute == Character::sex) {
+        return getAttribute(Character::sex);
+    }
+
+    return increaseAttribute(attribute, amount);
 }
 
 unsigned short int Character::setSkill(TYPE_OF_SKILL_ID skill, short int major, short int minor) {
@@ -933,20 +972,10 @@ unsigned short int Character::setSkill(TYPE_OF_SKILL_ID skill, short int major,
         return 0;
     }
 
-    auto iterator = skills.find(skill);
-    {
-        if (iterator == skills.end()) {
-            skillvalue sv;
-            sv.major = major;
-            sv.minor = minor;
-            skills[skill] = sv;
-            return sv.major;
-        } else {
-            iterator->second.major = major;
-            iterator->second.minor = minor;
-            return iterator->second.major;
-        }
-    }
+    skillvalue &sv = skills[skill];
+    sv.major = major;
+    sv.minor = minor;
+    return sv.major;
 }
 
 unsigned short int Character::increaseSkill(TYPE_OF_SKILL_ID skill, short int amount) {
@@ -954,35 +983,30 @@ unsigned short int Character::increaseSkill(TYPE_OF_SKILL_ID skill, short int am
         return 0;
     }
 
-    auto iterator = skills.find(skill);
-
-    if (iterator == skills.end()) {
-        skillvalue sv;
+    skillvalue *sv = skills.find(skill);
 
+    if (!sv) {
         if (amount <= 0) {
             return 0; //Don't add new skill if value <= 0
-        } else if (amount > MAJOR_SKILL_GAP) {
-            sv.major = MAJOR_SKILL_GAP;
-        } else {
-            sv.major = amount;
         }
 
-        skills[skill] = sv;
-        return sv.major;
-    } else {
-        int temp=iterator->second.major + amount;
+        sv = &skills[skill];
+        sv->major = std::min(int(amount), MAJOR_SKILL_GAP);
+        return sv->major;
+    }
 
-        if (temp <= 0) {
-            iterator->second.major = 0;
-            skills.erase(iterator); //L�chen des Eintrags wenn value <= 0
-        } else if (temp > MAJOR_SKILL_GAP) {
-            iterator->second.major = MAJOR_SKILL_GAP;
-        } else {
-            iterator->second.major = temp;
-        }
+    int temp = sv->major + amount;
 
-        return (iterator->second.major);
+    if (temp <= 0) {
+        skills.erase(skill); //L�chen des Eintrags wenn value <= 0
+        return 0;
+    } else if (temp > MAJOR_SKILL_GAP) {
+        sv->major = MAJOR_SKILL_GAP;
+    } else {
+        sv->major = temp;
     }
+
+    return sv->major;
 }
 
 
@@ -991,59 +1015,50 @@ unsigned short int Character::increaseMinorSkill(TYPE_OF_SKILL_ID skill, short i
         return 0;
     }
 
-    auto iterator = skills.find(skill);
-
-    if (iterator == skills.end()) {
-        skillvalue sv;
+    skillvalue *sv = skills.find(skill);
 
+    if (!sv) {
         if (amount <= 0) {
             return 0; //Don't add new skill if value <= 0
-        } else if (amount > 10000) {
-            sv.minor = 10000;
-        } else {
-            sv.minor = amount;
         }
 
-        if (sv.minor >= 10000) {
-            sv.minor = 0;
-            sv.major++;
+        sv = &skills[skill];
+
+        if (amount >= 10000) {
+            sv->major = 1;
+        } else {
+            sv->minor = amount;
         }
 
-        skills[ skill ] = sv;
-        return (sv.major);
-    } else {
-        int temp=iterator->second.minor + amount;
+        return sv->major;
+    }
 
-        if (temp <= 0) {
-            iterator->second.minor = 0;
-            iterator->second.major--;
+    int temp = sv->minor + amount;
 
-            if (iterator->second.major==0) {
-                skills.erase(iterator);    //delete if major == 0
-            }
-        } else if (temp >= 10000) {
-            iterator->second.minor = 0;
-            iterator->second.major++;
+    if (temp <= 0) {
+        sv->minor = 0;
+        sv->major--;
 
-            if (iterator->second.major > MAJOR_SKILL_GAP) {
-                iterator->second.major = MAJOR_SKILL_GAP;
-            }
-        } else {
-            iterator->second.minor = temp;
+        if (sv->major == 0) {
+            skills.erase(skill);    //delete if major == 0
+            return 0;
         }
+    } else if (temp >= 10000) {
+        sv->minor = 0;
+        sv->major++;
 
-        return (iterator->second.major);
+        if (sv->major > MAJOR_SKILL_GAP) {
+            sv->major = MAJOR_SKILL_GAP;
+        }
+    } else {
+        sv->minor = temp;
     }
+
+    return sv->major;
 }
 
 auto Character::getSkillValue(TYPE_OF_SKILL_ID s) const -> const skillvalue * {
-    auto it = skills.find(s);
-
-    if (it == skills.end()) {
-        return nullptr;
-    } else {
-        return &(it->second);
-    }
+    return skills.find(s);
 }
 
 void Character::learn(TYPE_OF_SKILL_ID skill, uint32_t actionPoints, uint8_t opponent) {
@@ -1250,8 +1265,7 @@ void Character::talk(talk_type tt, const std::string &message) { //only for say,
 
         Logger::info(LogFacility::Chat) << *this << " " << talkType << ": " << message << Log::end;
 #endif
-        ServerCommandPointer cmd = std::make_shared<BBTalkTC>(id, static_cast<unsigned char>(tt), message);
-        _world->monitoringClientList->sendCommand(cmd);
+        _world->monitoringClientList->playerTalked(id, static_cast<unsigned char>(tt), message);
     }
 }
 
@@ -31,6 +31,7 @@
 #include "WaypointList.hpp"
 #include "Language.hpp"
 #include "Attribute.hpp"
+#include "SkillSet.hpp"
 #include "Item.hpp"
 
 class World;
@@ -139,10 +140,7 @@ public:
         informScriptHighPriority = 102
     };
 
-    struct skillvalue {
-        unsigned short int major = 0;
-        unsigned short int minor = 0;
-    };
+    typedef SkillSet::value skillvalue;
 
     enum movement_type {
         walk = 0,
@@ -186,6 +184,31 @@ public:
     bool isInvisible() const;
     void setInvisible(bool invisible);
 
+    bool isAlwaysActive() const;
+    void setAlwaysActive(bool active);
+
+    /**
+    * counts a tick in which this character was not simulated since no
+    * player was around
+    */
+    void rest() {
+        ++dormantTicks;
+    }
+
+    bool isResting() const {
+        return dormantTicks > 0;
+    }
+
+    /**
+    * ends the rest of this character
+    * @return the number of ticks this character missed
+    */
+    uint32_t wake() {
+        const uint32_t ticks = dormantTicks;
+        dormantTicks = 0;
+        return ticks;
+    }
+
     LongTimeCharacterEffects effects;
     WaypointList waypoints;
 
@@ -360,11 +383,32 @@ public:
     virtual bool saveBaseAttributes();
     virtual void handleAttributeChange(Character::attributeIndex attribute);
     bool isBaseAttribValid(const std::string &name, Attribute::attribute_t value) const;
+    bool isBaseAttribValid(Character::attributeIndex attribute, Attribute::attribute_t value) const;
     bool setBaseAttrib(const std::string &name, Attribute::attribute_t value);
+    bool setBaseAttrib(Character::attributeIndex attribute, Attribute::attribute_t value);
     void setAttrib(const std::string &name, Attribute::attribute_t value);
+    void setAttrib(Character::attributeIndex attribute, Attribute::attribute_t value);
     Attribute::attribute_t getBaseAttrib(const std::string &name);
+    Attribute::attribute_t getBaseAttrib(Character::attributeIndex attribute);
     bool increaseBaseAttrib(const std::string &name, int amount);
+    bool increaseBaseAttrib(Character::attributeIndex attribute, int amount);
     Attribute::attribute_t increaseAttrib(const std::string &name, int amount);
+    Attribute::attribute_t increaseAttrib(Character::attributeIndex attribute, int amount);
+
+    /**
+    * resolves the name of an attribute
+    * @param name the name of the attribute
+    * @param attribute receives the attribute if the name is known
+    * @return true if the name is known
+    */
+    static bool findAttribute(const std::string &name, Character::attributeIndex &attribute);
+
+    /**
+    * @return true if attribute is a valid id, scripts may pass any number
+    */
+    static bool isAttribute(Character::attributeIndex attribute) {
+        return attribute >= 0 && attribute < ATTRIBUTECOUNT;
+    }
 
     virtual unsigned short int increaseSkill(TYPE_OF_SKILL_ID skill, short int amount);
     virtual unsigned short int increaseMinorSkill(TYPE_OF_SKILL_ID skill, short int amount);
@@ -417,7 +461,7 @@ public:
 
     virtual void performAnimation(uint8_t animID);
 
-    typedef std::map<TYPE_OF_SKILL_ID, skillvalue> SKILLMAP;
+    typedef SkillSet SKILLMAP;
 
     movement_type GetMovement() const;
     void SetMovement(movement_type tmovement);
@@ -564,6 +608,8 @@ private:
     bool attackmode = false;
     std::string lastSpokenText = {};
     bool isinvisible = false;
+    bool alwaysActive = false;
+    uint32_t dormantTicks = 0;
     TYPE_OF_RACE_ID race = 0;
     face_to faceto = north;    
     s_magic magic;
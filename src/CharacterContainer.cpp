@@ -28,9 +28,9 @@
 
 template <class T>
 bool CharacterContainer<T>::getPosition(TYPE_OF_CHARACTER_ID id,position& pos) {
-    auto i = container.find(id);
-    if (i!=container.end()) {
-        pos = (i->second)->getPosition();
+    auto character = find(id);
+    if (character) {
+        pos = character->getPosition();
         return true;
     } else {
         return false;
@@ -38,6 +38,36 @@ bool CharacterContainer<T>::getPosition(TYPE_OF_CHARACTER_ID id,position& pos) {
 }
 
 
+template <class T>
+void CharacterContainer<T>::insert(pointer p) {
+    const auto id = p->getId();
+
+    if (find(id)) {
+        return;
+    }
+
+    compact();
+
+    Entry entry;
+    entry.index = characters.size();
+
+    if (freeSlots.empty()) {
+        entry.slot = slots.size();
+        slots.emplace_back();
+    } else {
+        entry.slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    slots[entry.slot].character = p;
+    ++slots[entry.slot].generation;
+
+    indexById.emplace(id, entry);
+    characters.push_back(p);
+    position_to_id.insert(std::make_pair(p->getPosition(), id));
+}
+
+
 template <class T>
 iterator_range<typename CharacterContainer<T>::position_to_id_type::const_iterator> CharacterContainer<T>::projection_x_axis(const position& pos, int r) const {
     return {{position_to_id.upper_bound(position(pos.x-r-1,0,0)),position_to_id.upper_bound(position(pos.x+r+1,0,0))}};
@@ -50,9 +80,9 @@ auto CharacterContainer<T>::find(const std::string &text) const -> pointer {
         auto id = boost::lexical_cast<TYPE_OF_CHARACTER_ID>(text);
         return find(id);
     } catch (boost::bad_lexical_cast &) {
-        for (const auto &character : container) {
-            if (comparestrings_nocase(character.second->getName(), text)) {
-                return character.second;
+        for (const auto &character : characters) {
+            if (character && comparestrings_nocase(character->getName(), text)) {
+                return character;
             }
         }
     }
@@ -63,16 +93,40 @@ auto CharacterContainer<T>::find(const std::string &text) const -> pointer {
 
 template <class T>
 auto CharacterContainer<T>::find(TYPE_OF_CHARACTER_ID id) const -> pointer {
-    const auto it = container.find(id);
+    const auto it = indexById.find(id);
 
-    if (it != container.end()) {
-        return it->second;
+    if (it != indexById.end()) {
+        return characters[it->second.index];
     }
 
     return nullptr;
 }
 
 
+template <class T>
+auto CharacterContainer<T>::find(const CharacterHandle &handle) const -> pointer {
+    if (handle.slot < slots.size() && slots[handle.slot].generation == handle.generation) {
+        return slots[handle.slot].character;
+    }
+
+    return nullptr;
+}
+
+
+template <class T>
+CharacterHandle CharacterContainer<T>::getHandle(TYPE_OF_CHARACTER_ID id) const {
+    CharacterHandle handle;
+    const auto it = indexById.find(id);
+
+    if (it != indexById.end()) {
+        handle.slot = it->second.slot;
+        handle.generation = slots[it->second.slot].generation;
+    }
+
+    return handle;
+}
+
+
 template <class T>
 auto CharacterContainer<T>::find(const position &pos) const -> pointer {
     const auto i = position_to_id.find(pos);
@@ -107,6 +161,9 @@ void CharacterContainer<T>::update(pointer p, const position& newPosition) {
 
 template <class T>
 bool CharacterContainer<T>::erase(TYPE_OF_CHARACTER_ID id) {
+    // gaps left by an earlier iteration must not be moved into place below
+    compact();
+
     position pos;
     
     if (getPosition(id, pos)) {
@@ -120,7 +177,72 @@ bool CharacterContainer<T>::erase(TYPE_OF_CHARACTER_ID id) {
         }
     }
     
-    return container.erase(id) > 0;
+    const auto it = indexById.find(id);
+
+    if (it == indexById.end()) {
+        return false;
+    }
+
+    const uint32_t index = it->second.index;
+    Slot &slot = slots[it->second.slot];
+    slot.character = nullptr;
+    ++slot.generation;
+    freeSlots.push_back(it->second.slot);
+    indexById.erase(it);
+
+    if (iterating > 0) {
+        // moving the last character would let the running iteration skip it
+        characters[index] = nullptr;
+        ++gaps;
+        return true;
+    }
+
+    // move the last character into the gap to keep the array dense
+    characters[index] = characters.back();
+    characters.pop_back();
+
+    if (index < characters.size()) {
+        indexById[characters[index]->getId()].index = index;
+    }
+
+    return true;
+}
+
+
+template <class T>
+void CharacterContainer<T>::clear() {
+    for (const auto &entry : indexById) {
+        Slot &slot = slots[entry.second.slot];
+        slot.character = nullptr;
+        ++slot.generation;
+        freeSlots.push_back(entry.second.slot);
+    }
+
+    characters.clear();
+    indexById.clear();
+    gaps = 0;
+    position_to_id.clear();
+}
+
+
+template <class T>
+void CharacterContainer<T>::compact() {
+    if (gaps == 0 || iterating > 0) {
+        return;
+    }
+
+    size_t live = 0;
+
+    for (const auto character : characters) {
+        if (character) {
+            characters[live] = character;
+            indexById[character->getId()].index = live;
+            ++live;
+        }
+    }
+
+    characters.resize(live);
+    gaps = 0;
 }
 
 
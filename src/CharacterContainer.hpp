@@ -30,6 +30,26 @@
 #include "constants.hpp"
 
 
+/**
+* refers to a character in a container, finds nothing once the character
+* was erased, even if its memory or its id is reused by another character
+*/
+struct CharacterHandle {
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+};
+
+/**
+* holds the characters of one kind
+*
+* Characters are kept in a dense array, so iterating over them walks
+* contiguous memory. Erasing moves the last character into the gap, except
+* during for_each, where the gap stays empty until the iteration is done.
+* Each character also gets a slot, which counts up its generation whenever
+* it is emptied, so a handle to it turns stale along with the character.
+* Hot fields such as position and action points stay in the characters,
+* behind the virtual accessors scripts use, and are not packed separately.
+*/
 template <class T>
 class CharacterContainer {
 public:
@@ -38,63 +58,113 @@ public:
 private:
     typedef std::function<void(pointer)> for_each_type;
     typedef void(T::*for_each_member_type)();
-    typedef typename std::unordered_map<TYPE_OF_CHARACTER_ID, pointer> container_type;
     typedef typename std::multimap<position, TYPE_OF_CHARACTER_ID,PositionComparison> position_to_id_type;
     position_to_id_type position_to_id;
-    container_type container;
+    struct Slot {
+        pointer character = nullptr;
+        uint32_t generation = 0;
+    };
+
+    struct Entry {
+        uint32_t index;
+        uint32_t slot;
+    };
+
+    // nullptr for characters erased during for_each
+    std::vector<pointer> characters;
+    std::unordered_map<TYPE_OF_CHARACTER_ID, Entry> indexById;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    size_t gaps = 0;
+    mutable unsigned int iterating = 0;
+
+    class IterationGuard {
+    public:
+        explicit IterationGuard(const CharacterContainer &container) : container(container) {
+            ++container.iterating;
+        }
+
+        ~IterationGuard() {
+            --container.iterating;
+        }
+
+    private:
+        const CharacterContainer &container;
+    };
 
     bool getPosition(TYPE_OF_CHARACTER_ID id,position& pos);
     iterator_range<position_to_id_type::const_iterator> projection_x_axis(const position& pos, int r) const;
+    // closes the gaps left by erase, unless an iteration is running
+    void compact();
 
 public:
     bool empty() const {
-        return container.empty();
+        return size() == 0;
     }
 
-    auto size() const -> decltype(container.size()) {
-        return container.size();
+    auto size() const -> decltype(characters.size()) {
+        return characters.size() - gaps;
     }
 
-    void insert(pointer p) {
-        const auto id = p->getId();
-        
-        if (!find(id)) {
-            container.emplace(id, p);
-            position_to_id.insert(std::make_pair(p->getPosition(), id));
-        }
-    }
+    void insert(pointer p);
 
     pointer find(const std::string &name) const;
     pointer find(TYPE_OF_CHARACTER_ID id) const;
     pointer find(const position &pos) const;
+    pointer find(const CharacterHandle &handle) const;
+
+    /**
+    * @return a handle to the character with the given id, an empty handle if
+    * there is none
+    */
+    CharacterHandle getHandle(TYPE_OF_CHARACTER_ID id) const;
+
     void update(pointer p, const position& newPosition);
     bool erase(TYPE_OF_CHARACTER_ID id);
-    void clear() {
-        container.clear();
-        position_to_id.clear();
-    }
+    void clear();
 
     std::vector<pointer> findAllCharactersInRangeOf(const position &pos, const Range &range) const;
     std::vector<pointer> findAllCharactersInScreen(const position &pos) const;
     std::vector<pointer> findAllAliveCharactersInRangeOf(const position &pos, const Range &range) const;
     bool findAllCharactersWithXInRangeOf(short int startx, short int endx, std::vector<pointer> &ret) const;
 
+    // by index, since scripts may add or erase characters while we iterate
     void for_each(const for_each_type &function) {
-        for (const auto &key_value : container) {
-            function(key_value.second);
+        {
+            IterationGuard guard(*this);
+
+            for (size_t i = 0; i < characters.size(); ++i) {
+                if (characters[i]) {
+                    function(characters[i]);
+                }
+            }
         }
+
+        compact();
     }
 
     void for_each(const for_each_type &function) const {
-        for (const auto &key_value : container) {
-            function(key_value.second);
+        IterationGuard guard(*this);
+
+        for (size_t i = 0; i < characters.size(); ++i) {
+            if (characters[i]) {
+                function(characters[i]);
+            }
         }
     }
 
     void for_each(const for_each_member_type &function) {
-        for (const auto &key_value : container) {
-            (key_value.second->*function)();
+        {
+            IterationGuard guard(*this);
+
+            for (size_t i = 0; i < characters.size(); ++i) {
+                if (characters[i]) {
+                    (characters[i]->*function)();
+                }
+            }
         }
+
+        compact();
     }
 };
 
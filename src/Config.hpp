@@ -89,6 +89,26 @@ public:
     ConfigEntry<std::string> scriptdir = { "scriptdir", "./script/" };
 
     ConfigEntry<uint16_t> port = { "port", 3012 };
+    ConfigEntry<std::string> logfile = { "logfile", "syslog" };
+    ConfigEntry<std::string> command_capture = { "command_capture", "none" };
+    ConfigEntry<uint32_t> random_seed = { "random_seed", 0 };
+    ConfigEntry<std::string> statistics_file = { "statistics_file", "none" };
+    ConfigEntry<uint16_t> metrics_port = { "metrics_port", 0 };
+    ConfigEntry<uint16_t> activity_radius = { "activity_radius", 48 };
+    ConfigEntry<uint16_t> network_threads = { "network_threads", 2 };
+    ConfigEntry<uint32_t> send_queue_bytes = { "send_queue_bytes", 1048576 };
+    ConfigEntry<uint32_t> send_queue_commands = { "send_queue_commands", 8192 };
+    ConfigEntry<uint16_t> send_queue_grace = { "send_queue_grace", 10 };
+    ConfigEntry<uint16_t> player_threads = { "player_threads", 4 };
+    ConfigEntry<uint16_t> login_timeout = { "login_timeout", 100 };
+    ConfigEntry<uint16_t> monster_threads = { "monster_threads", 2 };
+    ConfigEntry<std::string> world_shards = { "world_shards", "none" };
+    ConfigEntry<uint16_t> world_shard_threads = { "world_shard_threads", 0 };
+    ConfigEntry<uint16_t> tick_budget = { "tick_budget", 80 };
+    ConfigEntry<uint16_t> fixed_tick_step = { "fixed_tick_step", 0 };
+    ConfigEntry<uint16_t> monitoring_interval = { "monitoring_interval", 250 };
+    ConfigEntry<uint16_t> map_journal = { "map_journal", 1 };
+    ConfigEntry<uint16_t> map_journal_sync = { "map_journal_sync", 100 };
 
     ConfigEntry<std::string> postgres_db = { "postgres_db", "illarion" };
     ConfigEntry<std::string> postgres_user = { "postgres_user", "illarion" };
@@ -17,13 +17,20 @@
 //  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Container.hpp"
+
+#include <algorithm>
+
 #include "data/Data.hpp"
 #include "World.hpp"
+#include "Logger.hpp"
 
-Container::Container(Item::id_type itemId): itemId(itemId) {
+const uint32_t Container::MAXIMALWEIGHT;
+thread_local std::vector<const Container *> *Container::touchLog = nullptr;
+
+Container::Container(Item::id_type itemId): itemId(itemId), weightGeneration(Data::getTableGeneration()) {
 }
 
-Container::Container(const Container &source) {
+Container::Container(const Container &source): weightGeneration(Data::getTableGeneration()) {
     *this = source;
 }
 
@@ -31,25 +38,18 @@ Container &Container::operator=(const Container &source) {
     if (this != &source) {
         itemId = source.itemId;
 
-        items.clear();
-        items = source.items;
-
-        if (!containers.empty()) {
-            for (auto it = containers.begin(); it != containers.end(); ++it) {
-                delete it->second;
-                it->second = nullptr;
-            }
-
-            containers.clear();
-        }
+        clearSlots();
 
-        if (!source.containers.empty()) {
+        for (const auto &slot : source.items) {
+            auto it = source.containers.find(slot.first);
+            Container *container = nullptr;
 
-            for (auto it = source.containers.cbegin(); it != source.containers.cend(); ++it) {
-                containers.insert(CONTAINERMAP::value_type(it->first, new Container(*(it->second))));
+            if (it != source.containers.end()) {
+                container = new Container(*(it->second));
             }
-        }
 
+            insertSlot(slot.first, slot.second, container);
+        }
     }
 
     return *this;
@@ -77,7 +77,10 @@ Item::number_type Container::mergeItem(Item item) {
             Item &selectedItem = it->second;
 
             if (selectedItem.getId() == item.getId() && selectedItem.equalData(item)) {
+                const auto oldWeight = itemWeight(selectedItem);
                 Item::number_type number = selectedItem.increaseNumberBy(item.getNumber());
+                changeWeight(int64_t(itemWeight(selectedItem)) - oldWeight);
+                touch();
 
                 if (number != item.getNumber()) {
                     item.setNumber(number);
@@ -137,21 +140,27 @@ bool Container::InsertItem(Item item, TYPE_OF_CONTAINERSLOTS pos) {
 
                     auto maxStack = item.getMaxStack();
 
+                    const auto oldWeight = itemWeight(selectedItem);
+
                     if (temp <= maxStack) {
                         selectedItem.setMinQuality(item);
                         selectedItem.setNumber(temp);
+                        changeWeight(int64_t(itemWeight(selectedItem)) - oldWeight);
+                        touch();
                         return true;
                     } else if (items.size() < getSlotCount()) {
                         item.setNumber(item.getNumber() - maxStack + selectedItem.getNumber());
                         selectedItem.setMinQuality(item);
                         selectedItem.setNumber(maxStack);
+                        changeWeight(int64_t(itemWeight(selectedItem)) - oldWeight);
+                        touch();
                         insertIntoFirstFreeSlot(item);
                         return true;
                     }
                 }
             }
         } else if (items.size() < getSlotCount()) {
-            items.insert(ITEMMAP::value_type(pos, item));
+            insertSlot(pos, item);
             return true;
         }
     }
@@ -179,8 +188,7 @@ bool Container::InsertContainer(Item it, Container *cc, TYPE_OF_CONTAINERSLOTS p
         if (iterat != items.end()) {
             return InsertContainer(it, cc);
         } else {
-            items.insert(ITEMMAP::value_type(pos, titem));
-            containers.insert(CONTAINERMAP::value_type(pos, cc));
+            insertSlot(pos, titem, cc);
             World::get()->sendContainerSlotChange(this, pos);
             return true;
         }
@@ -199,17 +207,14 @@ bool Container::changeQualityAt(TYPE_OF_CONTAINERSLOTS nr, short int amount) {
 
         if (tmpQuality%100 > 1) {
             item.setQuality(tmpQuality);
+            touch();
             return true;
         } else {
             if (item.isContainer()) {
-                auto iterat = containers.find(nr);
-
-                if (iterat != containers.end()) {
-                    containers.erase(iterat);
-                }
+                detachContainer(nr);
             }
 
-            items.erase(nr);
+            eraseSlot(it);
             return true;
         }
     }
@@ -225,13 +230,10 @@ bool Container::TakeItemNr(TYPE_OF_CONTAINERSLOTS nr, Item &item, Container *&cc
         item = selectedItem;
 
         if (item.isContainer()) {
-            items.erase(nr);
-            auto iterat = containers.find(nr);
+            cc = detachContainer(nr);
+            eraseSlot(it);
 
-            if (iterat != containers.end()) {
-                cc = (*iterat).second;
-                containers.erase(iterat);
-            } else {
+            if (!cc) {
                 cc = new Container(item.getId());
             }
 
@@ -239,27 +241,31 @@ bool Container::TakeItemNr(TYPE_OF_CONTAINERSLOTS nr, Item &item, Container *&cc
 
         } else {
             cc = nullptr;
+            const auto oldWeight = itemWeight(selectedItem);
 
             if (isItemStackable(item) && count > 1) {
                 if (selectedItem.getNumber() > count) {
                     selectedItem.setNumber(selectedItem.getNumber() - count);
                     item.setNumber(count);
+                    changeWeight(int64_t(itemWeight(selectedItem)) - oldWeight);
+                    touch();
                 } else {
-                    items.erase(nr);
+                    eraseSlot(it);
                 }
             } else {
                 if (selectedItem.getNumber() > 1) {
                     selectedItem.setNumber(selectedItem.getNumber() - 1);
                     item.setNumber(1);
+                    changeWeight(int64_t(itemWeight(selectedItem)) - oldWeight);
+                    touch();
                 } else {
-                    items.erase(nr);
+                    eraseSlot(it);
                 }
             }
         }
 
         return true;
     } else {
-        items.erase(nr);
         cc = nullptr;
         return false;
     }
@@ -382,7 +388,6 @@ bool Container::viewItemNr(TYPE_OF_CONTAINERSLOTS nr, ScriptItem &item, Containe
 
         return true;
     } else {
-        items.erase(nr);
         cc = nullptr;
         return false;
     }
@@ -401,16 +406,21 @@ int Container::increaseAtPos(unsigned char pos, int count) {
             temp = item.getNumber() + count;
 
             auto maxStack = item.getMaxStack();
+            const auto oldWeight = itemWeight(item);
 
             if (temp > maxStack) {
                 item.setNumber(maxStack);
                 temp = temp - maxStack;
+                changeWeight(int64_t(itemWeight(item)) - oldWeight);
+                touch();
             } else if (temp <= 0) {
                 temp = count + item.getNumber();
-                items.erase(pos);
+                eraseSlot(it);
             } else {
                 item.setNumber(temp);
                 temp = 0;
+                changeWeight(int64_t(itemWeight(item)) - oldWeight);
+                touch();
             }
         }
     }
@@ -423,7 +433,10 @@ bool Container::changeItem(ScriptItem &item) {
 
     if (it != items.end()) {
         if (!it->second.isContainer()) {
+            const auto oldWeight = itemWeight(it->second);
             it->second = item;
+            changeWeight(int64_t(itemWeight(it->second)) - oldWeight);
+            touch();
             return true;
         }
     }
@@ -438,12 +451,15 @@ bool Container::swapAtPos(unsigned char pos, Item::id_type newid, Item::quality_
         Item &item = it->second;
 
         if (!item.isContainer()) {
+            const auto oldWeight = itemWeight(item);
             item.setId(newid);
+            changeWeight(int64_t(itemWeight(item)) - oldWeight);
 
             if (newQuality > 0) {
                 item.setQuality(newQuality);
             }
 
+            touch();
             return true;
         }
     }
@@ -451,7 +467,7 @@ bool Container::swapAtPos(unsigned char pos, Item::id_type newid, Item::quality_
     return false;
 }
 
-void Container::Save(std::ofstream &where) {
+void Container::Save(std::ostream &where) {
     MAXCOUNTTYPE size = items.size();
     where.write((char *) & size, sizeof(size));
 
@@ -474,17 +490,7 @@ void Container::Save(std::ofstream &where) {
 }
 
 void Container::Load(std::istream &where) {
-
-    if (!containers.empty()) {
-
-        for (auto it = containers.begin(); it != containers.end(); ++it) {
-            delete it->second;
-            it->second = nullptr;
-        }
-    }
-
-    items.clear();
-    containers.clear();
+    clearSlots();
 
     MAXCOUNTTYPE size;
     where.read((char *) & size, sizeof(size));
@@ -531,7 +537,19 @@ int Container::countItem(Item::id_type itemid, script_data_exchangemap const *da
 }
 
 int Container::weight() {
-    return recursiveWeight(0);
+    if (weightGeneration != Data::getTableGeneration()) {
+        recalculateWeight(0);
+    }
+
+#ifdef Container_DEBUG
+    const int expected = recursiveWeight(0);
+
+    if (expected != int(cappedWeight())) {
+        Logger::error(LogFacility::Other) << "container " << itemId << " keeps weight " << cappedWeight() << " instead of " << expected << Log::end;
+    }
+#endif
+
+    return cappedWeight();
 }
 
 int Container::recursiveWeight(int rekt) {
@@ -589,10 +607,13 @@ int Container::eraseItem(Item::id_type itemid, Item::number_type count, script_d
 
             if (temp >= item.getNumber()) {
                 temp = temp - item.getNumber();
-                it = items.erase(it);
+                it = eraseSlot(it);
 
             } else {
+                const auto oldWeight = itemWeight(item);
                 item.setNumber(item.getNumber() - temp);
+                changeWeight(int64_t(itemWeight(item)) - oldWeight);
+                touch();
                 temp = 0;
                 ++it;
             }
@@ -606,6 +627,9 @@ int Container::eraseItem(Item::id_type itemid, Item::number_type count, script_d
 
 void Container::doAge(bool inventory) {
     if (!items.empty()) {
+        // ageing wears down every item
+        touch();
+
         auto it = items.begin();
 
         while (it != items.end()) {
@@ -616,7 +640,9 @@ void Container::doAge(bool inventory) {
             if (!inventory || (inventory && tempCommon.rotsInInventory)) {
                 if (!item.survivesAgeing()) {
                     if (item.getId() != tempCommon.ObjectAfterRot) {
+                        const auto oldWeight = itemWeight(item);
                         item.setId(tempCommon.ObjectAfterRot);
+                        changeWeight(int64_t(itemWeight(item)) - oldWeight);
 
                         const auto &afterRotCommon = Data::CommonItems[tempCommon.ObjectAfterRot];
 
@@ -628,14 +654,10 @@ void Container::doAge(bool inventory) {
                     } else {
 
                         if (item.isContainer()) {
-                            auto iterat = containers.find(it->first);
-
-                            if (iterat != containers.end()) {
-                                containers.erase(iterat);
-                            }
+                            detachContainer(it->first);
                         }
 
-                        it = items.erase(it);
+                        it = eraseSlot(it);
                     }
                 } else {
                     ++it;
@@ -655,6 +677,8 @@ void Container::doAge(bool inventory) {
 }
 
 void Container::resetWear() {
+    touch();
+
     for (auto &item : items) {
         item.second.resetWear();
     }
@@ -678,7 +702,7 @@ void Container::insertIntoFirstFreeSlot(Item &item) {
     TYPE_OF_CONTAINERSLOTS slotCount = getSlotCount();
 
     if (freeSlot < slotCount) {
-        items.insert(ITEMMAP::value_type(freeSlot, item));
+        insertSlot(freeSlot, item);
         World::get()->sendContainerSlotChange(this, freeSlot);
     }
 }
@@ -688,19 +712,171 @@ void Container::insertIntoFirstFreeSlot(Item &item, Container *container) {
     TYPE_OF_CONTAINERSLOTS slotCount = getSlotCount();
 
     if (freeSlot < slotCount) {
-        items.insert(ITEMMAP::value_type(freeSlot, item));
-        containers.insert(CONTAINERMAP::value_type(freeSlot, container));
+        insertSlot(freeSlot, item, container);
         World::get()->sendContainerSlotChange(this, freeSlot);
     }
 }
 
 TYPE_OF_CONTAINERSLOTS Container::getFirstFreeSlot() const {
-    TYPE_OF_CONTAINERSLOTS slotCount = getSlotCount();
-    TYPE_OF_CONTAINERSLOTS i = 0;
+    const size_t slotCount = getSlotCount();
+    size_t freeSlot = occupiedSlots.size() * 64;
+
+    for (size_t word = 0; word < occupiedSlots.size(); ++word) {
+        if (~occupiedSlots[word] != 0) {
+            freeSlot = word * 64 + __builtin_ctzll(~occupiedSlots[word]);
+            break;
+        }
+    }
+
+    freeSlot = std::min(freeSlot, slotCount);
+
+#ifdef Container_DEBUG
+    size_t expected = 0;
+
+    while (expected < slotCount && items.find(expected) != items.end()) {
+        ++expected;
+    }
+
+    if (expected != freeSlot) {
+        Logger::error(LogFacility::Other) << "container " << itemId << " finds free slot " << freeSlot << " instead of " << expected << Log::end;
+    }
+#endif
+
+    return freeSlot;
+}
+
+uint32_t Container::itemWeight(const Item &item) {
+    const auto &common = Data::CommonItems[item.getId()];
+
+    if (item.isContainer()) {
+        return common.Weight;
+    }
+
+    return common.Weight * item.getNumber();
+}
+
+uint32_t Container::cappedWeight() const {
+    return std::min(totalWeight, MAXIMALWEIGHT);
+}
 
-    while (i < slotCount && items.find(i) != items.end()) {
-        ++i;
+void Container::changeWeight(int64_t delta) {
+    if (delta == 0) {
+        return;
     }
 
-    return i;
+    const uint32_t oldWeight = cappedWeight();
+    totalWeight = std::max<int64_t>(0, totalWeight + delta);
+
+    if (parent) {
+        parent->changeWeight(int64_t(cappedWeight()) - oldWeight);
+    }
+}
+
+void Container::recalculateWeight(int rekt) {
+    if (rekt > MAXIMALEREKURSIONSTIEFE) {
+        throw RekursionException();
+    }
+
+    totalWeight = 0;
+
+    for (const auto &slot : items) {
+        totalWeight += itemWeight(slot.second);
+    }
+
+    for (const auto &container : containers) {
+        container.second->recalculateWeight(rekt + 1);
+        totalWeight += container.second->cappedWeight();
+    }
+
+    weightGeneration = Data::getTableGeneration();
+}
+
+void Container::insertSlot(TYPE_OF_CONTAINERSLOTS slot, const Item &item, Container *container) {
+    if (!items.insert(ITEMMAP::value_type(slot, item)).second) {
+        return;
+    }
+
+    markSlot(slot, true);
+    int64_t delta = itemWeight(item);
+
+    if (container) {
+        containers.insert(CONTAINERMAP::value_type(slot, container));
+        container->parent = this;
+
+        try {
+            // brings the weight up to date if tables were reloaded meanwhile
+            container->weight();
+        } catch (RekursionException &e) {
+            // nested too deep, reading the weight will throw again
+        }
+
+        delta += container->cappedWeight();
+    }
+
+    changeWeight(delta);
+    touch();
+}
+
+Container::ITEMMAP::iterator Container::eraseSlot(ITEMMAP::iterator it) {
+    changeWeight(-int64_t(itemWeight(it->second)));
+    markSlot(it->first, false);
+    touch();
+    return items.erase(it);
+}
+
+Container *Container::detachContainer(TYPE_OF_CONTAINERSLOTS slot) {
+    auto it = containers.find(slot);
+
+    if (it == containers.end()) {
+        return nullptr;
+    }
+
+    Container *container = it->second;
+    containers.erase(it);
+    container->parent = nullptr;
+    changeWeight(-int64_t(container->cappedWeight()));
+    touch();
+    return container;
+}
+
+void Container::touch() const {
+    if (touchLog) {
+        const Container *outermost = this;
+
+        while (outermost->parent) {
+            outermost = outermost->parent;
+        }
+
+        touchLog->push_back(outermost);
+    }
+}
+
+void Container::markSlot(TYPE_OF_CONTAINERSLOTS slot, bool occupied) {
+    const size_t word = slot / 64;
+    const uint64_t bit = uint64_t(1) << (slot % 64);
+
+    if (word >= occupiedSlots.size()) {
+        if (!occupied) {
+            return;
+        }
+
+        occupiedSlots.resize(word + 1, 0);
+    }
+
+    if (occupied) {
+        occupiedSlots[word] |= bit;
+    } else {
+        occupiedSlots[word] &= ~bit;
+    }
+}
+
+void Container::clearSlots() {
+    for (auto &container : containers) {
+        delete container.second;
+    }
+
+    containers.clear();
+    items.clear();
+    occupiedSlots.clear();
+    changeWeight(-int64_t(totalWeight));
 }
@@ -27,6 +27,7 @@
 #include "TableStructs.hpp"
 
 #include <unordered_map>
+#include <vector>
 #include <iostream>
 #include <fstream>
 
@@ -47,6 +48,22 @@ private:
     ITEMMAP items;
     CONTAINERMAP containers;
 
+    // the container this one lies in, nullptr at the top
+    Container *parent = nullptr;
+
+    // weight of all items, nested containers capped at MAXIMALWEIGHT each,
+    // kept up to date on every change and passed on to the parent
+    uint32_t totalWeight = 0;
+    uint32_t weightGeneration;
+
+    // one bit per slot, set if it holds an item
+    std::vector<uint64_t> occupiedSlots;
+
+    static const uint32_t MAXIMALWEIGHT = 30000;
+
+    // per thread, player workers build inventories and depots concurrently
+    static thread_local std::vector<const Container *> *touchLog;
+
 public:
     Container(Item::id_type itemId);
     Container(const Container &source);
@@ -63,7 +80,7 @@ public:
     bool InsertItem(Item it, TYPE_OF_CONTAINERSLOTS);
     bool InsertItem(Item it);
 
-    void Save(std::ofstream &where);
+    void Save(std::ostream &where);
     void Load(std::istream &where);
 
     void doAge(bool inventory = false);
@@ -86,6 +103,7 @@ public:
 
     bool changeItem(ScriptItem &it);
 
+    // weight of all contents, Container_DEBUG checks it against a full recalculation
     int weight();
 
     virtual TYPE_OF_CONTAINERSLOTS getSlotCount() const;
@@ -99,11 +117,32 @@ public:
 
     TYPE_OF_CONTAINERSLOTS getFirstFreeSlot() const;
 
+    /**
+    * while set, every change of a container made by the calling thread
+    * appends the outermost container holding it to the log, pass nullptr to
+    * stop logging
+    */
+    static void setTouchLog(std::vector<const Container *> *log) {
+        touchLog = log;
+    }
+
 private:
+    void touch() const;
     bool isItemStackable(Item item);
     void insertIntoFirstFreeSlot(Item &item);
     void insertIntoFirstFreeSlot(Item &item, Container *container);
     int recursiveWeight(int rekt);
+
+    static uint32_t itemWeight(const Item &item);
+    uint32_t cappedWeight() const;
+    void changeWeight(int64_t delta);
+    void recalculateWeight(int rekt);
+
+    void insertSlot(TYPE_OF_CONTAINERSLOTS slot, const Item &item, Container *container = nullptr);
+    ITEMMAP::iterator eraseSlot(ITEMMAP::iterator it);
+    Container *detachContainer(TYPE_OF_CONTAINERSLOTS slot);
+    void markSlot(TYPE_OF_CONTAINERSLOTS slot, bool occupied);
+    void clearSlots();
 };
 
 #endif
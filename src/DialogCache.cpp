@@ -0,0 +1,56 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+#include "DialogCache.hpp"
+#include "Statistics.hpp"
+
+namespace {
+
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+}
+
+const uint64_t DialogHasher::FNV_PRIME;
+
+DialogHasher::DialogHasher(unsigned char command) : hash((FNV_OFFSET ^ command) * FNV_PRIME) {
+}
+
+const size_t DialogCache::MAX_DIALOGS;
+
+void DialogCache::add(uint64_t hash, const std::shared_ptr<const EncodedDialog> &encoded) {
+    using Statistic::Statistics;
+    static const int misses = Statistics::getInstance().counterId("dialog cache misses");
+    Statistics::getInstance().increment(misses);
+
+    if (dialogs.size() >= MAX_DIALOGS) {
+        dialogs.clear();
+    }
+
+    dialogs[hash] = encoded;
+}
+
+void DialogCache::countHit(size_t bytes) {
+    using Statistic::Statistics;
+    static const int hits = Statistics::getInstance().counterId("dialog cache hits");
+    static const int bytesReused = Statistics::getInstance().counterId("dialog cache bytes reused");
+    Statistics::getInstance().increment(hits);
+    Statistics::getInstance().increment(bytesReused, bytes);
+}
@@ -0,0 +1,252 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+#ifndef _DIALOG_CACHE_HPP_
+#define _DIALOG_CACHE_HPP_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <string.h>
+
+/**
+* the body of an encoded dialog command, everything after the header up to
+* the dialog id, which is different for every player
+*/
+struct EncodedDialog {
+    std::string body;
+    uint32_t checkSum = 0;
+};
+
+/**
+* takes the place of a server command when encoding a dialog, writing the
+* data byte by byte in the encoding of BasicServerCommand
+*
+* Sink needs addUnsignedCharToBuffer(unsigned char) and
+* addBytesToBuffer(const char *, size_t), the latter takes strings in one go.
+*/
+template<class Sink>
+class DialogWriter {
+public:
+    void addStringToBuffer(const std::string &data) {
+        unsigned short int count = data.length();
+        sink().addShortIntToBuffer(count);
+        sink().addBytesToBuffer(data.data(), count);
+    }
+
+    void addIntToBuffer(int data) {
+        sink().addUnsignedCharToBuffer(data >> 24);
+        sink().addUnsignedCharToBuffer((data >> 16) & 255);
+        sink().addUnsignedCharToBuffer((data >> 8) & 255);
+        sink().addUnsignedCharToBuffer(data & 255);
+    }
+
+    void addShortIntToBuffer(short int data) {
+        sink().addUnsignedCharToBuffer(data >> 8);
+        sink().addUnsignedCharToBuffer(data & 255);
+    }
+
+private:
+    Sink &sink() {
+        return static_cast<Sink &>(*this);
+    }
+};
+
+/**
+* only hashes the data of a dialog
+*
+* FNV-1a over whole values and words instead of bytes, the hash only has to
+* be stable within a run and the length is counted in bytes as encoded.
+*/
+class DialogHasher : public DialogWriter<DialogHasher> {
+public:
+    explicit DialogHasher(unsigned char command);
+
+    void addIntToBuffer(int data) {
+        mix(static_cast<uint32_t>(data));
+        length += 4;
+    }
+
+    void addShortIntToBuffer(short int data) {
+        mix(static_cast<uint16_t>(data));
+        length += 2;
+    }
+
+    void addUnsignedCharToBuffer(unsigned char data) {
+        mix(data);
+        ++length;
+    }
+
+    void addBytesToBuffer(const char *data, size_t count) {
+        size_t i = 0;
+
+        for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            mix(word);
+        }
+
+        if (i < count) {
+            uint64_t word = 0;
+            memcpy(&word, data + i, count - i);
+            mix(word);
+        }
+
+        length += count;
+    }
+
+    uint64_t getHash() const {
+        return hash;
+    }
+
+    size_t getLength() const {
+        return length;
+    }
+
+private:
+    static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+    void mix(uint64_t value) {
+        hash = (hash ^ value) * FNV_PRIME;
+    }
+
+    uint64_t hash;
+    size_t length = 0;
+};
+
+/**
+* writes the data of a dialog into an EncodedDialog
+*/
+class DialogEncoder : public DialogWriter<DialogEncoder> {
+public:
+    explicit DialogEncoder(EncodedDialog &encoded) : encoded(encoded) {}
+
+    void addUnsignedCharToBuffer(unsigned char data) {
+        encoded.body.push_back(data);
+        encoded.checkSum += data;
+    }
+
+    void addBytesToBuffer(const char *data, size_t count) {
+        encoded.body.append(data, count);
+
+        for (size_t i = 0; i < count; ++i) {
+            encoded.checkSum += static_cast<unsigned char>(data[i]);
+        }
+    }
+
+private:
+    EncodedDialog &encoded;
+};
+
+/**
+* compares the data of a dialog with a body encoded before
+*/
+class DialogMatcher : public DialogWriter<DialogMatcher> {
+public:
+    explicit DialogMatcher(const std::string &body) : body(body) {}
+
+    void addUnsignedCharToBuffer(unsigned char data) {
+        if (position < body.size() && static_cast<unsigned char>(body[position]) == data) {
+            ++position;
+        } else {
+            equal = false;
+        }
+    }
+
+    void addBytesToBuffer(const char *data, size_t count) {
+        if (equal && count <= body.size() - position && body.compare(position, count, data, count) == 0) {
+            position += count;
+        } else {
+            equal = false;
+        }
+    }
+
+    bool matches() const {
+        return equal && position == body.size();
+    }
+
+private:
+    const std::string &body;
+    size_t position = 0;
+    bool equal = true;
+};
+
+/**
+* caches encoded dialogs by their content, so NPCs offering the same
+* catalogue to every customer encode it only once
+*
+* A dialog command type used with the cache needs a static
+* encode(Writer &, const DialogType &) writing everything but the dialog id.
+* Entries are found by a 64 bit hash of the encoded body and compared byte
+* by byte on a hit, a colliding dialog replaces the cached one.
+* Not thread-safe, only to be used from the main thread.
+*/
+class DialogCache {
+public:
+    /**
+    * returns the encoded body of a dialog, encoding it if no dialog with the
+    * same content has been encoded before
+    * @param command the definition byte of the dialog command
+    * @param dialog the dialog to be encoded
+    */
+    template<class DialogCommandType, class DialogType>
+    std::shared_ptr<const EncodedDialog> get(unsigned char command, const DialogType &dialog) {
+        DialogHasher hasher(command);
+        DialogCommandType::encode(hasher, dialog);
+
+        const auto it = dialogs.find(hasher.getHash());
+
+        if (it != dialogs.end() && it->second->body.size() == hasher.getLength()) {
+            DialogMatcher matcher(it->second->body);
+            DialogCommandType::encode(matcher, dialog);
+
+            if (matcher.matches()) {
+                countHit(it->second->body.size());
+                return it->second;
+            }
+        }
+
+        auto encoded = std::make_shared<EncodedDialog>();
+        DialogEncoder encoder(*encoded);
+        DialogCommandType::encode(encoder, dialog);
+        add(hasher.getHash(), encoded);
+        return encoded;
+    }
+
+    void clear() {
+        dialogs.clear();
+    }
+
+    size_t size() const {
+        return dialogs.size();
+    }
+
+private:
+    static const size_t MAX_DIALOGS = 1000;
+
+    void add(uint64_t hash, const std::shared_ptr<const EncodedDialog> &encoded);
+    static void countHit(size_t bytes);
+
+    std::unordered_map<uint64_t, std::shared_ptr<const EncodedDialog>> dialogs;
+};
+
+#endif
@@ -25,15 +25,28 @@
 
 //#define Field_DEBUG
 
+uint32_t Field::changeCounter = 0;
+std::vector<const Field *> *Field::touchLog = nullptr;
+
 Field::Field() : warptarget{0, 0, 0} {
     tile = 0;
     music = 0;
     clientflags = 0;
     extraflags = 0;
+    touch();
+}
+
+void Field::touch() {
+    changeStamp = ++changeCounter;
+
+    if (touchLog) {
+        touchLog->push_back(this);
+    }
 }
 
 void Field::setTileId(unsigned short int id) {
     tile = id;
+    touch();
 }
 
 unsigned short int Field::getTileCode() const {
@@ -58,6 +71,7 @@ unsigned short int Field::getSecondaryTileId() const {
 
 void Field::setMusicId(unsigned short int id) {
     music = id;
+    touch();
 }
 
 unsigned short int Field::getMusicId() const {
@@ -113,6 +127,7 @@ bool Field::addTopItem(const Item &it) {
     if (IsPassable()) {
         if (items.size() < MAXITEMS) {
             items.push_back(it);
+            touch();
 
             if (Data::TilesModItems.exists(it.getId())) {
                 const auto &temp = Data::TilesModItems[it.getId()];
@@ -138,6 +153,8 @@ bool Field::PutGroundItem(const Item &it) {
             items.insert(iterat, it);
         }
 
+        touch();
+
         if (Data::TilesModItems.exists(it.getId())) {
             const auto &temp = Data::TilesModItems[it.getId()];
             clientflags   = clientflags | (temp.Modificator & (FLAG_GROUNDLEVEL));
@@ -154,6 +171,7 @@ bool Field::PutGroundItem(const Item &it) {
 bool Field::PutTopItem(const Item &it) {
     if (items.size() < MAXITEMS) {
         items.push_back(it);
+        touch();
 
         if (Data::TilesModItems.exists(it.getId())) {
             const auto &temp = Data::TilesModItems[it.getId()];
@@ -175,6 +193,7 @@ bool Field::TakeTopItem(Item &it) {
 
     it = items.back();
     items.pop_back();
+    touch();
     updateFlags();
 
     return true;
@@ -345,6 +364,8 @@ void Field::Load(std::istream &mapt, std::istream &obj, std::istream &warp) {
         items.push_back(temp);
     }
 
+    touch();
+
     char iswarp = 0;
     warp.read((char *) & iswarp, sizeof(iswarp));
 
@@ -404,6 +425,10 @@ int8_t Field::DoAgeItems() {
         }
     }
 
+    if (ret != 0) {
+        touch();
+    }
+
     updateFlags();
 
     return ret;
@@ -434,6 +459,7 @@ void Field::updateFlags() {
 
 void Field::DeleteAllItems() {
     items.clear();
+    touch();
     updateFlags();
 }
 
@@ -503,11 +529,13 @@ bool Field::IsWarpField() const {
 void Field::SetWarpField(const position &pos) {
     warptarget = pos;
     extraflags = extraflags | FLAG_WARPFIELD;
+    touch();
 }
 
 
 void Field::UnsetWarpField() {
     extraflags = extraflags & (255 - FLAG_WARPFIELD);
+    touch();
 }
 
 
@@ -42,6 +42,14 @@ private:
     unsigned char clientflags;
     unsigned char extraflags;
     position warptarget;
+    uint32_t changeStamp;
+
+    static uint32_t changeCounter;
+    static std::vector<const Field *> *touchLog;
+
+    // marks a change of data which is sent to clients in map stripes and
+    // recorded in the map journal
+    void touch();
 
 public:
     void setTileId(unsigned short int id);
@@ -51,6 +59,30 @@ public:
 
     Field();
 
+    /**
+    * the value of the global change counter when tile, music, flags or items
+    * of this field were last changed
+    */
+    uint32_t getChangeStamp() const {
+        return changeStamp;
+    }
+
+    /**
+    * the current value of the global change counter, every field change
+    * increases it by one
+    */
+    static uint32_t getChangeCounter() {
+        return changeCounter;
+    }
+
+    /**
+    * while set, every field change appends the changed field to the log,
+    * pass nullptr to stop logging
+    */
+    static void setTouchLog(std::vector<const Field *> *log) {
+        touchLog = log;
+    }
+
     void Save(std::ostream &mapt, std::ostream &obj, std::ostream &warp);
 
     TYPE_OF_WALKINGCOST getMovementCost() const;
@@ -19,25 +19,22 @@
 
 #include "InitialConnection.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <thread>
 
 #include "make_unique.hpp"
 #include "Config.hpp"
 #include "Logger.hpp"
+#include "MetricsEndpoint.hpp"
 
 #include "netinterface/NetInterface.hpp"
 
-InitialConnection::InitialConnection() {
+InitialConnection::InitialConnection(const NetInterface::LoginHandler &loginHandler) : loginHandler(loginHandler) {
     std::thread servicethread(std::bind(&InitialConnection::run_service,this));
     servicethread.detach();
 }
 
-
-InitialConnection::TVECTORPLAYER &InitialConnection::get_Player_Vector() {
-    return playerVector;
-}
-
 void InitialConnection::run_service() {
     int port = Config::instance().port;
 
@@ -46,16 +43,35 @@ void InitialConnection::run_service() {
     auto newConnection = std::make_shared<NetInterface>(io_service);
     using std::placeholders::_1;
     acceptor->async_accept(newConnection->getSocket(), std::bind(&InitialConnection::accept_connection, this, newConnection, _1));
-    Logger::info(LogFacility::Other) << "Starting the IO Service!" << Log::end;
+
+    const uint16_t metricsPort = Config::instance().metrics_port;
+
+    if (metricsPort != 0) {
+        try {
+            metrics = std::make_unique<MetricsEndpoint>(io_service, metricsPort);
+        } catch (boost::system::system_error &e) {
+            Logger::error(LogFacility::Other) << "Could not serve metrics on port " << metricsPort << ": " << e.what() << Log::end;
+        }
+    }
+
+    // connections are served on their own strands, so any thread may run them
+    const uint16_t threads = std::max<uint16_t>(1, Config::instance().network_threads);
+
+    for (uint16_t i = 1; i < threads; ++i) {
+        std::thread ioThread([this] { io_service.run(); });
+        ioThread.detach();
+    }
+
+    Logger::info(LogFacility::Other) << "Starting the IO Service with " << threads << " threads!" << Log::end;
     io_service.run();
 }
 
 //CInternetConnection* InitialConnection::accept_connection() {
 void InitialConnection::accept_connection(std::shared_ptr<NetInterface> connection, const boost::system::error_code &error) {
     if (!error) {
-        if (connection->activate()) {
-            playerVector.push_back(connection);
-        } else {
+        connection->awaitLogin(loginHandler, Config::instance().login_timeout);
+
+        if (!connection->activate()) {
             Logger::error(LogFacility::Other) << "Error while activating connection!" << Log::end;
         }
 
@@ -27,10 +27,10 @@
 
 #include <boost/asio.hpp>
 
-#include "thread_safe_vector.hpp"
 #include "Connection.hpp"
+#include "netinterface/NetInterface.hpp"
 
-class NetInterface;
+class MetricsEndpoint;
 
 //! die maximal Anzahl von noch nicht bearbeiteten Verbindungen in der Warteschlange
 #define BACKLOG 10
@@ -44,19 +44,13 @@ class InitialConnection : public Connection {
 public:
 
 
-    typedef thread_safe_vector<std::shared_ptr<NetInterface>> TVECTORPLAYER;
-
     //! Konstruktor
-    InitialConnection();
+    // \param loginHandler receives each new connection once it sent its login
+    explicit InitialConnection(const NetInterface::LoginHandler &loginHandler);
 
     //! Destruktor
     ~InitialConnection();
 
-    //! liefert alle neu erstellten Player zur�ck
-    // \return f�r die angemeldeten Clients mit richtiger Clientversion
-    // einen Player mit player.name und player.pw, entsprechend der gesendeten Daten
-    // besetzt
-    TVECTORPLAYER &get_Player_Vector();
 
 private:
 
@@ -64,6 +58,7 @@ private:
 
     boost::asio::io_service io_service;
     std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor = nullptr;
+    std::unique_ptr<MetricsEndpoint> metrics;
 
 
     //! wartet auf eine neue Verbindung (blockierend)
@@ -71,8 +66,7 @@ private:
     //CInternetConnection* accept_connection();
     void accept_connection(std::shared_ptr<NetInterface> connection, const boost::system::error_code &error);
 
-    //! std::vector for new players...
-    TVECTORPLAYER playerVector;
+    NetInterface::LoginHandler loginHandler;
 };
 
 #endif
@@ -22,6 +22,11 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <ctime>
 
 LogType<LogPriority::EMERGENCY>::type Logger::emergency;
 LogType<LogPriority::ALERT>::type Logger::alert;
@@ -32,6 +37,192 @@ LogType<LogPriority::NOTICE>::type Logger::notice;
 LogType<LogPriority::INFO>::type Logger::info;
 LogType<LogPriority::DEBUG>::type Logger::debug;
 
-void log_message(LogPriority priority, LogFacility facility, const std::string &message) {
+namespace {
+
+void write_syslog(LogPriority priority, LogFacility facility, const std::string &message) {
     syslog(static_cast<int>(priority) | static_cast<int>(facility), "%s", message.c_str());
 }
+
+/**
+* bounded multi-producer single-consumer ring of log messages, emptied in
+* batches by a dedicated writer thread
+*
+* Producers never block: if the ring is full the message is dropped and
+* counted, the writer reports the number of dropped messages later on.
+*/
+class LogWriter {
+public:
+    ~LogWriter() {
+        stop();
+    }
+
+    bool start(const std::string &logfile) {
+        if (running) {
+            return true;
+        }
+
+        if (logfile != "syslog") {
+            file.open(logfile, std::ios::app);
+
+            if (!file.is_open()) {
+                return false;
+            }
+        }
+
+        if (!ring) {
+            ring.reset(new Entry[CAPACITY]);
+
+            for (size_t i = 0; i < CAPACITY; ++i) {
+                ring[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        stopping = false;
+        writer = std::thread(&LogWriter::run, this);
+        running.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void stop() {
+        if (!running) {
+            return;
+        }
+
+        running.store(false, std::memory_order_release);
+        stopping = true;
+        writer.join();
+
+        // catch messages pushed while the writer was shutting down
+        writeBatch();
+
+        if (file.is_open()) {
+            file.close();
+        }
+    }
+
+    bool isRunning() const {
+        return running.load(std::memory_order_acquire);
+    }
+
+    void push(LogPriority priority, LogFacility facility, std::string &&message) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Entry *entry;
+
+        for (;;) {
+            entry = &ring[pos & (CAPACITY - 1)];
+            const size_t sequence = entry->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (difference == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        entry->priority = priority;
+        entry->facility = facility;
+        entry->message = std::move(message);
+        entry->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+private:
+    struct Entry {
+        std::atomic<size_t> sequence;
+        LogPriority priority;
+        LogFacility facility;
+        std::string message;
+    };
+
+    // has to be a power of two
+    static const size_t CAPACITY = 8192;
+    static const size_t MAX_BATCH = 1024;
+
+    void run() {
+        while (!stopping) {
+            if (writeBatch() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+        while (writeBatch() > 0);
+    }
+
+    size_t writeBatch() {
+        size_t written = 0;
+
+        while (written < MAX_BATCH) {
+            Entry &entry = ring[dequeuePos & (CAPACITY - 1)];
+
+            if (entry.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+                break;
+            }
+
+            write(entry.priority, entry.facility, entry.message);
+            entry.message.clear();
+            entry.sequence.store(dequeuePos + CAPACITY, std::memory_order_release);
+            ++dequeuePos;
+            ++written;
+        }
+
+        const size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+
+        if (lost > 0) {
+            write(LogPriority::WARNING, LogFacility::Other, std::to_string(lost) + " log messages dropped, the log writer could not keep up");
+        }
+
+        if (written > 0 && file.is_open()) {
+            file.flush();
+        }
+
+        return written;
+    }
+
+    void write(LogPriority priority, LogFacility facility, const std::string &message) {
+        if (!file.is_open()) {
+            write_syslog(priority, facility, message);
+            return;
+        }
+
+        const time_t now = time(nullptr);
+        tm local;
+        localtime_r(&now, &local);
+        char timestamp[32];
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local);
+        file << timestamp << " <" << static_cast<int>(priority) << "> " << message << '\n';
+    }
+
+    std::unique_ptr<Entry[]> ring;
+    std::atomic<size_t> enqueuePos{0};
+    size_t dequeuePos = 0;
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+    std::ofstream file;
+};
+
+LogWriter logWriter;
+
+}
+
+void log_message(LogPriority priority, LogFacility facility, std::string message) {
+    if (logWriter.isRunning()) {
+        logWriter.push(priority, facility, std::move(message));
+    } else {
+        write_syslog(priority, facility, message);
+    }
+}
+
+bool start_log_writer(const std::string &logfile) {
+    return logWriter.start(logfile);
+}
+
+void stop_log_writer() {
+    logWriter.stop();
+}
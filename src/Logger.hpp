@@ -54,7 +54,25 @@ enum class LogPriority {
     DEBUG = LOG_DEBUG
 };
 
-void log_message(LogPriority priority, LogFacility facility, const std::string &message);
+/**
+* hands a message to the log writer thread, or writes it directly if the
+* writer is not running; messages are dropped and counted if the writer
+* cannot keep up
+*/
+void log_message(LogPriority priority, LogFacility facility, std::string message);
+
+/**
+* starts the thread writing queued messages in batches
+* @param logfile file to append messages to, "syslog" to write to syslog
+* @return false if the log file could not be opened
+*/
+bool start_log_writer(const std::string &logfile);
+
+/**
+* writes all queued messages and stops the writer thread, messages are
+* written directly afterwards
+*/
+void stop_log_writer();
 
 namespace Log {
 class end_t {
@@ -79,7 +97,7 @@ template<LogPriority priority>
 class LogStream {
 public:
     inline LogStream &operator()(LogFacility facility) {
-        _facility = facility;
+        buffer().facility = facility;
         return *this;
     }
 
@@ -87,19 +105,28 @@ public:
     template<typename T>
     inline LogStream &operator<<(const T &data) {
         static_assert(!std::is_pointer<T>::value || std::is_same<T, const char *>::value || std::is_same<T, char *>::value, "Logger cannot log pointers!");
-        _ss << data;
+        buffer().ss << data;
         return *this;
     }
 
     LogStream &operator<<(const Log::end_t &) {
-        log_message(priority, _facility, _ss.str());
-        _ss.str( {});
+        Buffer &buf = buffer();
+        log_message(priority, buf.facility, buf.ss.str());
+        buf.ss.str( {});
         return *this;
     }
 
 private:
-    std::stringstream _ss;
-    LogFacility _facility;
+    // the streams are shared by all threads, so each thread formats into its own buffer
+    struct Buffer {
+        std::stringstream ss;
+        LogFacility facility = LogFacility::Other;
+    };
+
+    static Buffer &buffer() {
+        static thread_local Buffer threadBuffer;
+        return threadBuffer;
+    }
 };
 
 template<LogPriority priority>
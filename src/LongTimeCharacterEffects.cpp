@@ -33,8 +33,36 @@
 
 #include "LongTimeEffect.hpp"
 #include "Player.hpp"
+#include "World.hpp"
 
-LongTimeCharacterEffects::LongTimeCharacterEffects(Character *owner) : owner(owner), time(0) {
+LongTimeCharacterEffects::LongTimeCharacterEffects(Character *owner) : owner(owner) {
+}
+
+LongTimeCharacterEffects::~LongTimeCharacterEffects() {
+    for (const auto &effect : effects) {
+        delete effect;
+    }
+}
+
+int32_t LongTimeCharacterEffects::now() {
+    return World::get()->effectWheel.getTime();
+}
+
+void LongTimeCharacterEffects::schedule() {
+    if (effects.empty()) {
+        return;
+    }
+
+    const int32_t due = effects.front()->getExecutionTime();
+
+    // an earlier entry is still in the wheel, it will schedule the rest
+    if (scheduled && scheduledAt <= due) {
+        return;
+    }
+
+    scheduled = true;
+    scheduledAt = due;
+    World::get()->effectWheel.schedule(owner->getId(), due);
 }
 
 bool LongTimeCharacterEffects::find(uint16_t effectid, LongTimeEffect *&effect) {
@@ -70,9 +98,10 @@ void LongTimeCharacterEffects::addEffect(LongTimeEffect *effect) {
     }
 
     if (!find(effect->getEffectId(), foundeffect)) {
-        effect->setExecutionTime(time);
+        effect->setExecutionTime(now());
         effects.push_back(effect);
         std::push_heap(effects.begin(), effects.end(), LongTimeEffect::priority);
+        schedule();
 
         if (effect->isFirstAdd()) {
             const auto &script = Data::LongTimeEffects.script(effect->getEffectId());
@@ -87,6 +116,10 @@ void LongTimeCharacterEffects::addEffect(LongTimeEffect *effect) {
         if (script) {
             script->doubleEffect(foundeffect, owner);
         }
+
+        // adopted from the script, but only the effect already there is kept
+        delete effect;
+        return;
     }
 
     effect->firstAdd(); //set first add for this effect
@@ -149,8 +182,23 @@ bool LongTimeCharacterEffects::removeEffect(LongTimeEffect *effect) {
     return false;
 }
 
-void LongTimeCharacterEffects::checkEffects() {
-    ++time;
+void LongTimeCharacterEffects::checkEffects(int32_t scheduledTime) {
+    // superseded by an earlier entry
+    if (!scheduled || scheduledTime != scheduledAt) {
+        return;
+    }
+
+    scheduled = false;
+    const int32_t time = now();
+
+    // dead monsters and NPCs are about to be removed or revived
+    if (owner->getType() != Character::player && !owner->isAlive()) {
+        scheduled = true;
+        scheduledAt = time + 1;
+        World::get()->effectWheel.schedule(owner->getId(), scheduledAt);
+        return;
+    }
+
     int emexit = 0;
 
     while (!effects.empty() && (emexit < 200) && (effects.front()->getExecutionTime() <= time)) {
@@ -167,8 +215,17 @@ void LongTimeCharacterEffects::checkEffects() {
             if (script) {
                 script->removeEffect(effect, owner);
             }
+
+            delete effect;
         }
     }
+
+    schedule();
+}
+
+void LongTimeCharacterEffects::leaveWorld() {
+    leftWorld = true;
+    leftWorldAt = now();
 }
 
 bool LongTimeCharacterEffects::save() {
@@ -208,6 +265,7 @@ bool LongTimeCharacterEffects::save() {
     }
 
     bool allok = true;
+    const int32_t time = leftWorld ? leftWorldAt : now();
 
     for (auto it = effects.begin(); it != effects.end(); ++it) {
         allok and_eq(*it)->save(player->getId(), time);
@@ -243,7 +301,7 @@ bool LongTimeCharacterEffects::load() {
                 uint16_t effectId = row["plte_effectid"].as<uint16_t>();
                 LongTimeEffect *effect = new LongTimeEffect(effectId, row["plte_nextcalled"].as<int32_t>());
 
-                effect->setExecutionTime(time);
+                effect->setExecutionTime(now());
                 effect->firstAdd();
                 effect->setNumberOfCalls(row["plte_numberCalled"].as<uint32_t>());
 
@@ -274,6 +332,7 @@ bool LongTimeCharacterEffects::load() {
         }
 
         std::make_heap(effects.begin(), effects.end(), LongTimeEffect::priority);
+        schedule();
 
         return true;
     } catch (std::exception &e) {
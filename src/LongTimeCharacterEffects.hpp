@@ -30,6 +30,7 @@ class Character;
 class LongTimeCharacterEffects {
 public:
     LongTimeCharacterEffects(Character *owner);
+    ~LongTimeCharacterEffects();
 
     void addEffect(LongTimeEffect *effect);
     bool find(uint16_t effectid, LongTimeEffect *&effect);
@@ -39,7 +40,19 @@ public:
     bool removeEffect(LongTimeEffect *effect);
 
     void push_backEffect(LongTimeEffect *effect);
-    void checkEffects();
+
+    /**
+    * calls all effects which are due, the world does this when the
+    * timing wheel reaches the time this owner was scheduled for
+    * @param scheduledTime the time the owner was scheduled for
+    */
+    void checkEffects(int32_t scheduledTime);
+
+    /**
+    * remembers the time the owner left the world at, save runs on a player
+    * thread later and stores the effects relative to that time
+    */
+    void leaveWorld();
     bool save();
     bool load();
 
@@ -47,9 +60,16 @@ private:
     typedef std::vector<LongTimeEffect *> EFFECTS;
     EFFECTS effects;
 
+    void schedule();
+    static int32_t now();
+
     Character *owner;
 
-    int32_t time;
+    bool scheduled = false;
+    int32_t scheduledAt = 0;
+
+    bool leftWorld = false;
+    int32_t leftWorldAt = 0;
 };
 
 #endif
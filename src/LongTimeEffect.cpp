@@ -35,6 +35,17 @@
 #include "Player.hpp"
 #include "TableStructs.hpp"
 #include "World.hpp"
+#include "ObjectPool.hpp"
+
+namespace {
+
+ObjectPool<LongTimeEffect> &effectPool() {
+    // never destroyed, effects of characters may still be released on shutdown
+    static auto *pool = new ObjectPool<LongTimeEffect>();
+    return *pool;
+}
+
+}
 
 LongTimeEffect::LongTimeEffect(uint16_t effectId, int32_t executeIn):
     effectId(effectId),
@@ -42,6 +53,14 @@ LongTimeEffect::LongTimeEffect(uint16_t effectId, int32_t executeIn):
     executeIn(executeIn) {
 }
 
+void *LongTimeEffect::operator new(size_t size) {
+    return effectPool().allocate(size);
+}
+
+void LongTimeEffect::operator delete(void *memory, size_t size) {
+    effectPool().deallocate(memory, size);
+}
+
 bool LongTimeEffect::callEffect(Character *target) {
     bool ret = false;
     const auto &script = Data::LongTimeEffects.script(effectId);
@@ -33,6 +33,9 @@ class LongTimeEffect {
 public:
     LongTimeEffect(uint16_t effectId, int32_t executeIn);
 
+    static void *operator new(size_t size);
+    static void operator delete(void *memory, size_t size);
+
     void addValue(const std::string &name, uint32_t value);
     void removeValue(const std::string &name);
     bool findValue(const std::string &name, uint32_t &ret);
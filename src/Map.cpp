@@ -226,6 +226,16 @@ bool Map::Save(const std::string &name) {
             }
         }
 
+        main_map.close();
+        main_item.close();
+        main_warp.close();
+        all_container.close();
+
+        if (main_map.fail() || main_item.fail() || main_warp.fail() || all_container.fail()) {
+            Logger::error(LogFacility::World) << "Saving map failed: " << name << Log::end;
+            return false;
+        }
+
         return true;
 
     } else {
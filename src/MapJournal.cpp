@@ -0,0 +1,259 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+
+#include "MapJournal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/crc.hpp>
+
+namespace {
+// records larger than this can only come from a corrupt length
+const uint32_t MAX_RECORD_SIZE = 64 * 1024 * 1024;
+}
+
+MapJournal::MapJournal(const std::string &path, std::chrono::milliseconds syncInterval)
+    : path(path), syncInterval(syncInterval), lastSync(std::chrono::steady_clock::now()) {
+    // whatever is in the file has been replayed and snapshotted before
+    open(true);
+    writer = std::thread(&MapJournal::run, this);
+}
+
+MapJournal::~MapJournal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    wakeup.notify_one();
+    writer.join();
+
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+uint32_t MapJournal::checksum(const char *data, size_t size) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+void MapJournal::addRecord(std::string &batch, const std::string &record) {
+    const uint32_t header[2] = {uint32_t(record.size()), checksum(record.data(), record.size())};
+    batch.append(reinterpret_cast<const char *>(header), sizeof(header));
+    batch.append(record);
+}
+
+bool MapJournal::syncFile(const std::string &path) {
+    const int file = ::open(path.c_str(), O_RDONLY);
+
+    if (file < 0) {
+        return false;
+    }
+
+    const bool synced = ::fsync(file) == 0;
+    ::close(file);
+    return synced;
+}
+
+MapJournal::ReplayResult MapJournal::replay(const std::string &path, const std::function<void(const std::string &)> &apply) {
+    ReplayResult result;
+    std::ifstream file(path, std::ios::binary | std::ios::in);
+
+    if (!file.good()) {
+        return result;
+    }
+
+    std::string record;
+
+    while (true) {
+        uint32_t header[2];
+        file.read(reinterpret_cast<char *>(header), sizeof(header));
+
+        if (file.gcount() == 0) {
+            break;
+        }
+
+        if (file.gcount() != sizeof(header) || header[0] > MAX_RECORD_SIZE) {
+            result.torn = true;
+            break;
+        }
+
+        record.resize(header[0]);
+        file.read(&record[0], header[0]);
+
+        if (file.gcount() != std::streamsize(header[0]) || checksum(record.data(), record.size()) != header[1]) {
+            result.torn = true;
+            break;
+        }
+
+        apply(record);
+        ++result.records;
+    }
+
+    return result;
+}
+
+void MapJournal::append(std::string &&batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        appendedBytes += batch.size();
+
+        if (pending.empty()) {
+            pending.swap(batch);
+        } else {
+            pending += batch;
+        }
+    }
+
+    wakeup.notify_one();
+}
+
+void MapJournal::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const auto target = appendedBytes;
+    forceSync = true;
+    wakeup.notify_one();
+    synced.wait(lock, [this, target] {
+        return syncedBytes >= target;
+    });
+}
+
+void MapJournal::truncate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+
+    {
+        std::lock_guard<std::mutex> io(ioMutex);
+        ++truncations;
+        open(true);
+    }
+
+    writtenBytes = appendedBytes;
+    syncedBytes = appendedBytes;
+    synced.notify_all();
+}
+
+void MapJournal::open(bool truncate) {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+
+    // opening the path again also recovers from the file being removed
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+
+    if (fd < 0) {
+        ++failedWrites;
+    }
+}
+
+void MapJournal::write(const std::string &data) {
+    if (fd < 0) {
+        ++failedWrites;
+        return;
+    }
+
+    const char *next = data.data();
+    size_t left = data.size();
+
+    while (left > 0) {
+        const auto written = ::write(fd, next, left);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            ++failedWrites;
+            return;
+        }
+
+        next += written;
+        left -= written;
+    }
+}
+
+void MapJournal::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        if (!pending.empty()) {
+            std::string data;
+            data.swap(pending);
+            const auto target = appendedBytes;
+            const auto generation = truncations;
+            lock.unlock();
+
+            {
+                std::lock_guard<std::mutex> io(ioMutex);
+
+                // a truncate in between already dropped these changes
+                if (generation == truncations) {
+                    write(data);
+                }
+            }
+
+            lock.lock();
+            writtenBytes = std::max(writtenBytes, target);
+        }
+
+        if (writtenBytes > syncedBytes) {
+            const auto now = std::chrono::steady_clock::now();
+
+            if (forceSync || stopping || now >= lastSync + syncInterval) {
+                const auto target = writtenBytes;
+                forceSync = false;
+                lock.unlock();
+
+                {
+                    std::lock_guard<std::mutex> io(ioMutex);
+
+                    if (fd >= 0 && ::fdatasync(fd) != 0) {
+                        ++failedWrites;
+                    }
+                }
+
+                lock.lock();
+                lastSync = now;
+                syncedBytes = std::max(syncedBytes, target);
+                synced.notify_all();
+            } else if (pending.empty()) {
+                // group commit, gather further batches until the sync is due
+                wakeup.wait_until(lock, lastSync + syncInterval);
+            }
+        } else if (pending.empty()) {
+            if (stopping) {
+                break;
+            }
+
+            wakeup.wait(lock);
+        }
+    }
+}
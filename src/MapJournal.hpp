@@ -0,0 +1,106 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+#ifndef _MAP_JOURNAL_HPP_
+#define _MAP_JOURNAL_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+* an append-only log of map changes between two snapshots
+*
+* The world hands in one batch of records per tick, a writer thread appends
+* the batches to the file and syncs them in groups, at most once per sync
+* interval. Every record is framed with its length and a checksum, so replay
+* stops cleanly at a record torn by a crash. After a snapshot the journal is
+* truncated since it only has to cover changes the snapshot does not know.
+*/
+class MapJournal {
+public:
+    struct ReplayResult {
+        size_t records = 0;
+        bool torn = false;
+    };
+
+    MapJournal(const std::string &path, std::chrono::milliseconds syncInterval);
+    ~MapJournal();
+
+    MapJournal(const MapJournal &) = delete;
+    MapJournal &operator=(const MapJournal &) = delete;
+
+    // frames a record and adds it to a batch
+    static void addRecord(std::string &batch, const std::string &record);
+
+    // syncs a file or directory written by other means, false if that fails
+    static bool syncFile(const std::string &path);
+
+    // calls apply for every intact record of the journal at path, in order
+    static ReplayResult replay(const std::string &path, const std::function<void(const std::string &)> &apply);
+
+    // hands a batch of records to the writer, empty batches are ignored
+    void append(std::string &&batch);
+
+    // blocks until everything appended so far is synced to disk
+    void flush();
+
+    // drops the whole journal, including batches not yet written
+    void truncate();
+
+    uint64_t getFailedWrites() const {
+        return failedWrites;
+    }
+
+private:
+    static uint32_t checksum(const char *data, size_t size);
+
+    void open(bool truncate);
+    void write(const std::string &data);
+    void run();
+
+    const std::string path;
+    const std::chrono::milliseconds syncInterval;
+    int fd = -1;
+
+    std::mutex mutex;
+    // held while touching the file, so truncate cannot overtake a write
+    std::mutex ioMutex;
+    std::condition_variable wakeup;
+    std::condition_variable synced;
+    std::string pending;
+    uint64_t appendedBytes = 0;
+    uint64_t writtenBytes = 0;
+    uint64_t syncedBytes = 0;
+    uint64_t truncations = 0;
+    std::chrono::steady_clock::time_point lastSync;
+    bool forceSync = false;
+    bool stopping = false;
+    std::atomic<uint64_t> failedWrites{0};
+    std::thread writer;
+};
+
+#endif
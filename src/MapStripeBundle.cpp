@@ -0,0 +1,146 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "MapStripeBundle.hpp"
+#include <zlib.h>
+#include "Field.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
+
+const uint8_t MapStripeBundle::VERSION;
+
+void MapStripeBundle::addStripe(const NewClientView &view) {
+    addStripeHeader(view, sm_tiles);
+
+    const Field *const *fields = view.mapStripe;
+    const uint8_t numberOfTiles = view.getMaxTiles();
+    addUnsignedChar(numberOfTiles);
+
+    for (int i = 0; i < numberOfTiles;) {
+        uint8_t runLength = 1;
+
+        while (i + runLength < numberOfTiles && isRepeatable(fields[i], fields[i + runLength])) {
+            ++runLength;
+        }
+
+        addTile(fields[i], runLength);
+        i += runLength;
+    }
+}
+
+void MapStripeBundle::addUnchangedStripe(const NewClientView &view) {
+    addStripeHeader(view, sm_unchanged);
+}
+
+ServerCommandPointer MapStripeBundle::finish() const {
+    if (empty()) {
+        return {};
+    }
+
+    uLongf compressedSize = compressBound(payload.size());
+    std::vector<unsigned char> compressed(compressedSize);
+
+    if (compress2(compressed.data(), &compressedSize, payload.data(), payload.size(), Z_BEST_SPEED) != Z_OK
+        || compressedSize > MAX_COMPRESSED_SIZE) {
+        return {};
+    }
+
+    compressed.resize(compressedSize);
+    return std::make_shared<MapStripeBundleTC>(stripes, payload.size(), compressed);
+}
+
+uint64_t MapStripeBundle::fingerprint(const NewClientView &view) {
+    // FNV-1a over the field addresses
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < view.getMaxTiles(); ++i) {
+        hash ^= reinterpret_cast<uintptr_t>(view.mapStripe[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+bool MapStripeBundle::unchangedSince(const NewClientView &view, uint32_t stamp) {
+    for (int i = 0; i < view.getMaxTiles(); ++i) {
+        const Field *field = view.mapStripe[i];
+
+        if (field && field->getChangeStamp() > stamp) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void MapStripeBundle::addStripeHeader(const NewClientView &view, stripe_mode mode) {
+    const position pos = view.getViewPosition();
+    addShortInt(pos.x);
+    addShortInt(pos.y);
+    addShortInt(pos.z);
+    addUnsignedChar(static_cast<uint8_t>(view.getStripeDirection()));
+    addUnsignedChar(mode);
+    ++stripes;
+}
+
+void MapStripeBundle::addTile(const Field *field, uint8_t runLength) {
+    addUnsignedChar(runLength);
+
+    if (field) {
+        addShortInt(field->getTileCode());
+        addUnsignedChar(field->getMovementCost());
+        addShortInt(field->getMusicId());
+        addUnsignedChar(static_cast<uint8_t>(field->items.size()));
+
+        for (const auto &item : field->items) {
+            addShortInt(item.getId());
+
+            if (item.isContainer()) {
+                addShortInt(1);
+            } else {
+                addShortInt(item.getNumber());
+            }
+        }
+    } else {
+        addShortInt(-1);
+        addUnsignedChar(0);
+        addShortInt(0);
+        addUnsignedChar(0);
+    }
+}
+
+bool MapStripeBundle::isRepeatable(const Field *first, const Field *second) {
+    if (!first || !second) {
+        return !first && !second;
+    }
+
+    return first->items.empty() && second->items.empty()
+           && first->getTileCode() == second->getTileCode()
+           && first->getMovementCost() == second->getMovementCost()
+           && first->getMusicId() == second->getMusicId();
+}
+
+void MapStripeBundle::addUnsignedChar(uint8_t data) {
+    payload.push_back(data);
+}
+
+void MapStripeBundle::addShortInt(int16_t data) {
+    addUnsignedChar(data >> 8);
+    addUnsignedChar(data & 255);
+}
@@ -0,0 +1,100 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _MAP_STRIPE_BUNDLE_HPP_
+#define _MAP_STRIPE_BUNDLE_HPP_
+
+#include <vector>
+#include "NewClientView.hpp"
+#include "netinterface/BasicServerCommand.hpp"
+
+class Field;
+
+/**
+* collects the map stripes of a full map transfer into one compressed
+* MapStripeBundleTC, used for clients which negotiated the bundle mode
+*
+* Each stripe is encoded as its position, direction and a mode byte. Stripes
+* the client already received unchanged are sent as a reference only, all
+* others are followed by their tiles, with runs of identical item-less tiles
+* collapsed into one record. The whole payload is compressed with zlib.
+*/
+class MapStripeBundle {
+public:
+    enum stripe_mode {
+        sm_tiles = 0,
+        sm_unchanged = 1
+    };
+
+    //! version of the bundle format, announced by the client with MapTransferModeTS
+    static const uint8_t VERSION = 1;
+
+    /**
+    * appends a stripe including all of its tiles
+    * @param view the filled stripe
+    */
+    void addStripe(const NewClientView &view);
+
+    /**
+    * appends a stripe the client can take from what it received before
+    * @param view the filled stripe
+    */
+    void addUnchangedStripe(const NewClientView &view);
+
+    bool empty() const {
+        return stripes == 0;
+    }
+
+    /**
+    * compresses the collected stripes into one command
+    * @return the bundle command, nullptr if it is empty or exceeds the maximum command size
+    */
+    ServerCommandPointer finish() const;
+
+    /**
+    * identifies the fields a stripe consists of, used to notice remapped stripes
+    * @param view the filled stripe
+    * @return a hash of the field addresses
+    */
+    static uint64_t fingerprint(const NewClientView &view);
+
+    /**
+    * checks if a stripe was changed after the given change stamp
+    * @param view the filled stripe
+    * @param stamp change stamp at the time the stripe was sent
+    * @return true if none of the fields changed since
+    */
+    static bool unchangedSince(const NewClientView &view, uint32_t stamp);
+
+private:
+    static const size_t MAX_COMPRESSED_SIZE = 60000;
+
+    void addStripeHeader(const NewClientView &view, stripe_mode mode);
+    void addTile(const Field *field, uint8_t runLength);
+    static bool isRepeatable(const Field *first, const Field *second);
+
+    void addUnsignedChar(uint8_t data);
+    void addShortInt(int16_t data);
+
+    std::vector<unsigned char> payload;
+    uint16_t stripes = 0;
+};
+
+#endif
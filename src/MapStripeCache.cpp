@@ -0,0 +1,105 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "MapStripeCache.hpp"
+#include "Field.hpp"
+#include "WorldMap.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
+
+ServerCommandPointer MapStripeCache::get(const position &pos, NewClientView::stripedirection dir, int length, const WorldMap &maps) {
+    checkChangeCounter();
+    const uint32_t changeCounter = lastChangeCounter;
+
+    NewClientView view;
+    view.fillStripe(pos, dir, length, maps);
+
+    const auto stripeKey = key(pos, dir, length);
+    auto it = stripes.find(stripeKey);
+
+    if (it != stripes.end() && isValid(it->second, view, length)) {
+        return it->second.stripe;
+    }
+
+    if (it == stripes.end()) {
+        if (stripes.size() >= MAX_STRIPES) {
+            stripes.clear();
+        }
+
+        it = stripes.emplace(stripeKey, Entry()).first;
+    }
+
+    Entry &entry = it->second;
+    entry.stamp = changeCounter;
+    entry.fields.assign(view.mapStripe, view.mapStripe + length);
+
+    if (view.getExists()) {
+        entry.stripe = std::make_shared<MapStripeTC>(view);
+        entry.stripe->addHeader();
+    } else {
+        entry.stripe.reset();
+    }
+
+    return entry.stripe;
+}
+
+void MapStripeCache::clear() {
+    stripes.clear();
+    ++generation;
+}
+
+uint32_t MapStripeCache::getGeneration() {
+    checkChangeCounter();
+    return generation;
+}
+
+void MapStripeCache::checkChangeCounter() {
+    const uint32_t changeCounter = Field::getChangeCounter();
+
+    // the change counter wrapped, stamps cannot be compared anymore
+    if (changeCounter < lastChangeCounter) {
+        clear();
+    }
+
+    lastChangeCounter = changeCounter;
+}
+
+uint64_t MapStripeCache::key(const position &pos, NewClientView::stripedirection dir, int length) {
+    return (uint64_t(uint16_t(pos.x)) << 48) | (uint64_t(uint16_t(pos.y)) << 32) | (uint64_t(uint16_t(pos.z)) << 16)
+           | (uint64_t(dir) << 8) | uint64_t(uint8_t(length));
+}
+
+bool MapStripeCache::isValid(const Entry &entry, const NewClientView &view, int length) {
+    if (entry.fields.size() != size_t(length)) {
+        return false;
+    }
+
+    for (int i = 0; i < length; ++i) {
+        const Field *field = view.mapStripe[i];
+
+        if (field != entry.fields[i]) {
+            return false;
+        }
+
+        if (field && field->getChangeStamp() > entry.stamp) {
+            return false;
+        }
+    }
+
+    return true;
+}
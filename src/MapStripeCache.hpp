@@ -0,0 +1,89 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef _MAP_STRIPE_CACHE_HPP_
+#define _MAP_STRIPE_CACHE_HPP_
+
+#include <unordered_map>
+#include <vector>
+#include "NewClientView.hpp"
+#include "netinterface/BasicServerCommand.hpp"
+
+class Field;
+class WorldMap;
+
+/**
+* caches encoded map stripes so players looking at the same area share
+* one MapStripeTC instead of encoding their own copy
+*
+* An entry stays valid as long as the stripe still consists of the same
+* fields and none of them has a change stamp newer than the entry.
+* Not thread-safe, only to be used from the main thread.
+*/
+class MapStripeCache {
+public:
+    /**
+    * returns the encoded stripe, encoding it if necessary
+    * @param pos the starting position of the stripe
+    * @param dir the direction in which the stripe looks
+    * @param length number of tiles to be read
+    * @param maps the maps from which the stripe is read
+    * @return the stripe command, nullptr if the stripe does not exist
+    */
+    ServerCommandPointer get(const position &pos, NewClientView::stripedirection dir, int length, const WorldMap &maps);
+
+    /**
+    * drops all cached stripes, needed when tile data was reloaded
+    */
+    void clear();
+
+    /**
+    * identifies the current set of change stamps, it changes whenever stamps
+    * recorded earlier can no longer be compared to current ones
+    * @return the current generation
+    */
+    uint32_t getGeneration();
+
+    size_t size() const {
+        return stripes.size();
+    }
+
+    /**
+    * identifies a stripe by its position, direction and length
+    */
+    static uint64_t key(const position &pos, NewClientView::stripedirection dir, int length);
+
+private:
+    struct Entry {
+        uint32_t stamp = 0;
+        std::vector<Field *> fields;
+        ServerCommandPointer stripe;
+    };
+
+    static const size_t MAX_STRIPES = 20000;
+
+    static bool isValid(const Entry &entry, const NewClientView &view, int length);
+    void checkChangeCounter();
+
+    std::unordered_map<uint64_t, Entry> stripes;
+    uint32_t lastChangeCounter = 0;
+    uint32_t generation = 0;
+};
+
+#endif
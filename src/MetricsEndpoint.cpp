@@ -0,0 +1,110 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+#include "MetricsEndpoint.hpp"
+
+#include <functional>
+#include <istream>
+
+#include "Logger.hpp"
+#include "Statistics.hpp"
+
+class MetricsEndpoint::Request : public std::enable_shared_from_this<Request> {
+public:
+    explicit Request(boost::asio::io_service &io_service) : socket(io_service), buffer(MAX_REQUEST_SIZE) {
+    }
+
+    boost::asio::ip::tcp::socket &getSocket() {
+        return socket;
+    }
+
+    void start() {
+        boost::asio::async_read_until(socket, buffer, "\r\n\r\n", std::bind(&Request::handleRead, shared_from_this(), std::placeholders::_1));
+    }
+
+private:
+    static const size_t MAX_REQUEST_SIZE = 4096;
+
+    void handleRead(const boost::system::error_code &error) {
+        if (error) {
+            return;
+        }
+
+        std::istream requestStream(&buffer);
+        std::string method;
+        std::string path;
+        requestStream >> method >> path;
+
+        if (method != "GET") {
+            respond("405 Method Not Allowed", "");
+        } else if (path == "/" || path == "/metrics") {
+            respond("200 OK", Statistic::Statistics::getInstance().exportText());
+        } else {
+            respond("404 Not Found", "");
+        }
+    }
+
+    void respond(const std::string &status, const std::string &body) {
+        response = "HTTP/1.0 " + status + "\r\n"
+                   "Content-Type: text/plain; version=0.0.4\r\n"
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                   "Connection: close\r\n\r\n" + body;
+        boost::asio::async_write(socket, boost::asio::buffer(response), std::bind(&Request::handleWrite, shared_from_this(), std::placeholders::_1));
+    }
+
+    void handleWrite(const boost::system::error_code &error) {
+        boost::system::error_code ignored;
+        socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+        socket.close(ignored);
+    }
+
+    boost::asio::ip::tcp::socket socket;
+    boost::asio::streambuf buffer;
+    std::string response;
+};
+
+const size_t MetricsEndpoint::Request::MAX_REQUEST_SIZE;
+
+MetricsEndpoint::MetricsEndpoint(boost::asio::io_service &io_service, uint16_t port)
+    : io_service(io_service),
+      acceptor(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port)) {
+    Logger::info(LogFacility::Other) << "Serving metrics on 127.0.0.1:" << port << Log::end;
+    accept();
+}
+
+void MetricsEndpoint::accept() {
+    auto request = std::make_shared<Request>(io_service);
+    acceptor.async_accept(request->getSocket(), std::bind(&MetricsEndpoint::handleAccept, this, request, std::placeholders::_1));
+}
+
+void MetricsEndpoint::handleAccept(const std::shared_ptr<Request> &request, const boost::system::error_code &error) {
+    if (error == boost::asio::error::operation_aborted) {
+        return;
+    }
+
+    if (!error) {
+        request->start();
+    } else {
+        Logger::error(LogFacility::Other) << "Could not accept metrics connection: " << error.message() << Log::end;
+    }
+
+    accept();
+}
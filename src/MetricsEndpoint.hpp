@@ -0,0 +1,50 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+#ifndef _METRICS_ENDPOINT_HPP_
+#define _METRICS_ENDPOINT_HPP_
+
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+
+/**
+* serves the statistics as plain text over http on the loopback interface
+*
+* Any GET for / or /metrics is answered with Statistics::exportText, the
+* connection is closed afterwards. Runs on the io_service of the client
+* connections, so it needs no thread of its own.
+*/
+class MetricsEndpoint {
+public:
+    MetricsEndpoint(boost::asio::io_service &io_service, uint16_t port);
+
+private:
+    class Request;
+
+    void accept();
+    void handleAccept(const std::shared_ptr<Request> &request, const boost::system::error_code &error);
+
+    boost::asio::io_service &io_service;
+    boost::asio::ip::tcp::acceptor acceptor;
+};
+
+#endif
@@ -17,11 +17,14 @@
 //  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
+
 #include "Player.hpp"
 #include "World.hpp"
 #include "Character.hpp"
 #include "Logger.hpp"
 #include "PlayerManager.hpp"
+#include "Statistics.hpp"
 #include "MonitoringClients.hpp"
 #include "netinterface/NetInterface.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
@@ -41,17 +44,21 @@ void MonitoringClients::clientConnect(Player *player) {
     client_list.push_back(player); /*<add a new client to the list*/
     //setup the keepalive
     time(&(player->lastkeepalive));
-    //Send all player infos to the new connected client
+    //all player infos are sent with the next flush
+    newClients.push_back(player);
+    clientCount.store(client_list.size(), std::memory_order_relaxed);
+}
 
+void MonitoringClients::sendSnapshot(Player *client) {
     _world->Players.for_each([&](Player *p) {
         ServerCommandPointer cmd = std::make_shared<BBPlayerTC>(p->getId(), p->getName(), p->getPosition());
-        player->Connection->addCommand(cmd);
+        client->Connection->addCommand(cmd);
         cmd = std::make_shared<BBSendAttribTC>(p->getId(), "hitpoints", p->increaseAttrib("hitpoints",0));
-        player->Connection->addCommand(cmd);
+        client->Connection->addCommand(cmd);
         cmd = std::make_shared<BBSendAttribTC>(p->getId(), "mana", p->increaseAttrib("mana",0));
-        player->Connection->addCommand(cmd);
+        client->Connection->addCommand(cmd);
         cmd = std::make_shared<BBSendAttribTC>(p->getId(), "foodlevel", p->increaseAttrib("foodlevel",0));
-        player->Connection->addCommand(cmd);
+        client->Connection->addCommand(cmd);
     });
 }
 
@@ -61,8 +68,150 @@ void MonitoringClients::sendCommand(const ServerCommandPointer &command) {
     }
 }
 
+void MonitoringClients::playerLoggedIn(TYPE_OF_CHARACTER_ID id, const std::string &name, const position &pos) {
+    if (!hasClients()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(changesMutex);
+    auto &delta = changedPlayers[id];
+    delta = PlayerDelta();
+    delta.loggedIn = true;
+    delta.name = name;
+    delta.pos = pos;
+}
+
+void MonitoringClients::playerLoggedOut(TYPE_OF_CHARACTER_ID id) {
+    if (!hasClients()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(changesMutex);
+    auto &delta = changedPlayers[id];
+    delta = PlayerDelta();
+    delta.loggedOut = true;
+}
+
+void MonitoringClients::playerMoved(TYPE_OF_CHARACTER_ID id, const position &pos) {
+    if (!hasClients()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(changesMutex);
+    auto &delta = changedPlayers[id];
+    delta.moved = true;
+    delta.pos = pos;
+}
+
+void MonitoringClients::attributeChanged(TYPE_OF_CHARACTER_ID id, const std::string &attribute, short int value) {
+    if (!hasClients()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(changesMutex);
+    changedPlayers[id].attributes[attribute] = value;
+}
+
+void MonitoringClients::skillChanged(TYPE_OF_CHARACTER_ID id, TYPE_OF_SKILL_ID skill, short int major, short int minor) {
+    if (!hasClients()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(changesMutex);
+    changedPlayers[id].skills[skill] = std::make_pair(major, minor);
+}
+
+void MonitoringClients::playerTalked(TYPE_OF_CHARACTER_ID id, uint8_t talkType, const std::string &message) {
+    if (!hasClients()) {
+        return;
+    }
+
+    ServerCommandPointer cmd = std::make_shared<BBTalkTC>(id, talkType, message);
+    std::lock_guard<std::mutex> lock(changesMutex);
+    events.push(std::move(cmd));
+}
+
+void MonitoringClients::playerAction(TYPE_OF_CHARACTER_ID id, uint8_t type, const std::string &description) {
+    if (!hasClients()) {
+        return;
+    }
+
+    ServerCommandPointer cmd = std::make_shared<BBSendActionTC>(id, type, description);
+    std::lock_guard<std::mutex> lock(changesMutex);
+    events.push(std::move(cmd));
+}
+
+void MonitoringClients::flush() {
+    if (client_list.empty()) {
+        return;
+    }
+
+    std::unordered_map<TYPE_OF_CHARACTER_ID, PlayerDelta> changes;
+    std::vector<ServerCommandPointer> commands;
+    uint64_t drops;
+
+    {
+        std::lock_guard<std::mutex> lock(changesMutex);
+        changes.swap(changedPlayers);
+        events.drain(commands);
+        drops = events.getDropCount() - reportedDrops;
+        reportedDrops += drops;
+    }
+
+    if (drops > 0) {
+        using Statistic::Statistics;
+        static const int droppedEvents = Statistics::getInstance().counterId("dropped monitoring events");
+        Statistics::getInstance().increment(droppedEvents, drops);
+    }
+
+    for (const auto &client : newClients) {
+        sendSnapshot(client);
+    }
+
+    newClients.clear();
+
+    std::vector<ServerCommandPointer> playerCommands;
+
+    for (const auto &change : changes) {
+        const auto id = change.first;
+        const auto &delta = change.second;
+
+        if (delta.loggedOut) {
+            playerCommands.push_back(std::make_shared<BBLogOutTC>(id));
+            continue;
+        }
+
+        if (delta.loggedIn) {
+            playerCommands.push_back(std::make_shared<BBPlayerTC>(id, delta.name, delta.pos));
+        } else if (delta.moved) {
+            playerCommands.push_back(std::make_shared<BBPlayerMoveTC>(id, delta.pos));
+        }
+
+        for (const auto &attribute : delta.attributes) {
+            playerCommands.push_back(std::make_shared<BBSendAttribTC>(id, attribute.first, attribute.second));
+        }
+
+        for (const auto &skill : delta.skills) {
+            playerCommands.push_back(std::make_shared<BBSendSkillTC>(id, skill.first, skill.second.first, skill.second.second));
+        }
+    }
+
+    // players first, so that chat and actions never refer to an unknown player
+    for (const auto &client : client_list) {
+        for (const auto &cmd : playerCommands) {
+            client->Connection->addCommand(cmd);
+        }
+
+        for (const auto &cmd : commands) {
+            client->Connection->addCommand(cmd);
+        }
+    }
+}
+
 
 void MonitoringClients::CheckClients() {
+    const bool hadClients = hasClients();
+
     for (auto it = client_list.begin(); it != client_list.end(); ++it) {
         time_t thetime;
         time(&thetime);
@@ -82,12 +231,22 @@ void MonitoringClients::CheckClients() {
                 (*it)->Connection->closeConnection();
             }
         } else {
-            PlayerManager::get().getLogOutPlayers().push_back(*it);
+            newClients.erase(std::remove(newClients.begin(), newClients.end(), *it), newClients.end());
+            PlayerManager::get().logout(*it);
             it = client_list.erase(it);
             --it;
         }
 
         time(&thetime);
     }
+
+    clientCount.store(client_list.size(), std::memory_order_relaxed);
+
+    if (hadClients && client_list.empty()) {
+        std::lock_guard<std::mutex> lock(changesMutex);
+        changedPlayers.clear();
+        std::vector<ServerCommandPointer> stale;
+        events.drain(stale);
+    }
 }
 
@@ -20,8 +20,16 @@
 #ifndef _CMONITORINGCLIENTS_
 #define _CMONITORINGCLIENTS_
 
+#include <atomic>
 #include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "globals.hpp"
+#include "ring_buffer.hpp"
 #include "netinterface/BasicServerCommand.hpp"
 
 class World;
@@ -30,6 +38,13 @@ class Player;
 /**
  * class which holds all the monitoring clients on the gameserver
  * and sends all the important server informations to them
+ *
+ * Player state is not sent when it changes. Only the latest position,
+ * attributes and skills of each changed player are kept and sent by flush,
+ * so a flush costs as much as the number of changed players, no matter how
+ * often they moved. Chat and actions are kept in a ring, dropping the oldest
+ * ones if the clients are flushed too rarely. Nothing is kept while no client
+ * is connected. All publishing functions may be called from any thread.
  */
 class MonitoringClients {
 public:
@@ -43,18 +58,59 @@ public:
     void clientConnect(Player *player);
 
     /**
-     * sends a new Command to all the connected clients
+     * sends a new Command to all the connected clients right away,
+     * only meant for rare events like admin messages
      * @param command the command which should be sended
      */
     void sendCommand(const ServerCommandPointer &command);
 
+    void playerLoggedIn(TYPE_OF_CHARACTER_ID id, const std::string &name, const position &pos);
+    void playerLoggedOut(TYPE_OF_CHARACTER_ID id);
+    void playerMoved(TYPE_OF_CHARACTER_ID id, const position &pos);
+    void attributeChanged(TYPE_OF_CHARACTER_ID id, const std::string &attribute, short int value);
+    void skillChanged(TYPE_OF_CHARACTER_ID id, TYPE_OF_SKILL_ID skill, short int major, short int minor);
+    void playerTalked(TYPE_OF_CHARACTER_ID id, uint8_t talkType, const std::string &message);
+    void playerAction(TYPE_OF_CHARACTER_ID id, uint8_t type, const std::string &description);
+
+    /**
+     * sends everything which changed since the last flush to all the
+     * connected clients and a snapshot of all players to new clients
+     */
+    void flush();
+
     /**
      * function which checks if new commands from clients are arrived and handels them
      */
     void CheckClients();
 
 private:
+    struct PlayerDelta {
+        bool loggedIn = false;
+        bool loggedOut = false;
+        bool moved = false;
+        std::string name;
+        position pos;
+        std::map<std::string, short int> attributes;
+        std::map<TYPE_OF_SKILL_ID, std::pair<short int, short int>> skills;
+    };
+
+    static const size_t MAX_EVENTS = 512;
+
+    bool hasClients() const {
+        return clientCount.load(std::memory_order_relaxed) > 0;
+    }
+
+    void sendSnapshot(Player *client);
+
     std::list<Player *> client_list;
+    std::vector<Player *> newClients;
+    std::atomic<size_t> clientCount{0};
+
+    std::mutex changesMutex;
+    std::unordered_map<TYPE_OF_CHARACTER_ID, PlayerDelta> changedPlayers;
+    ring_buffer<ServerCommandPointer> events{MAX_EVENTS};
+    uint64_t reportedDrops = 0;
+
     World *_world;  /*< pointer to the gameworld*/
 };
 #endif //_CMONITORINGCLIENTS_
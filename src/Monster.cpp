@@ -20,14 +20,36 @@
 #include "Monster.hpp"
 #include "Random.hpp"
 #include "tuningConstants.hpp"
+#include <algorithm>
 #include <iostream>
 #include "script/LuaMonsterScript.hpp"
 #include "World.hpp"
 #include "WaypointList.hpp"
 #include "Config.hpp"
+#include "ObjectPool.hpp"
+#include "data/Data.hpp"
+#include "data/WeaponObjectTable.hpp"
 
 uint32_t Monster::counter = 0;
 
+namespace {
+
+ObjectPool<Monster, 256> &monsterPool() {
+    // never destroyed, monsters may still be deleted on shutdown
+    static auto *pool = new ObjectPool<Monster, 256>();
+    return *pool;
+}
+
+}
+
+void *Monster::operator new(size_t size) {
+    return monsterPool().allocate(size);
+}
+
+void Monster::operator delete(void *memory, size_t size) {
+    monsterPool().deallocate(memory, size);
+}
+
 Monster::Monster(const TYPE_OF_CHARACTER_ID &type, const position &newpos, SpawnPoint *spawnpoint) throw(unknownIDException)
     : Character(),lastTargetPosition(position(0,0,0)),lastTargetSeen(false), spawn(spawnpoint), monstertype(type) {
     setId(MONSTER_BASE + counter++ % (NPC_BASE-MONSTER_BASE));
@@ -37,6 +59,16 @@ Monster::Monster(const TYPE_OF_CHARACTER_ID &type, const position &newpos, Spawn
 }
 
 void Monster::performStep(position targetpos) {
+    planStep(targetpos);
+
+    if (!waypoints.makeMove()) {
+        direction dir = static_cast<direction>(Random::uniform(0, 7));
+        move(dir);
+        increaseActionPoints(-20);
+    }
+}
+
+void Monster::planStep(const position &targetpos) {
     position currentTarget;
     bool hasTarget = waypoints.getNextWaypoint(currentTarget);
 
@@ -45,11 +77,30 @@ void Monster::performStep(position targetpos) {
         waypoints.addWaypoint(targetpos);
         waypoints.recalcStepList();
     }
+}
 
-    if (!waypoints.makeMove()) {
-        direction dir = static_cast<direction>(Random::uniform(0, 7));
-        move(dir);
-        increaseActionPoints(-20);
+uint16_t Monster::getAttackRange() const {
+    const Item &itl = characterItems[LEFT_TOOL];
+    const Item &itr = characterItems[RIGHT_TOOL];
+
+    if (Data::WeaponItems.exists(itr.getId())) {
+        return Data::WeaponItems[itr.getId()].Range;
+    } else if (Data::WeaponItems.exists(itl.getId())) {
+        return Data::WeaponItems[itl.getId()].Range;
+    }
+
+    return 1;
+}
+
+void Monster::think(Intent &intent) {
+    const position &pos = getPosition();
+    intent.targetsNear = _world->getTargetHandlesInRange(pos, getAttackRange());
+    intent.targetsInSight = _world->getTargetHandlesInRange(pos, MONSTERVIEWRANGE);
+
+    if (getOnRoute()) {
+        waypoints.planMove();
+    } else if (lastTargetSeen && !(pos == lastTargetPosition) && (intent.targetsInSight.empty() || !canAttack())) {
+        planStep(lastTargetPosition);
     }
 }
 
@@ -57,12 +108,14 @@ void Monster::setMonsterType(const TYPE_OF_CHARACTER_ID &type) throw(unknownIDEx
     deleteAllSkills();
 
 
-    MonsterStruct monsterdef;
+    const MonsterStruct *definition = World::get()->getMonsterDefinition(type);
 
-    if (! World::get()->getMonsterDefinition(type, monsterdef)) {
+    if (!definition) {
         throw unknownIDException();
     }
 
+    const MonsterStruct &monsterdef = *definition;
+
     // set attributes
     setAttribute(Character::luck, Random::uniform(monsterdef.attributes.luck.first, monsterdef.attributes.luck.second));
     setAttribute(Character::strength, Random::uniform(monsterdef.attributes.strength.first, monsterdef.attributes.strength.second));
@@ -85,7 +138,7 @@ void Monster::setMonsterType(const TYPE_OF_CHARACTER_ID &type) throw(unknownIDEx
     for (auto it = monsterdef.items.begin(); it != monsterdef.items.end(); ++it) {
 
         auto inventorySlot = it->first;
-        auto possibleItems = it->second;
+        const auto &possibleItems = it->second;
         int numberOfPossibleItems = possibleItems.size();
 
         if (numberOfPossibleItems > 0) {
@@ -133,42 +186,55 @@ void Monster::setAlive(bool t) {
 
     if (!t && wasAlive) {
 
-        MonsterStruct monStruct;
+        const MonsterStruct *monStruct = World::get()->getMonsterDefinition(getMonsterType());
 
-        if (World::get()->getMonsterDefinition(getMonsterType(), monStruct)) {
-            if (monStruct.script) {
-                monStruct.script->onDeath(this);
-            }
+        if (monStruct && monStruct->script) {
+            monStruct->script->onDeath(this);
         }
     }
 }
 
 bool Monster::attack(Character *target) {
 
-    MonsterStruct monStruct;
+    const MonsterStruct *monStruct = World::get()->getMonsterDefinition(getMonsterType());
 
-    if (World::get()->getMonsterDefinition(getMonsterType(), monStruct)) {
-        if (monStruct.script) {
-            monStruct.script->onAttack(this,target);
-        }
+    if (monStruct && monStruct->script) {
+        monStruct->script->onAttack(this,target);
     }
 
     return Character::attack(target);
 }
 
 void Monster::heal() {
-    increaseAttrib("hitpoints", 150);
-    increaseAttrib("mana", 150);
+    increaseAttribute(hitpoints, 150);
+    increaseAttribute(mana, 150);
+}
+
+void Monster::catchUp(uint32_t ticks) {
+    // an idle monster heals on about every 50th tick
+    static const uint32_t TICKS_PER_HEAL = 50;
+    // enough to fill up the largest possible pools
+    static const uint32_t MAX_HEALS = 70;
+
+    const MonsterStruct *monStruct = World::get()->getMonsterDefinition(getMonsterType());
+
+    if (!monStruct || !monStruct->canselfheal) {
+        return;
+    }
+
+    const uint32_t heals = std::min(ticks / TICKS_PER_HEAL, MAX_HEALS);
+
+    for (uint32_t i = 0; i < heals; ++i) {
+        heal();
+    }
 }
 
 void Monster::receiveText(talk_type tt, const std::string &message, Character *cc) {
-    MonsterStruct monStruct;
+    const MonsterStruct *monStruct = World::get()->getMonsterDefinition(getMonsterType());
 
-    if (World::get()->getMonsterDefinition(getMonsterType(), monStruct)) {
-        if (monStruct.script && monStruct.script->existsEntrypoint("receiveText")) {
-            if (this != cc) {
-                monStruct.script->receiveText(this, tt, message, cc);
-            }
+    if (monStruct && monStruct->script && monStruct->script->existsEntrypoint("receiveText")) {
+        if (this != cc) {
+            monStruct->script->receiveText(this, tt, message, cc);
         }
     }
 }
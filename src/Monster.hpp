@@ -20,7 +20,10 @@
 #ifndef MONSTER_HPP
 #define MONSTER_HPP
 
+#include <vector>
+
 #include "Character.hpp"
+#include "CharacterContainer.hpp"
 
 class SpawnPoint;
 
@@ -45,6 +48,9 @@ public:
     */
     Monster(const TYPE_OF_CHARACTER_ID &type, const position &newpos, SpawnPoint *spawnpoint=0) throw(unknownIDException);
 
+    static void *operator new(size_t size);
+    static void operator delete(void *memory, size_t size);
+
     virtual unsigned short getType() const override {
         return monster;
     }
@@ -107,6 +113,13 @@ public:
 
     void heal();
 
+    /**
+    * makes up for the ticks the monster was resting, healing it as if it
+    * had been simulated all the time
+    * @param ticks the number of ticks the monster missed
+    */
+    void catchUp(uint32_t ticks);
+
     /**
     *trys to find a path to the the targetposition and performs a step
     *in the direction
@@ -114,6 +127,44 @@ public:
     */
     void performStep(position targetpos);
 
+    /**
+    * finds the path for performStep without moving
+    * @param targetpos targetposition for the move
+    */
+    void planStep(const position &targetpos);
+
+    /**
+    * @return the range of the weapon in the right or else the left hand, 1 without weapon
+    */
+    uint16_t getAttackRange() const;
+
+    /**
+    * what a monster found out about its surroundings before acting
+    */
+    struct Intent {
+        /**
+        * a player or a monster, by handle since monsters acting earlier may
+        * kill it and free its memory
+        */
+        struct Target {
+            bool player;
+            CharacterHandle handle;
+        };
+
+        std::vector<Target> targetsNear; /**< characters in attack range */
+        std::vector<Target> targetsInSight; /**< characters in view range */
+    };
+
+    /**
+    * prepares the next action: looks for targets and plans the path of a
+    * route or of a chase after the last target
+    * Changes nothing but the monster's own path, so it may run on any thread
+    * as long as the world stands still. Calls no scripts and uses no random
+    * numbers, the outcome only depends on the world.
+    * @param intent receives the targets
+    */
+    void think(Intent &intent);
+
     /**
     * destructor
     */
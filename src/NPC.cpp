@@ -21,6 +21,7 @@
 #include "tuningConstants.hpp"
 #include "World.hpp"
 #include "Field.hpp"
+#include "ObjectPool.hpp"
 
 #include "db/ConnectionManager.hpp"
 
@@ -28,6 +29,24 @@
 
 uint32_t NPC::counter = 0;
 
+namespace {
+
+ObjectPool<NPC, 64> &npcPool() {
+    // never destroyed, NPCs may still be deleted on shutdown
+    static auto *pool = new ObjectPool<NPC, 64>();
+    return *pool;
+}
+
+}
+
+void *NPC::operator new(size_t size) {
+    return npcPool().allocate(size);
+}
+
+void NPC::operator delete(void *memory, size_t size) {
+    npcPool().deallocate(memory, size);
+}
+
 NPC::NPC(TYPE_OF_CHARACTER_ID _id, const std::string &_name, TYPE_OF_RACE_ID _race, const position &_pos, Character::face_to dir, bool ishealer, Character::sex_type sex,
          const Character::appearance &appearance) : Character(appearance),
     _ishealer(ishealer), _startpos(_pos) {
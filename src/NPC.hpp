@@ -62,6 +62,9 @@ public:
     NPC(TYPE_OF_CHARACTER_ID id, const std::string &name, TYPE_OF_RACE_ID type, const position &pos, Character::face_to dir, bool ishealer, Character::sex_type sex,
         const appearance &appearance);
 
+    static void *operator new(size_t size);
+    static void operator delete(void *memory, size_t size);
+
     /**
     * the destructor
     */
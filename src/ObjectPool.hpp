@@ -0,0 +1,109 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _OBJECT_POOL_HPP_
+#define _OBJECT_POOL_HPP_
+
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+/**
+* hands out memory for objects of one type from larger chunks and keeps
+* released memory in a free list for reuse
+*
+* Meant to back the operator new and delete of a class. Chunks are only
+* returned to the system when the pool itself is destroyed.
+*/
+template<class T, size_t CHUNK_SIZE = 256>
+class ObjectPool {
+public:
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    void *allocate() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!freeList) {
+            grow();
+        }
+
+        Node *node = freeList;
+        freeList = node->next;
+        return node;
+    }
+
+    void deallocate(void *memory) {
+        if (!memory) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Node *node = static_cast<Node *>(memory);
+        node->next = freeList;
+        freeList = node;
+    }
+
+    /**
+    * allocates memory for operator new of T, derived classes do not fit
+    * into the pool and are allocated from the heap
+    */
+    void *allocate(size_t size) {
+        if (size != sizeof(T)) {
+            return ::operator new(size);
+        }
+
+        return allocate();
+    }
+
+    void deallocate(void *memory, size_t size) {
+        if (size != sizeof(T)) {
+            ::operator delete(memory);
+            return;
+        }
+
+        deallocate(memory);
+    }
+
+private:
+    union Node {
+        Node *next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    void grow() {
+        std::unique_ptr<Node[]> chunk(new Node[CHUNK_SIZE]);
+
+        for (size_t i = 0; i < CHUNK_SIZE; ++i) {
+            chunk[i].next = freeList;
+            freeList = &chunk[i];
+        }
+
+        chunks.push_back(std::move(chunk));
+    }
+
+    std::mutex mutex;
+    Node *freeList = nullptr;
+    std::vector<std::unique_ptr<Node[]>> chunks;
+};
+
+#endif
@@ -38,6 +38,8 @@
 #include "make_unique.hpp"
 #include "Showcase.hpp"
 #include "LongTimeAction.hpp"
+#include "MapStripeBundle.hpp"
+#include "ObjectPool.hpp"
 
 #include "data/Data.hpp"
 #include "data/ContainerObjectTable.hpp"
@@ -72,6 +74,24 @@ extern std::shared_ptr<LuaDepotScript>depotScript;
 
 //#define PLAYER_MOVE_DEBUG
 
+namespace {
+
+ObjectPool<Player, 64> &playerPool() {
+    // never destroyed, players may still be deleted on shutdown
+    static auto *pool = new ObjectPool<Player, 64>();
+    return *pool;
+}
+
+}
+
+void *Player::operator new(size_t size) {
+    return playerPool().allocate(size);
+}
+
+void Player::operator delete(void *memory, size_t size) {
+    playerPool().deallocate(memory, size);
+}
+
 Player::Player(std::shared_ptr<NetInterface> newConnection) throw(Player::LogoutException)
     : Character(), onlinetime(0), Connection(newConnection), turtleActive(false),
       clippingActive(true), admin(false), questWriteLock(false), monitoringClient(false), dialogCounter(0) {
@@ -166,8 +186,7 @@ void Player::login() throw(Player::LogoutException) {
     effects.load();
 
     //send the basic data to the monitoring client
-    cmd = std::make_shared<BBPlayerTC>(getId(), getName(), pos);
-    _world->monitoringClientList->sendCommand(cmd);
+    _world->monitoringClientList->playerLoggedIn(getId(), getName(), pos);
 
     // send weather and time before sending the map, to display everything correctly from the start
     _world->sendIGTime(this);
@@ -674,17 +693,16 @@ void Player::updateBackPackView() {
 void Player::sendSkill(TYPE_OF_SKILL_ID skill, unsigned short int major, unsigned short int minor) {
     ServerCommandPointer cmd = std::make_shared<UpdateSkillTC>(skill, major, minor);
     Connection->addCommand(cmd);
-    cmd = std::make_shared<BBSendSkillTC>(getId(), skill, major, minor);
-    _world->monitoringClientList->sendCommand(cmd);
+    _world->monitoringClientList->skillChanged(getId(), skill, major, minor);
 }
 
 
 void Player::sendAllSkills() {
-    for (const auto &skill : skills) {
-        if (skill.second.major>0) {
-            sendSkill(skill.first, skill.second.major, skill.second.minor);
+    skills.for_each([this](TYPE_OF_SKILL_ID skill, const skillvalue &value) {
+        if (value.major>0) {
+            sendSkill(skill, value.major, value.minor);
         }
-    }
+    });
 }
 
 
@@ -755,8 +773,7 @@ void Player::sendAttrib(Character::attributeIndex attribute) {
         Connection->addCommand(cmd);
     }
 
-    ServerCommandPointer cmd = std::make_shared<BBSendAttribTC>(getId(), attributeStringMap[attribute], value);
-    _world->monitoringClientList->sendCommand(cmd);
+    _world->monitoringClientList->attributeChanged(getId(), attributeStringMap[attribute], value);
 }
 
 
@@ -1222,11 +1239,11 @@ bool Player::save() throw() {
             const InsertQuery::columnIndex minorColumn = query.addColumn("psk_minor");
 
             // now store the skills
-            for (const auto &skill : skills) {
-                query.addValue<uint16_t>(skillIdColumn, skill.first);
-                query.addValue<uint16_t>(valueColumn, (uint16_t) skill.second.major);
-                query.addValue<uint16_t>(minorColumn, (uint16_t) skill.second.minor);
-            }
+            skills.for_each([&](TYPE_OF_SKILL_ID skill, const skillvalue &value) {
+                query.addValue<uint16_t>(skillIdColumn, skill);
+                query.addValue<uint16_t>(valueColumn, (uint16_t) value.major);
+                query.addValue<uint16_t>(minorColumn, (uint16_t) value.minor);
+            });
 
             query.addValues<TYPE_OF_CHARACTER_ID>(playerIdColumn, getId(), InsertQuery::FILL);
             query.addServerTable("playerskills");
@@ -2015,8 +2032,7 @@ bool Player::move(direction dir, uint8_t mode) {
             _world->checkFieldAfterMove(this, cfnew);
 
             _world->TriggerFieldMove(this,true);
-            ServerCommandPointer cmd = std::make_shared<BBPlayerMoveTC>(getId(), getPosition());
-            _world->monitoringClientList->sendCommand(cmd);
+            _world->monitoringClientList->playerMoved(getId(), getPosition());
 
             if (mode != RUNNING || j == 1) {
                 return true;
@@ -2075,8 +2091,7 @@ void Player::handleWarp() {
     sendFullMap();
     visibleChars.clear();
     _world->sendAllVisibleCharactersToPlayer(this, true);
-    cmd = std::make_shared<BBPlayerMoveTC>(getId(), getPosition());
-    _world->monitoringClientList->sendCommand(cmd);
+    _world->monitoringClientList->playerMoved(getId(), getPosition());
 }
 
 void Player::openDepot(uint16_t depotid) {
@@ -2299,6 +2314,12 @@ Language Player::getPlayerLanguage() const {
 }
 
 void Player::sendRelativeArea(int8_t zoffs) {
+    std::unique_ptr<MapStripeBundle> bundle;
+
+    if (mapTransferMode > 0) {
+        bundle = std::make_unique<MapStripeBundle>();
+    }
+
     if ((screenwidth == 0) && (screenheight == 0)) {
         // static view
         int x = getPosition().x;
@@ -2313,14 +2334,8 @@ void Player::sendRelativeArea(int8_t zoffs) {
         }
 
         //schleife von 0ben nach unten durch alle tiles
-        World *world = World::get();
-
         for (int i=0; i <= (MAP_DIMENSION + MAP_DOWN_EXTRA + e) * 2; ++i) {
-            world->clientview.fillStripe(position(x,y,z), NewClientView::dir_right, MAP_DIMENSION+1-(i%2), World::get()->maps);
-
-            if (world->clientview.getExists()) {
-                Connection->addCommand(std::make_shared<MapStripeTC>(position(x,y,z), NewClientView::dir_right));
-            }
+            sendAreaStripe(position(x,y,z), MAP_DIMENSION+1-(i%2), bundle.get());
 
             if (i % 2 == 0) {
                 y += 1;
@@ -2342,14 +2357,8 @@ void Player::sendRelativeArea(int8_t zoffs) {
         }
 
         //schleife von 0ben nach unten durch alle tiles
-        World *world = World::get();
-
         for (int i=0; i <= (2*screenheight + MAP_DOWN_EXTRA + e) * 2; ++i) {
-            world->clientview.fillStripe(position(x,y,z), NewClientView::dir_right, 2*screenwidth+1-(i%2), World::get()->maps);
-
-            if (world->clientview.getExists()) {
-                Connection->addCommand(std::make_shared<MapStripeTC>(position(x,y,z), NewClientView::dir_right));
-            }
+            sendAreaStripe(position(x,y,z), 2*screenwidth+1-(i%2), bundle.get());
 
             if (i % 2 == 0) {
                 y += 1;
@@ -2358,9 +2367,82 @@ void Player::sendRelativeArea(int8_t zoffs) {
             }
         }
     }
+
+    if (bundle && !bundle->empty()) {
+        const auto command = bundle->finish();
+
+        if (command) {
+            Connection->addCommand(command);
+        } else {
+            // too large for one command, the recorded stripes never reached the client
+            forgetSentStripes();
+            const uint8_t mode = mapTransferMode;
+            mapTransferMode = 0;
+            sendRelativeArea(zoffs);
+            mapTransferMode = mode;
+        }
+    }
+}
+
+void Player::sendAreaStripe(const position &pos, int length, MapStripeBundle *bundle) {
+    World *world = World::get();
+
+    if (!bundle) {
+        const auto stripe = world->mapStripes.get(pos, NewClientView::dir_right, length, world->maps);
+
+        if (stripe) {
+            Connection->addCommand(stripe);
+        }
+
+        return;
+    }
+
+    const uint32_t generation = world->mapStripes.getGeneration();
+
+    if (generation != sentStripesGeneration) {
+        sentStripes.clear();
+        sentStripesGeneration = generation;
+    }
+
+    NewClientView view;
+    view.fillStripe(pos, NewClientView::dir_right, length, world->maps);
+
+    if (!view.getExists()) {
+        return;
+    }
+
+    const auto key = MapStripeCache::key(pos, NewClientView::dir_right, length);
+    const auto fingerprint = MapStripeBundle::fingerprint(view);
+    const auto it = sentStripes.find(key);
+
+    if (it != sentStripes.end() && it->second.fingerprint == fingerprint
+        && MapStripeBundle::unchangedSince(view, it->second.stamp)) {
+        bundle->addUnchangedStripe(view);
+        return;
+    }
+
+    if (it == sentStripes.end() && sentStripes.size() >= MAX_SENT_STRIPES) {
+        sentStripes.clear();
+    }
+
+    bundle->addStripe(view);
+    sentStripes[key] = {Field::getChangeCounter(), fingerprint};
+}
+
+void Player::setMapTransferMode(uint8_t mode) {
+    mapTransferMode = std::min(mode, MapStripeBundle::VERSION);
+    forgetSentStripes();
+}
+
+void Player::forgetSentStripes() {
+    sentStripes.clear();
 }
 
 void Player::sendFullMap() {
+    // a new coordinate drops the map commands still queued for sending, the
+    // client may never have received the stripes recorded for them
+    forgetSentStripes();
+
     for (int8_t i = -2; i <= 2; ++i) {
         sendRelativeArea(i);
     }
@@ -2425,7 +2507,7 @@ void Player::sendDirStripe(viewdir direction, bool extraStripeForDiagonalMove) {
             break;
         }
 
-        NewClientView *view = &(World::get()->clientview);
+        World *world = World::get();
 
         for (int z = - 2; z <= 2; ++z) {
             int e = (direction != lower && z > 0) ? z*3 : 0; // left, right and upper stripes moved up if z>0 to provide the client with info for detecting roofs
@@ -2435,10 +2517,10 @@ void Player::sendDirStripe(viewdir direction, bool extraStripeForDiagonalMove) {
                 ++l;
             }
 
-            view->fillStripe(position(x-z*3+e,y+z*3-e,pos.z+z), dir, length+l, World::get()->maps);
+            const auto stripe = world->mapStripes.get(position(x-z*3+e,y+z*3-e,pos.z+z), dir, length+l, world->maps);
 
-            if (view->getExists()) {
-                Connection->addCommand(std::make_shared<MapStripeTC>(position(x-z*3+e,y+z*3-e,pos.z+z), dir));
+            if (stripe) {
+                Connection->addCommand(stripe);
             }
         }
     } else {
@@ -2497,7 +2579,7 @@ void Player::sendDirStripe(viewdir direction, bool extraStripeForDiagonalMove) {
             break;
         }
 
-        NewClientView *view = &(World::get()->clientview);
+        World *world = World::get();
 
         for (int z = - 2; z <= 2; ++z) {
             int e = (direction != lower && z > 0) ? z*3 : 0; // left, right and upper stripes moved up if z>0 to provide the client with info for detecting roofs
@@ -2507,10 +2589,10 @@ void Player::sendDirStripe(viewdir direction, bool extraStripeForDiagonalMove) {
                 ++l;
             }
 
-            view->fillStripe(position(x-z*3+e,y+z*3-e,pos.z+z), dir, length+l, World::get()->maps);
+            const auto stripe = world->mapStripes.get(position(x-z*3+e,y+z*3-e,pos.z+z), dir, length+l, world->maps);
 
-            if (view->getExists()) {
-                Connection->addCommand(std::make_shared<MapStripeTC>(position(x-z*3+e,y+z*3-e,pos.z+z), dir));
+            if (stripe) {
+                Connection->addCommand(stripe);
             }
         }
     }
@@ -44,6 +44,7 @@ struct WeatherStruct;
 class Dialog;
 class Timer;
 class LongTimeAction;
+class MapStripeBundle;
 
 enum gm_rights {
     gmr_allowlogin = 1, //GM is allowed to login if nologin is true
@@ -276,6 +277,9 @@ public:
     //! normal constructor
     Player(std::shared_ptr<NetInterface> newConnection) throw(LogoutException);
 
+    static void *operator new(size_t size);
+    static void operator delete(void *memory, size_t size);
+
     //! check if username/password is ok
     void check_logindata() throw(LogoutException);
 
@@ -305,6 +309,17 @@ public:
          */
     void sendFullMap();
 
+    /**
+    * selects how full map transfers are sent, as announced by the client
+    * @param mode 0 for single map stripes, otherwise the highest bundle version the client supports
+    */
+    void setMapTransferMode(uint8_t mode);
+
+    /**
+    * forgets which stripes the client received, so the next full map is sent completely
+    */
+    void forgetSentStripes();
+
     /**
     * sends one complete mapstripe ( z-2, z-1, z, z+1, z+2) to the client
     * @param direction the direction from which the whole stripe has to be sent
@@ -576,6 +591,7 @@ public:
     virtual void logAdmin(const std::string &message) override;
 private:
     void startCrafting(uint8_t stillToCraft, uint16_t craftingTime, uint16_t sfx, uint16_t sfxDuration, uint32_t dialogId);
+    void sendAreaStripe(const position &pos, int length, MapStripeBundle *bundle);
 
 private:
 
@@ -622,6 +638,19 @@ private:
 
     bool monitoringClient;
 
+    // bundle version used for full map transfers, 0 for single stripes
+    uint8_t mapTransferMode = 0;
+
+    struct SentStripe {
+        uint32_t stamp;
+        uint64_t fingerprint;
+    };
+
+    static const size_t MAX_SENT_STRIPES = 4096;
+    typedef std::unordered_map<uint64_t, SentStripe> SentStripeMap;
+    SentStripeMap sentStripes;
+    uint32_t sentStripesGeneration = 0;
+
     const uint8_t BACKPACK_SHOWCASE = 0;
     uint8_t showcaseCounter;
     typedef std::unordered_map<uint8_t, std::unique_ptr<Showcase>> ShowcaseMap;
@@ -19,6 +19,9 @@
 
 #include "PlayerManager.hpp"
 
+#include <algorithm>
+#include <thread>
+
 #include "make_unique.hpp"
 #include "World.hpp"
 #include "Player.hpp"
@@ -27,16 +30,31 @@
 #include "MonitoringClients.hpp"
 #include "LongTimeAction.hpp"
 #include "Config.hpp"
+#include "Statistics.hpp"
 
 #include "script/LuaLogoutScript.hpp"
 
 #include "netinterface/protocol/ClientCommands.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
-#include "netinterface/protocol/BBIWIServerCommands.hpp"
 
 std::unique_ptr<PlayerManager> PlayerManager::instance = nullptr;
-std::mutex PlayerManager::mut;
-std::mutex PlayerManager::reloadmutex;
+const size_t PlayerManager::MAX_TASKS;
+const size_t PlayerManager::MAX_NEW_PLAYERS;
+
+namespace {
+
+using Statistic::Statistics;
+
+int millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+PlayerManager::PlayerManager() : incon([this](const std::shared_ptr<NetInterface> &connection) {
+    queueLogin(connection);
+}) {
+}
 
 PlayerManager &PlayerManager::get() {
     if (!instance) {
@@ -47,169 +65,290 @@ PlayerManager &PlayerManager::get() {
 }
 
 void PlayerManager::activate() {
+    const uint16_t threads = std::max<uint16_t>(1, Config::instance().player_threads);
+
     running = true;
 
-    login_thread = std::make_unique<std::thread>(loginLoop, this);
-    save_thread = std::make_unique<std::thread>(playerSaveLoop, this);
+    for (uint16_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&PlayerManager::workerLoop, this);
+    }
+
+    threadOk = true;
 }
 
 void PlayerManager::stop() {
     running = false;
-    
-    Logger::info(LogFacility::Other) << "Waiting for login thread to terminate ..." << Log::end;
-    login_thread->join();
 
-    Logger::info(LogFacility::Other) << "Waiting for player save thread to terminate ..." << Log::end;
-    save_thread->join();
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
 
-    Logger::info(LogFacility::Other) << "Player manager terminated!" << Log::end;
-}
+        // workers keep popping while we wait here, they no longer hand over logins
+        while (!deferredLogouts.empty()) {
+            tasks.push(deferredLogouts.front());
+            deferredLogouts.pop_front();
+        }
+    }
 
-bool PlayerManager::findPlayer(const std::string &name) const {
-    std::lock_guard<std::mutex> lock(mut);
+    tasks.close();
 
-    for (auto const &player : loggedOutPlayers) {
-        if (player->getName() == name) {
-            return true;
-        }
+    Logger::info(LogFacility::Other) << "Waiting for player threads to save all players ..." << Log::end;
+
+    for (auto &worker : workers) {
+        worker.join();
     }
 
-    return false;
+    workers.clear();
+    threadOk = false;
+
+    Logger::info(LogFacility::Other) << "Player manager terminated!" << Log::end;
+}
+
+bool PlayerManager::findPlayer(const std::string &name) const {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    return busyNames.find(name) != busyNames.end();
 }
 
 void PlayerManager::setLoginLogout(bool val) {
+    std::unique_lock<std::mutex> lock(taskMutex);
+
     if (val) {
-        reloadmutex.lock();
+        reloading = true;
+        workersIdle.wait(lock, [this] {
+            return busyWorkers == 0;
+        });
     } else {
-        reloadmutex.unlock();
+        reloading = false;
+        lock.unlock();
+        reloadDone.notify_all();
     }
 }
 
-void PlayerManager::loginLoop(PlayerManager *pmanager) {
-    try {
-        auto &newplayers = pmanager->incon.get_Player_Vector();
-        timespec waittime;
-        waittime.tv_sec = 0;
-        waittime.tv_nsec = 100000000;
-        pmanager->threadOk = true;
-
-        while (pmanager->running) {
-            //loop must be steered by counter so we parse every connection only one time bevor we getting to the other loop
-            int curconn = newplayers.size();
-	    unsigned short acceptVersion = Config::instance().clientversion;
-
-            for (int i = 0; i < curconn; ++i) {
-                auto Connection = newplayers.pop_front();
-
-                if (Connection) {
-                    try {
-                        if (!Connection->online) {
-                            throw Player::LogoutException(UNSTABLECONNECTION);
-                        }
-
-			auto loginData = Connection->getLoginData();
-			if (loginData != nullptr) {
-			    unsigned short int clientversion = loginData->getClientVersion();
-			    if (clientversion == 200) {
-				    // TODO handle login for BBIWI Clients...
-			    } else if (clientversion != acceptVersion) {
-				    Logger::error(LogFacility::Player) << loginData->getLoginName() << " tried to login with an old client (version " << clientversion << ") but version " << acceptVersion << " is required" << Log::end;
-				    throw Player::LogoutException(OLDCLIENT);
-			    }
-
-			    // TODO is this check really necessary?
-			    if (loginData->getLoginName() == "" || loginData->getPassword() == "")
-				    throw Player::LogoutException(WRONGPWD);
-
-			    // player already online?
-			    if (World::get()->Players.find(loginData->getLoginName()) || PlayerManager::get().findPlayer(loginData->getLoginName())) {
-				    Logger::alert(LogFacility::Player) << loginData->getLoginName() << " tried to login twice from ip: " << Connection->getIPAdress() << Log::end;
-				    throw Player::LogoutException(DOUBLEPLAYER);
-			    }
-
-                            Player *newPlayer = nullptr;
-                            {
-                                std::lock_guard<std::mutex> lock(reloadmutex);
-                                newPlayer = new Player(Connection);
-                            }
-                            
-			    pmanager->loggedInPlayers.push_back(newPlayer);
-			    World::get()->scheduler.signalNewPlayerAction();
-
-                            Connection.reset();
-                        } else {
-                            if (Connection->nextInactive()) {
-                                throw Player::LogoutException(UNSTABLECONNECTION);
-                            }
-
-                            newplayers.push_back(Connection);
-                            Connection.reset();
-                        }
-                    } catch (Player::LogoutException &e) {
-                        ServerCommandPointer cmd = std::make_shared<LogOutTC>(e.getReason());
-                        Connection->shutdownSend(cmd);
-                    }
-                } else {
-                    Connection.reset();
-                }
-
-            } // get new players
-
-            nanosleep(&waittime, nullptr);
-        }
-    } catch (std::exception &e) {
+void PlayerManager::logout(Player *player) {
+    static const int delayedLogouts = Statistics::getInstance().counterId("delayed logouts");
+
+    // the effects are saved on a worker, away from the timing wheel
+    player->effects.leaveWorld();
+
+    Task task;
+    task.player = player;
+    task.queued = std::chrono::steady_clock::now();
 
-    } catch (...) {
-        throw;
+    std::lock_guard<std::mutex> lock(taskMutex);
+    ++busyNames[player->getName()];
+
+    // never drop a player, but never block the main thread either, the
+    // workers may be waiting for it to take loaded players
+    if (!deferredLogouts.empty() || !tasks.try_push(task)) {
+        Statistics::getInstance().increment(delayedLogouts);
+        deferredLogouts.push_back(task);
     }
 }
 
-void PlayerManager::playerSaveLoop(PlayerManager *pmanager) {
-    try {
-        World *world = World::get();
-        timespec waittime;
-        waittime.tv_sec = 0;
-        waittime.tv_nsec = 100000000;
-        pmanager->threadOk = true;
-        Player *tmpPl = nullptr;
-
-        while (pmanager->running || !pmanager->loggedOutPlayers.empty()) {
-            if (!pmanager->loggedOutPlayers.empty()) {
-                while (!pmanager->loggedOutPlayers.empty()) {
-                    tmpPl = pmanager->loggedOutPlayers.front();
-
-                    if (!tmpPl->isMonitoringClient()) {
-                        {
-                            std::lock_guard<std::mutex> lock(reloadmutex);
-                            tmpPl->save();
-                        }
-                        tmpPl->Connection->closeConnection();
-                        ServerCommandPointer cmd = std::make_shared<BBLogOutTC>(tmpPl->getId());
-                        world->monitoringClientList->sendCommand(cmd);
-                        delete tmpPl;
-                        tmpPl = nullptr;
-                    } else {
-                        tmpPl->Connection->closeConnection();
-                        delete tmpPl;
-                        tmpPl = nullptr;
-                    }
-
-                    std::lock_guard<std::mutex> lock(mut);
-                    pmanager->loggedOutPlayers.pop_front();
-                }
+void PlayerManager::queueLogin(const std::shared_ptr<NetInterface> &connection) {
+    static const int rejectedLogins = Statistics::getInstance().counterId("rejected logins");
+
+    Task task;
+    task.connection = connection;
+    task.queued = std::chrono::steady_clock::now();
+
+    if (tasks.size() >= MAX_TASKS / 2 || !tasks.try_push(task)) {
+        Statistics::getInstance().increment(rejectedLogins);
+        Logger::warn(LogFacility::Player) << "Too many logins, refusing connection from " << connection->getIPAdress() << Log::end;
+        ServerCommandPointer cmd = std::make_shared<LogOutTC>(UNSTABLECONNECTION);
+        connection->shutdownSend(cmd);
+    }
+}
+
+bool PlayerManager::reserveName(const std::string &name) {
+    if (busyNames.find(name) != busyNames.end()) {
+        return false;
+    }
+
+    busyNames[name] = 1;
+    return true;
+}
+
+void PlayerManager::releaseName(const std::string &name) {
+    const auto it = busyNames.find(name);
+
+    if (it != busyNames.end() && --it->second == 0) {
+        busyNames.erase(it);
+    }
+}
+
+void PlayerManager::requeueDeferredLogouts() {
+    while (!deferredLogouts.empty() && tasks.try_push(deferredLogouts.front())) {
+        deferredLogouts.pop_front();
+    }
+}
+
+void PlayerManager::workerLoop() {
+    Task task;
+
+    while (tasks.pop(task)) {
+        Player *loggedIn = nullptr;
+        std::string reservedName;
+
+        {
+            std::unique_lock<std::mutex> lock(taskMutex);
+            requeueDeferredLogouts();
+            reloadDone.wait(lock, [this] {
+                return !reloading;
+            });
+            ++busyWorkers;
+        }
 
+        if (task.player) {
+            logoutPlayer(task);
+
+            bool lastLogout;
+
+            {
+                std::lock_guard<std::mutex> lock(taskMutex);
+                releaseName(task.player->getName());
+                lastLogout = tasks.empty() && deferredLogouts.empty();
+            }
+
+            delete task.player;
+
+            if (lastLogout) {
                 Logger::debug(LogFacility::World) << "update player list [begin]" << Log::end;
-                world->updatePlayerList();
+                World::get()->updatePlayerList();
                 Logger::debug(LogFacility::World) << "update player list [end]" << Log::end;
             }
+        } else if (running) {
+            loggedIn = loginPlayer(task, reservedName);
+        }
+
+        task = Task();
+
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+
+            if (--busyWorkers == 0) {
+                workersIdle.notify_all();
+            }
+        }
+
+        if (loggedIn) {
+            handOver(loggedIn, reservedName);
+        }
+    }
+}
+
+Player *PlayerManager::loginPlayer(const Task &task, std::string &reservedName) {
+    static const int loginQueue = Statistics::getInstance().typeId("login queue");
+    static const int loginLoad = Statistics::getInstance().typeId("login load");
+    Statistics::getInstance().logTime(loginQueue, millisecondsSince(task.queued));
+
+    const auto &connection = task.connection;
+    const auto start = std::chrono::steady_clock::now();
 
-            nanosleep(&waittime, nullptr);
+    try {
+        if (!connection->online) {
+            throw Player::LogoutException(UNSTABLECONNECTION);
         }
 
+        auto loginData = connection->getLoginData();
+        unsigned short acceptVersion = Config::instance().clientversion;
+        unsigned short int clientversion = loginData->getClientVersion();
+
+        if (clientversion == 200) {
+            // TODO handle login for BBIWI Clients...
+        } else if (clientversion != acceptVersion) {
+            Logger::error(LogFacility::Player) << loginData->getLoginName() << " tried to login with an old client (version " << clientversion << ") but version " << acceptVersion << " is required" << Log::end;
+            throw Player::LogoutException(OLDCLIENT);
+        }
+
+        // TODO is this check really necessary?
+        if (loginData->getLoginName() == "" || loginData->getPassword() == "") {
+            throw Player::LogoutException(WRONGPWD);
+        }
+
+        // player already online, logging in or not yet saved?
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+
+            if (World::get()->Players.find(loginData->getLoginName()) || !reserveName(loginData->getLoginName())) {
+                Logger::alert(LogFacility::Player) << loginData->getLoginName() << " tried to login twice from ip: " << connection->getIPAdress() << Log::end;
+                throw Player::LogoutException(DOUBLEPLAYER);
+            }
+
+            reservedName = loginData->getLoginName();
+        }
+
+        Player *newPlayer = new Player(connection);
+        Statistics::getInstance().logTime(loginLoad, millisecondsSince(start));
+
+        // handOver releases the name once the player is queued for the world
+        return newPlayer;
+    } catch (Player::LogoutException &e) {
+        ServerCommandPointer cmd = std::make_shared<LogOutTC>(e.getReason());
+        connection->shutdownSend(cmd);
     } catch (std::exception &e) {
+        Logger::error(LogFacility::Player) << "Login from " << connection->getIPAdress() << " failed: " << e.what() << Log::end;
+        ServerCommandPointer cmd = std::make_shared<LogOutTC>(UNSTABLECONNECTION);
+        connection->shutdownSend(cmd);
+    }
 
-    } catch (...) {
-        throw;
+    if (!reservedName.empty()) {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        releaseName(reservedName);
+        reservedName.clear();
     }
+
+    return nullptr;
 }
 
+void PlayerManager::handOver(Player *player, const std::string &reservedName) {
+    static const int delayedLogins = Statistics::getInstance().counterId("delayed logins");
+
+    if (!loggedInPlayers.try_push(player)) {
+        Statistics::getInstance().increment(delayedLogins);
+
+        // the main thread drains the queue, on shutdown it stops doing so
+        while (!loggedInPlayers.try_push(player)) {
+            if (!running) {
+                ServerCommandPointer cmd = std::make_shared<LogOutTC>(SERVERSHUTDOWN);
+                player->Connection->shutdownSend(cmd);
+
+                std::lock_guard<std::mutex> lock(taskMutex);
+                releaseName(reservedName);
+                delete player;
+                return;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    World::get()->scheduler.signalNewPlayerAction();
+
+    std::lock_guard<std::mutex> lock(taskMutex);
+    releaseName(reservedName);
+}
+
+void PlayerManager::logoutPlayer(const Task &task) {
+    static const int logoutQueue = Statistics::getInstance().typeId("logout queue");
+    static const int logoutSave = Statistics::getInstance().typeId("logout save");
+    Statistics::getInstance().logTime(logoutQueue, millisecondsSince(task.queued));
+
+    Player *player = task.player;
+
+    if (!player->isMonitoringClient()) {
+        const auto start = std::chrono::steady_clock::now();
+
+        try {
+            player->save();
+        } catch (std::exception &e) {
+            Logger::error(LogFacility::Player) << "Saving " << player->to_string() << " failed: " << e.what() << Log::end;
+        }
+
+        Statistics::getInstance().logTime(logoutSave, millisecondsSince(start));
+
+        player->Connection->closeConnection();
+        World::get()->monitoringClientList->playerLoggedOut(player->getId());
+    } else {
+        player->Connection->closeConnection();
+    }
+}
@@ -23,15 +23,35 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "InitialConnection.hpp"
-#include "thread_safe_vector.hpp"
+#include "bounded_queue.hpp"
 
 
 class Player;
 
+/**
+* loads players logging in and saves players logging out
+*
+* Connections are handed over as soon as their login command arrived, logged
+* out players as soon as they left the map. A pool of player_threads workers
+* takes both from one lock-free queue and handles them concurrently. Logins
+* are refused while the queue is half full, so logouts usually find room,
+* otherwise they wait in a list the workers move back into the queue.
+* Neither the main thread nor a busy worker ever blocks on a queue the other
+* one drains, a reload waits for the busy workers.
+*/
 class PlayerManager {
 public:
+    PlayerManager();
+
     static PlayerManager &get();
 
     void activate();
@@ -45,12 +65,14 @@ public:
 
     void setLoginLogout(bool val);
 
-    typedef thread_safe_vector<Player *> TPLAYERVECTOR;
+    typedef bounded_queue<Player *> PLAYERQUEUE;
 
-    TPLAYERVECTOR &getLogOutPlayers() {
-        return loggedOutPlayers;
-    }
-    TPLAYERVECTOR &getLogInPlayers() {
+    /**
+    * queues a player who left the map to be saved and deleted, any thread
+    */
+    void logout(Player *player);
+
+    PLAYERQUEUE &getLogInPlayers() {
         return loggedInPlayers;
     }
 
@@ -58,50 +80,79 @@ public:
 private:
     static std::unique_ptr<PlayerManager> instance;
 
+    static const size_t MAX_TASKS = 1024;
+    static const size_t MAX_NEW_PLAYERS = 256;
+
+    typedef std::chrono::steady_clock::time_point TIMEPOINT;
+
+    // either a connection to log in or a player to save
+    struct Task {
+        std::shared_ptr<NetInterface> connection;
+        Player *player = nullptr;
+        TIMEPOINT queued;
+    };
+
     /**
-    * loop which is threaded to get new connections
-    * create players, or storing data and deleting old connections
+    * called on an io thread once a connection sent its login command
     */
-    static void loginLoop(PlayerManager *pmanager);
-    static void playerSaveLoop(PlayerManager *pmanager);
-    static std::mutex mut;
+    void queueLogin(const std::shared_ptr<NetInterface> &connection);
+
+    void workerLoop();
+    // returns the loaded player and keeps its name reserved, nullptr if the login failed
+    Player *loginPlayer(const Task &task, std::string &reservedName);
+    // passes a loaded player to the main thread and releases its name, the worker must not count as busy
+    void handOver(Player *player, const std::string &reservedName);
+    void logoutPlayer(const Task &task);
+    // moves logouts which found the queue full back into it, taskMutex must be held
+    void requeueDeferredLogouts();
 
-    //Mutex der gesetzt wird beim reloaden. (Als multi read single write lock)
-    static std::mutex reloadmutex;
+    // false if the name is already busy, taskMutex must be held
+    bool reserveName(const std::string &name);
+    void releaseName(const std::string &name);
 
     /**
-    * true if the thread is running
+    * true while the workers accept logins
     */
-    volatile bool running = false;
+    std::atomic<bool> running{false};
 
     /**
-    * if false the thread was exited correctly
+    * true during a reload, workers start no new tasks and setLoginLogout
+    * waits for the busy ones
     */
-    volatile bool threadOk = false;
+    bool reloading = false;
+    int busyWorkers = 0;
 
     /**
-    * logged out players which connection wherent shutted down
+    * if false the thread was exited correctly
     */
-    //CInitialConnection::TVECTORPLAYER shutdownConnections;
+    volatile bool threadOk = false;
+
+    bounded_queue<Task> tasks{MAX_TASKS};
+
+    // logouts which found the task queue full
+    std::deque<Task> deferredLogouts;
+
+    // guards reloading, busyWorkers, busyNames and deferredLogouts
+    mutable std::mutex taskMutex;
+    std::condition_variable reloadDone;
+    std::condition_variable workersIdle;
 
     /**
-    * player which are not on the main map anymore
+    * names of players being loaded or not yet saved, with their number
     */
-    TPLAYERVECTOR loggedOutPlayers;
-
+    std::unordered_map<std::string, int> busyNames;
 
     /**
     * players which are logged in and correctly loaded
     */
-    TPLAYERVECTOR loggedInPlayers;
+    PLAYERQUEUE loggedInPlayers{MAX_NEW_PLAYERS};
 
     /**
     * initial connection to get the new connections
     */
     InitialConnection incon;
 
-    std::unique_ptr<std::thread> login_thread = nullptr;
-    std::unique_ptr<std::thread> save_thread = nullptr;
+    std::vector<std::thread> workers;
 };
 
 #endif
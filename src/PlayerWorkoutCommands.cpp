@@ -28,14 +28,17 @@
 #include "Statistics.hpp"
 
 void Player::workoutCommands() {
+    using namespace Statistic;
+    static const int incomingDone = Statistics::getInstance().typeId("command_incoming_done");
+    static const int incomingDoneAP = Statistics::getInstance().typeId("command_incoming_done_ap");
+
     std::unique_lock<std::mutex> lock(commandMutex);
     while (!immediateCommands.empty()) {
 	    ClientCommandPointer cmd = immediateCommands.front();
 	    immediateCommands.pop();
 	    lock.unlock();
 	    cmd->performAction(this);
-	    using namespace Statistic;
-	    Statistics::getInstance().logTime("command_incoming_done", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cmd->getIncomingTime()).count());
+	    Statistics::getInstance().logTime(incomingDone, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cmd->getIncomingTime()).count());
 	    lock.lock();
     }
 
@@ -44,8 +47,7 @@ void Player::workoutCommands() {
 	    queuedCommands.pop();
 	    lock.unlock();
 	    cmd->performAction(this);
-	    using namespace Statistic;
-	    Statistics::getInstance().logTime("command_incoming_done_ap", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cmd->getIncomingTime()).count());
+	    Statistics::getInstance().logTime(incomingDoneAP, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cmd->getIncomingTime()).count());
 	    lock.lock();
     }
 }
@@ -19,6 +19,16 @@
 #include "Random.hpp"
 
 std::mt19937 Random::rng;
+uint32_t Random::currentSeed = std::mt19937::default_seed;
+
+void Random::seed(uint32_t value) {
+    currentSeed = value;
+    rng.seed(value);
+}
+
+uint32_t Random::getSeed() {
+    return currentSeed;
+}
 
 double Random::uniform() {
     std::uniform_real_distribution<double> uniform(0, 1);
@@ -25,8 +25,11 @@
 class Random {
 private:
     static std::mt19937 rng;
+    static uint32_t currentSeed;
     Random() {};
 public:
+    static void seed(uint32_t value);
+    static uint32_t getSeed();
     static double uniform();
     static int uniform(int min, int max);
     static double normal(double mean, double sd);
@@ -20,6 +20,7 @@
 #ifndef _SCHEDULER_HPP_
 #define _SCHEDULER_HPP_
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <chrono>
@@ -38,6 +39,9 @@ class Task {
 
 		bool run();
 
+		// how late the task started, counted by task name
+		void addLateness(std::chrono::microseconds lateness);
+
 		inline std::string getName() const {
 			return _name;
 		}
@@ -52,6 +56,8 @@ class Task {
 		typename clock_type::time_point _next;
 		std::chrono::nanoseconds _interval;
 		std::string _name;
+		int _latenessCounter;
+		int _lastLatenessGauge;
 };
 
 template<typename clock_type>
@@ -19,7 +19,11 @@
 #include "Statistics.hpp"
 
 template<typename clock_type>
-Task<clock_type>::Task(std::function<void()> task, typename clock_type::time_point start_point, std::chrono::nanoseconds interval, const std::string& name) : _task(task), _next(start_point), _interval(interval), _name(name) { }
+Task<clock_type>::Task(std::function<void()> task, typename clock_type::time_point start_point, std::chrono::nanoseconds interval, const std::string& name) : _task(task), _next(start_point), _interval(interval), _name(name) {
+    using Statistic::Statistics;
+    _latenessCounter = Statistics::getInstance().counterId("scheduler lateness us " + name);
+    _lastLatenessGauge = Statistics::getInstance().gaugeId("scheduler last lateness us " + name);
+}
 
 template<typename clock_type>
 bool Task<clock_type>::run() {
@@ -36,6 +40,13 @@ bool Task<clock_type>::run() {
 	return false;
 }
 
+template<typename clock_type>
+void Task<clock_type>::addLateness(std::chrono::microseconds lateness) {
+    using Statistic::Statistics;
+    Statistics::getInstance().increment(_latenessCounter, lateness.count());
+    Statistics::getInstance().setGauge(_lastLatenessGauge, lateness.count());
+}
+
 template<typename clock_type>
 void ClockBasedScheduler<clock_type>::addOneshotTask(std::function<void()> task, const std::chrono::nanoseconds delay, const std::string& taskname) {
 	std::unique_lock<std::mutex> lock(_container_mutex);
@@ -88,6 +99,9 @@ std::chrono::nanoseconds ClockBasedScheduler<clock_type>::getNextTaskTime() {
 
 template<typename clock_type>
 void ClockBasedScheduler<clock_type>::execute_tasks() {
+	using Statistic::Statistics;
+	static const int tasksRun = Statistics::getInstance().counterId("scheduler tasks");
+
 	auto now = clock_type::now();
 
 	std::unique_lock<std::mutex> lock(_container_mutex);
@@ -96,6 +110,9 @@ void ClockBasedScheduler<clock_type>::execute_tasks() {
 		_tasks.pop();
 		lock.unlock();
 
+		Statistics::getInstance().increment(tasksRun);
+		task.addLateness(std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - task.getNextTime()));
+
 		bool runResult = task.run();
 
 		lock.lock();
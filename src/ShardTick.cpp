@@ -0,0 +1,136 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "ShardTick.hpp"
+
+#include <algorithm>
+
+const size_t ShardTick::GONE = ~size_t(0);
+
+ShardTick::ShardTick(size_t shards, const Locate &locate) : locate(locate) {
+    for (size_t i = 0; i < shards; ++i) {
+        this->shards.push_back(std::make_unique<Shard>());
+    }
+
+    // only once all shards exist, since threads hand members to each other
+    for (size_t i = 0; i < shards; ++i) {
+        this->shards[i]->thread = std::thread(&ShardTick::work, this, i);
+    }
+}
+
+ShardTick::~ShardTick() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    started.notify_all();
+
+    for (auto &shard : shards) {
+        shard->thread.join();
+    }
+}
+
+void ShardTick::adopt(Id id, size_t shard) {
+    Message message;
+    message.id = id;
+    message.join = true;
+    shards[shard]->inbox.push(message);
+}
+
+void ShardTick::handOver(Id id, size_t from, size_t to) {
+    Message message;
+    message.id = id;
+    message.join = false;
+    shards[from]->inbox.push(message);
+    adopt(id, to);
+}
+
+void ShardTick::run(const Task &task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        working = shards.size();
+        ++generation;
+    }
+
+    started.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] {
+        return working == 0;
+    });
+    currentTask = nullptr;
+}
+
+void ShardTick::work(size_t shard) {
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        started.wait(lock, [this, seen] {
+            return stopping || generation != seen;
+        });
+
+        if (stopping) {
+            return;
+        }
+
+        seen = generation;
+        lock.unlock();
+        tick(shard);
+        lock.lock();
+
+        if (--working == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void ShardTick::tick(size_t shard) {
+    auto &members = shards[shard]->members;
+    Message message;
+
+    while (shards[shard]->inbox.pop(message)) {
+        const auto member = std::find(members.begin(), members.end(), message.id);
+
+        if (message.join && member == members.end()) {
+            members.push_back(message.id);
+        } else if (!message.join && member != members.end()) {
+            members.erase(member);
+        }
+    }
+
+    const auto &task = *currentTask;
+    size_t kept = 0;
+
+    for (const auto id : members) {
+        const size_t current = locate(id);
+
+        if (current == shard) {
+            members[kept++] = id;
+            task(shard, id);
+        } else if (current < shards.size()) {
+            adopt(id, current);
+        }
+    }
+
+    members.resize(kept);
+}
@@ -0,0 +1,101 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _SHARD_TICK_HPP_
+#define _SHARD_TICK_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "make_unique.hpp"
+#include "mpsc_queue.hpp"
+#include "types.hpp"
+
+/**
+* ticks the members of every shard on a thread of its own
+*
+* Each shard owns a list of members, only its thread touches that list. A
+* member changing shards is not taken over at once: the move is queued in the
+* inboxes of both shards, which take it over at the start of their next run,
+* in the order the moves were queued. A member a shard finds somewhere else
+* without a queued move, e.g. after a warp, is handed over by that shard
+* through the same inbox and may skip one run. Members that are gone are dropped.
+*
+* run returns once every shard is done, the world stands still meanwhile, so
+* the tasks may read it but must neither call Lua nor change it.
+*/
+class ShardTick {
+public:
+    using Id = TYPE_OF_CHARACTER_ID;
+    using Locate = std::function<size_t(Id)>;
+    using Task = std::function<void(size_t, Id)>;
+
+    // returned by locate for members which are gone
+    static const size_t GONE;
+
+    // starts one thread per shard, locate tells the shard a member is in now
+    ShardTick(size_t shards, const Locate &locate);
+    ~ShardTick();
+
+    ShardTick(const ShardTick &) = delete;
+    ShardTick &operator=(const ShardTick &) = delete;
+
+    // new member, owned from the next run on
+    void adopt(Id id, size_t shard);
+    // queues a move across a shard border
+    void handOver(Id id, size_t from, size_t to);
+    // runs task for every member on the thread of its shard
+    void run(const Task &task);
+
+    size_t size() const {
+        return shards.size();
+    }
+
+private:
+    struct Message {
+        Id id = 0;
+        bool join = false;
+    };
+
+    struct Shard {
+        mpsc_queue<Message> inbox;
+        std::vector<Id> members;
+        std::thread thread;
+    };
+
+    void work(size_t shard);
+    void tick(size_t shard);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    const Locate locate;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const Task *currentTask = nullptr;
+    size_t generation = 0;
+    size_t working = 0;
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,52 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "SkillSet.hpp"
+
+auto SkillSet::operator[](TYPE_OF_SKILL_ID skill) -> value & {
+    if (!has(skill)) {
+        if (skill >= values.size()) {
+            values.resize(skill + 1);
+        }
+
+        values[skill] = value();
+        present[skill / 64] |= uint64_t(1) << (skill % 64);
+        ++count;
+    }
+
+    return values[skill];
+}
+
+void SkillSet::erase(TYPE_OF_SKILL_ID skill) {
+    if (has(skill)) {
+        present[skill / 64] &= ~(uint64_t(1) << (skill % 64));
+        --count;
+    }
+}
+
+void SkillSet::clear() {
+    values.clear();
+
+    for (auto &word : present) {
+        word = 0;
+    }
+
+    count = 0;
+}
@@ -0,0 +1,97 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _SKILL_SET_HPP_
+#define _SKILL_SET_HPP_
+
+#include <vector>
+#include <stdint.h>
+#include "types.hpp"
+
+/**
+* the skills of a character, stored in an array indexed by skill id
+*
+* A bitmap tells which skills the character has, so looking up a skill
+* costs one bit test and iterating visits the skills in order of their id.
+*/
+class SkillSet {
+public:
+    struct value {
+        unsigned short int major = 0;
+        unsigned short int minor = 0;
+    };
+
+    /**
+    * @return the skill, nullptr if the character does not have it
+    */
+    value *find(TYPE_OF_SKILL_ID skill) {
+        return has(skill) ? &values[skill] : nullptr;
+    }
+
+    const value *find(TYPE_OF_SKILL_ID skill) const {
+        return has(skill) ? &values[skill] : nullptr;
+    }
+
+    /**
+    * @return the skill, added with zero values if the character does not
+    * have it yet
+    */
+    value &operator[](TYPE_OF_SKILL_ID skill);
+
+    void erase(TYPE_OF_SKILL_ID skill);
+    void clear();
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    /**
+    * calls function(skill, value) for all skills in order of their id
+    */
+    template<class Function>
+    void for_each(Function function) const {
+        for (int word = 0; word < WORDS; ++word) {
+            uint64_t bits = present[word];
+
+            while (bits) {
+                const int skill = word * 64 + __builtin_ctzll(bits);
+                function(TYPE_OF_SKILL_ID(skill), values[skill]);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    static const int WORDS = (1 << (8 * sizeof(TYPE_OF_SKILL_ID))) / 64;
+
+    bool has(TYPE_OF_SKILL_ID skill) const {
+        return (present[skill / 64] >> (skill % 64)) & 1;
+    }
+
+    std::vector<value> values;
+    uint64_t present[WORDS] = {};
+    size_t count = 0;
+};
+
+#endif
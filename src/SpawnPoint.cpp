@@ -61,6 +61,11 @@ void SpawnPoint::addMonster(const TYPE_OF_CHARACTER_ID &typ, const short int &co
 //! do spawns if possible...
 void SpawnPoint::spawn() {
     if (nextspawntime <= 0) {
+        // nobody would see the new monsters, spawn as soon as somebody comes close
+        if (!world->activity.isActive(spawnpos)) {
+            return;
+        }
+
         //set new spawntime
         nextspawntime = Random::uniform(min_spawntime, max_spawntime);
 
@@ -0,0 +1,179 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "SpecialFieldIndex.hpp"
+
+#include <algorithm>
+
+void SpecialFieldIndex::cover(int z, int minX, int minY, int maxX, int maxY) {
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    if (levels.empty()) {
+        firstLevel = z;
+    }
+
+    if (z < firstLevel) {
+        levels.insert(levels.begin(), firstLevel - z, Level());
+        firstLevel = z;
+    } else if (size_t(z - firstLevel) >= levels.size()) {
+        levels.resize(z - firstLevel + 1);
+    }
+
+    Level &level = levels[z - firstLevel];
+    int fromX = minX >> CHUNK_BITS;
+    int fromY = minY >> CHUNK_BITS;
+    int toX = maxX >> CHUNK_BITS;
+    int toY = maxY >> CHUNK_BITS;
+
+    if (level.width > 0) {
+        fromX = std::min(fromX, level.chunkX);
+        fromY = std::min(fromY, level.chunkY);
+        toX = std::max(toX, level.chunkX + level.width - 1);
+        toY = std::max(toY, level.chunkY + level.height - 1);
+    }
+
+    level.chunkX = fromX;
+    level.chunkY = fromY;
+    level.width = toX - fromX + 1;
+    level.height = toY - fromY + 1;
+    level.chunks.assign(level.width * level.height, nullptr);
+
+    for (auto &chunk : chunks) {
+        const uint64_t key = chunk.first;
+
+        if (int16_t(key) == z) {
+            Chunk **covered = coveredChunk(int16_t(key >> 32), int16_t(key >> 16), z);
+
+            if (covered) {
+                *covered = &chunk.second;
+            }
+        }
+    }
+}
+
+void SpecialFieldIndex::add(const position &pos, Kind kind) {
+    const auto inserted = chunks.emplace(chunkKey(pos), Chunk());
+    auto &chunk = inserted.first->second;
+
+    if (inserted.second) {
+        Chunk **covered = coveredChunk(pos.x >> CHUNK_BITS, pos.y >> CHUNK_BITS, pos.z);
+
+        if (covered) {
+            *covered = &chunk;
+        }
+    }
+
+    auto &bits = chunk.rows[kind][row(pos)];
+
+    if ((bits & bit(pos)) == 0) {
+        bits |= bit(pos);
+        ++chunk.entries;
+        ++counts[kind];
+    }
+}
+
+void SpecialFieldIndex::remove(const position &pos, Kind kind) {
+    const auto chunk = chunks.find(chunkKey(pos));
+
+    if (chunk == chunks.end()) {
+        return;
+    }
+
+    auto &bits = chunk->second.rows[kind][row(pos)];
+
+    if ((bits & bit(pos)) != 0) {
+        bits &= ~bit(pos);
+        --counts[kind];
+
+        if (--chunk->second.entries == 0) {
+            release(chunk);
+        }
+    }
+}
+
+void SpecialFieldIndex::clear(Kind kind) {
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        auto &chunk = it->second;
+
+        for (auto &bits : chunk.rows[kind]) {
+            chunk.entries -= __builtin_popcountll(bits);
+            bits = 0;
+        }
+
+        if (chunk.entries == 0) {
+            release(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    counts[kind] = 0;
+}
+
+void SpecialFieldIndex::release(std::unordered_map<uint64_t, Chunk>::iterator chunk) {
+    const uint64_t key = chunk->first;
+    Chunk **covered = coveredChunk(int16_t(key >> 32), int16_t(key >> 16), int16_t(key));
+
+    if (covered) {
+        *covered = nullptr;
+    }
+
+    chunks.erase(chunk);
+}
+
+void SpecialFieldIndex::findInRange(const position &center, int range, Kind kind, std::vector<position> &found) const {
+    if (range < 0 || counts[kind] == 0) {
+        return;
+    }
+
+    const int minX = std::max(center.x - range, -0x8000);
+    const int maxX = std::min(center.x + range, 0x7FFF);
+    const int minY = std::max(center.y - range, -0x8000);
+    const int maxY = std::min(center.y + range, 0x7FFF);
+
+    for (int chunkY = minY >> CHUNK_BITS; chunkY <= maxY >> CHUNK_BITS; ++chunkY) {
+        for (int chunkX = minX >> CHUNK_BITS; chunkX <= maxX >> CHUNK_BITS; ++chunkX) {
+            const Chunk *chunk = findChunk(chunkX, chunkY, center.z);
+
+            if (!chunk) {
+                continue;
+            }
+
+            const int baseX = chunkX << CHUNK_BITS;
+            const int baseY = chunkY << CHUNK_BITS;
+            const int fromX = std::max(minX, baseX) - baseX;
+            const int toX = std::min(maxX, baseX + CHUNK_SIZE - 1) - baseX;
+            const uint64_t columns = (toX == CHUNK_SIZE - 1 ? ~uint64_t(0) : (uint64_t(1) << (toX + 1)) - 1)
+                                     & ~((uint64_t(1) << fromX) - 1);
+
+            for (int y = std::max(minY, baseY); y <= std::min(maxY, baseY + CHUNK_SIZE - 1); ++y) {
+                uint64_t bits = chunk->rows[kind][y - baseY] & columns;
+
+                while (bits != 0) {
+                    const int x = __builtin_ctzll(bits);
+                    found.emplace_back(baseX + x, y, center.z);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,154 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _SPECIAL_FIELD_INDEX_HPP_
+#define _SPECIAL_FIELD_INDEX_HPP_
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "globals.hpp"
+
+/**
+* tells which fields are warps or triggers
+*
+* The map is cut into chunks of 64x64 fields per level, each chunk keeps a
+* bitmap per kind. Within the bounds of the maps, given by cover, a chunk is
+* found through a flat array of chunk pointers per level, elsewhere by an
+* integer key. Asking for a single field then tests one bit, range queries
+* only visit the chunks overlapping the range. Chunks without any entry are
+* released.
+*/
+class SpecialFieldIndex {
+public:
+    enum Kind {
+        warp,
+        trigger,
+        kinds
+    };
+
+    static const int CHUNK_BITS = 6;
+    static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+
+    /**
+    * lets the chunks of a rectangle on level z be found without hashing,
+    * called with the bounds of every map as it is inserted
+    */
+    void cover(int z, int minX, int minY, int maxX, int maxY);
+
+    void add(const position &pos, Kind kind);
+    void remove(const position &pos, Kind kind);
+
+    //! removes all entries of one kind
+    void clear(Kind kind);
+
+    bool has(const position &pos, Kind kind) const {
+        const Chunk *chunk = findChunk(pos.x >> CHUNK_BITS, pos.y >> CHUNK_BITS, pos.z);
+        return chunk && (chunk->rows[kind][row(pos)] & bit(pos)) != 0;
+    }
+
+    /**
+    * appends all fields of one kind on the level of center, at most range
+    * fields away in x and y
+    */
+    void findInRange(const position &center, int range, Kind kind, std::vector<position> &found) const;
+
+    //! number of entries of one kind
+    size_t size(Kind kind) const {
+        return counts[kind];
+    }
+
+private:
+    struct Chunk {
+        std::array<std::array<uint64_t, CHUNK_SIZE>, kinds> rows = {};
+        size_t entries = 0;
+    };
+
+    // the covered chunks of one level
+    struct Level {
+        int chunkX = 0;
+        int chunkY = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<Chunk *> chunks;
+    };
+
+    // the entry of a chunk in the flat array, nullptr if it is not covered
+    Chunk *const *coveredChunk(int chunkX, int chunkY, int z) const {
+        const size_t levelIndex = size_t(z - firstLevel);
+
+        if (levelIndex >= levels.size()) {
+            return nullptr;
+        }
+
+        const Level &level = levels[levelIndex];
+        const unsigned x = unsigned(chunkX - level.chunkX);
+        const unsigned y = unsigned(chunkY - level.chunkY);
+
+        if (x >= unsigned(level.width) || y >= unsigned(level.height)) {
+            return nullptr;
+        }
+
+        return &level.chunks[y * level.width + x];
+    }
+
+    Chunk **coveredChunk(int chunkX, int chunkY, int z) {
+        return const_cast<Chunk **>(static_cast<const SpecialFieldIndex &>(*this).coveredChunk(chunkX, chunkY, z));
+    }
+
+    const Chunk *findChunk(int chunkX, int chunkY, int z) const {
+        Chunk *const *covered = coveredChunk(chunkX, chunkY, z);
+
+        if (covered) {
+            return *covered;
+        }
+
+        const auto chunk = chunks.find(chunkKey(chunkX, chunkY, z));
+        return chunk == chunks.end() ? nullptr : &chunk->second;
+    }
+
+    void release(std::unordered_map<uint64_t, Chunk>::iterator chunk);
+
+    static uint64_t chunkKey(int chunkX, int chunkY, int z) {
+        return uint64_t(uint16_t(chunkX)) << 32 | uint64_t(uint16_t(chunkY)) << 16 | uint16_t(z);
+    }
+
+    static uint64_t chunkKey(const position &pos) {
+        return chunkKey(pos.x >> CHUNK_BITS, pos.y >> CHUNK_BITS, pos.z);
+    }
+
+    static int row(const position &pos) {
+        return pos.y & (CHUNK_SIZE - 1);
+    }
+
+    static uint64_t bit(const position &pos) {
+        return uint64_t(1) << (pos.x & (CHUNK_SIZE - 1));
+    }
+
+    // owns the chunks, the levels only point into it
+    std::unordered_map<uint64_t, Chunk> chunks;
+    // by z - firstLevel
+    std::vector<Level> levels;
+    int firstLevel = 0;
+    std::array<size_t, kinds> counts = {};
+};
+
+#endif
@@ -27,125 +27,320 @@
 #include "db/Query.hpp"
 #include "World.hpp"
 #include "Logger.hpp"
+#include "Config.hpp"
 #include <chrono>
 #include <algorithm>
 #include <thread>
 #include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
 
 namespace Statistic {
 
-Statistics *Statistics::instance = nullptr;
+const int Histogram::LINEAR_BUCKETS;
+const int Histogram::SUB_BUCKET_BITS;
+const int Histogram::MAX_EXPONENT;
+const int Histogram::BUCKETS;
+const int Statistics::PLAYER_RANGES;
+const size_t Statistics::MAX_METRICS;
+const long Statistics::SAVE_INTERVAL;
+
+Histogram::Histogram() {
+    for (auto &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int Histogram::bucketOf(int value) {
+    if (value < LINEAR_BUCKETS) {
+        return std::max(value, 0);
+    }
+
+    const int exponent = 31 - __builtin_clz(static_cast<unsigned int>(value));
+
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+
+    const int subBucket = (value >> (exponent - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+    return LINEAR_BUCKETS + ((exponent - 6) << SUB_BUCKET_BITS) + subBucket;
+}
+
+int Histogram::lowerBound(int bucket) {
+    if (bucket < LINEAR_BUCKETS) {
+        return bucket;
+    }
+
+    const int exponent = 6 + ((bucket - LINEAR_BUCKETS) >> SUB_BUCKET_BITS);
+    const int subBucket = (bucket - LINEAR_BUCKETS) & ((1 << SUB_BUCKET_BITS) - 1);
+    return (1 << exponent) + (subBucket << (exponent - SUB_BUCKET_BITS));
+}
 
 Statistics::Statistics() {
-    loadTypes();
-    auto typesCount = types.size();
-
-    statisticsDB.resize(typesCount);
-    statistics.resize(typesCount);
-    statisticsSave.resize(typesCount);
-    startTimes.resize(typesCount);
-
-    for (size_t i = 0; i < typesCount; ++i) {
-        for (int j = 0; j < DEFAULT_PLAYERS; ++j) {
-            statisticsDB[i].emplace_back();
-            statistics[i].emplace_back();
-            statisticsSave[i].emplace_back();
-        }
+    for (auto &metric : metrics) {
+        metric.store(0, std::memory_order_relaxed);
     }
 
+    loadTypes();
     versionId = getVersionId();
-    lastSaveTime = getMillisecondsSinceEpoch();
     load();
+    flusher = std::thread(&Statistics::flushLoop, this);
 }
 
 Statistics &Statistics::getInstance() {
-    if (!instance) {
-        instance = new Statistics();
-    }
-    
+    // initialised once even when threads race for it, never destroyed since
+    // threads may still record while static objects are torn down
+    static Statistics *instance = new Statistics();
     return *instance;
 }
 
+int Statistics::typeId(const std::string &type) const {
+    auto it = types.find(type);
+
+    if (it == types.end()) {
+        it = types.find("unknown");
+
+        if (it == types.end()) {
+            return -1;
+        }
+    }
+
+    return it->second;
+}
+
 void Statistics::startTimer(const std::string &type) {
-    int intType;
+    startTimer(typeId(type));
+}
 
-    try {
-        intType = typeToInt(type);
-    } catch (std::out_of_range &e) {
+void Statistics::startTimer(int type) {
+    if (type < 0) {
         return;
     }
 
-    startTimes[intType] = getMillisecondsSinceEpoch();
+    threadData().startTimes[type] = getMillisecondsSinceEpoch();
 }
 
 void Statistics::stopTimer(const std::string &type) {
-    int intType;
+    stopTimer(typeId(type));
+}
 
-    try {
-        intType = typeToInt(type);
-    } catch (std::out_of_range &e) {
+void Statistics::stopTimer(int type) {
+    if (type < 0) {
         return;
-    }   
+    }
 
-    long now = getMillisecondsSinceEpoch();
-    int duration = static_cast<int>(now - startTimes[intType]);
-    startTimes[intType] = now;
-    auto playersOnline = World::get()->Players.size();
+    auto &startTime = threadData().startTimes[type];
+    const long now = getMillisecondsSinceEpoch();
+    const int duration = static_cast<int>(now - startTime);
+    startTime = now;
+    record(type, duration);
+}
 
-    while (statistics[intType].size() <= playersOnline) {
-        statistics[intType].emplace_back();
+void Statistics::logTime(const std::string &type, int duration) {
+    logTime(typeId(type), duration);
+}
+
+void Statistics::logTime(int type, int duration) {
+    if (type < 0) {
+        return;
+    }
+
+    record(type, duration);
+}
+
+void Statistics::record(int type, int duration) {
+    auto &data = threadData();
+    const size_t index = static_cast<size_t>(type) * PLAYER_RANGES + playerRange.load(std::memory_order_relaxed);
+
+    if (index >= data.slotCount) {
+        data.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-    
-    ++statistics[intType][playersOnline][duration];
 
-    if (now - lastSaveTime > SAVE_INTERVAL) {
-        lastSaveTime = now;
+    auto &slot = data.slots[index];
+    slot.histogram.record(duration);
 
-        statistics.swap(statisticsSave);
-        std::thread t(&Statistics::save, this);
-        t.detach();
+    if (!slot.used.load(std::memory_order_relaxed)) {
+        slot.used.store(true, std::memory_order_release);
     }
 }
 
-void Statistics::logTime(const std::string& type, int duration) {
-    int intType;
+Statistics::ThreadData &Statistics::threadData() {
+    static thread_local std::shared_ptr<ThreadData> data;
 
-    try {
-        intType = typeToInt(type);
-    } catch (std::out_of_range &e) {
-        return;
+    if (!data) {
+        data = std::make_shared<ThreadData>((maxType + 1) * PLAYER_RANGES);
+        data->startTimes.resize(maxType + 1, getMillisecondsSinceEpoch());
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        threads.push_back(data);
+    }
+
+    return *data;
+}
+
+int Statistics::counterId(const std::string &counter) {
+    return metricId(counter, false);
+}
+
+int Statistics::gaugeId(const std::string &gauge) {
+    return metricId(gauge, true);
+}
+
+int Statistics::metricId(const std::string &name, bool gauge) {
+    std::lock_guard<std::mutex> lock(metricsMutex);
+    const auto it = metricIds.find(name);
+
+    if (it != metricIds.end()) {
+        return it->second;
     }
-    auto playersOnline = World::get()->Players.size();
 
-    while (statistics[intType].size() <= playersOnline) {
-        statistics[intType].emplace_back();
+    if (metricNames.size() >= MAX_METRICS) {
+        if (!metricsFull) {
+            metricsFull = true;
+            Logger::error(LogFacility::Other) << "statistics have no room for metric " << name << ", it and all further new metrics are dropped" << Log::end;
+        }
+
+        return -1;
     }
 
-    ++statistics[intType][playersOnline][duration];
+    const int id = metricNames.size();
+    metricNames.push_back(name);
+    isGauge.push_back(gauge);
+    metricIds.emplace(name, id);
+    return id;
+}
 
-    long now = getMillisecondsSinceEpoch();
-    if (now - lastSaveTime > SAVE_INTERVAL) {
-        lastSaveTime = now;
+void Statistics::increment(const std::string &counter, int64_t amount) {
+    increment(counterId(counter), amount);
+}
 
-        statistics.swap(statisticsSave);
-        std::thread t(&Statistics::save, this);
-        t.detach();
+void Statistics::increment(int counter, int64_t amount) {
+    if (counter >= 0) {
+        metrics[counter].fetch_add(amount, std::memory_order_relaxed);
     }
 }
 
-int Statistics::typeToInt(const std::string &type) {
-    const auto it = types.find(type);
+void Statistics::setGauge(const std::string &gauge, int64_t value) {
+    setGauge(gaugeId(gauge), value);
+}
 
-    if (it != types.end()) {
-        return it->second;
-    } else {
-        const auto unknownIt = types.find("unknown");
+void Statistics::setGauge(int gauge, int64_t value) {
+    if (gauge >= 0) {
+        metrics[gauge].store(value, std::memory_order_relaxed);
+    }
+}
+
+std::string Statistics::exportText() {
+    collect();
+
+    std::ostringstream text;
 
-        if (unknownIt == types.end()) {
-            throw std::out_of_range("unknown statistic type");
+    {
+        std::lock_guard<std::mutex> lock(totalsMutex);
+
+        for (const auto &bin : totals) {
+            const auto name = typeNames.find(std::get<0>(bin.first));
+
+            text << "statistic{type=\"" << (name == typeNames.end() ? "unknown" : name->second)
+                 << "\",players=\"" << std::get<1>(bin.first)
+                 << "\",bin=\"" << std::get<2>(bin.first) << "\"} " << bin.second << "\n";
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(metricsMutex);
+
+    for (size_t i = 0; i < metricNames.size(); ++i) {
+        text << (isGauge[i] ? "gauge" : "counter") << "{name=\"" << metricNames[i] << "\"} "
+             << metrics[i].load(std::memory_order_relaxed) << "\n";
+    }
+
+    return text.str();
+}
+
+void Statistics::stop() {
+    {
+        std::lock_guard<std::mutex> lock(flusherMutex);
+
+        if (!flusherRunning) {
+            return;
         }
 
-        return unknownIt->second;
+        flusherRunning = false;
+    }
+
+    flusherSignal.notify_all();
+    flusher.join();
+}
+
+void Statistics::flushLoop() {
+    std::unique_lock<std::mutex> lock(flusherMutex);
+
+    while (flusherRunning) {
+        flusherSignal.wait_for(lock, std::chrono::milliseconds(SAVE_INTERVAL));
+
+        lock.unlock();
+        collect();
+        Bins bins;
+
+        {
+            std::lock_guard<std::mutex> totalsLock(totalsMutex);
+            bins.swap(unsaved);
+        }
+
+        save(bins);
+        writeText();
+        lock.lock();
+    }
+}
+
+void Statistics::collect() {
+    std::lock_guard<std::mutex> collectLock(collectMutex);
+    std::vector<std::shared_ptr<ThreadData>> threadList;
+
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        threadList = threads;
+    }
+
+    Bins bins;
+    uint64_t dropped = 0;
+
+    for (const auto &data : threadList) {
+        dropped += data->dropped.exchange(0, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < data->slotCount; ++i) {
+            auto &slot = data->slots[i];
+
+            if (!slot.used.load(std::memory_order_acquire)) {
+                continue;
+            }
+
+            const int type = i / PLAYER_RANGES;
+            const int players = playersOf(i % PLAYER_RANGES);
+            slot.flushed.resize(Histogram::BUCKETS);
+
+            for (int bucket = 0; bucket < Histogram::BUCKETS; ++bucket) {
+                const uint32_t count = slot.histogram.count(bucket);
+
+                if (count != slot.flushed[bucket]) {
+                    bins[BinKey(type, players, Histogram::lowerBound(bucket))] += count - slot.flushed[bucket];
+                    slot.flushed[bucket] = count;
+                }
+            }
+        }
+    }
+
+    if (dropped > 0) {
+        increment(counterId("dropped statistics samples"), dropped);
+        Logger::warn(LogFacility::Other) << "statistics dropped " << dropped << " samples of unknown types" << Log::end;
+    }
+
+    std::lock_guard<std::mutex> lock(totalsMutex);
+
+    for (const auto &bin : bins) {
+        totals[bin.first] += bin.second;
+        unsaved[bin.first] += bin.second;
     }
 }
 
@@ -188,7 +383,11 @@ void Statistics::loadTypes() {
     auto result = query.execute();
 
     for (const auto &row : result) {
-        types.emplace(row["stat_type_name"].as<std::string>(), row["stat_type_id"].as<int>());
+        const auto name = row["stat_type_name"].as<std::string>();
+        const int id = row["stat_type_id"].as<int>();
+        types.emplace(name, id);
+        typeNames.emplace(id, name);
+        maxType = std::max(maxType, id);
     }
 }
 
@@ -211,17 +410,17 @@ void Statistics::load() {
         int bin = row["stat_bin"].as<int>();
         int count = row["stat_count"].as<int>();
 
-        while (statisticsDB[type].size() <= static_cast<size_t>(players_online)) {
-            statisticsDB[type].emplace_back();
-        }
-
-        statisticsDB[type][players_online][bin] = count;
+        statisticsDB[BinKey(type, players_online, bin)] = count;
     }
 }
 
-void Statistics::save() {
+void Statistics::save(const Bins &bins) {
     using namespace Database;
 
+    if (bins.empty()) {
+        return;
+    }
+
     auto connection = ConnectionManager::getInstance().getConnection();
 
     try {
@@ -233,46 +432,32 @@ void Statistics::save() {
         const auto countColumn = insertQuery.addColumn("stat_count");
         insertQuery.addServerTable("statistics");
 
-        int currentType = 0;
-        for (auto &types : statisticsSave) {
-            auto &typeDB = statisticsDB[currentType];
-            int players = 0;
-
-            for (auto &bins : types) {
-                auto &playersDB = typeDB[players];
-
-                for (const auto &bin : bins) {
-                    auto dbIterator = playersDB.find(bin.first);
-
-                    if (dbIterator == playersDB.end()) {
-                        if (bin.second > 0) {
-                            playersDB.insert(bin);
-                            
-                            insertQuery.addValue<int>(versionColumn, versionId);
-                            insertQuery.addValue<int>(typeColumn, currentType);
-                            insertQuery.addValue<int>(playersColumn, players);
-                            insertQuery.addValue<int>(binColumn, bin.first);
-                            insertQuery.addValue<int>(countColumn, bin.second);
-                        }
-                    } else {
-                        dbIterator->second += bin.second;
-                        
-                        Database::UpdateQuery query;
-                        query.addAssignColumn<int>("stat_count", dbIterator->second);
-                        query.addEqualCondition<int>("statistics", "stat_version", versionId);
-                        query.addEqualCondition<int>("statistics", "stat_type", currentType);
-                        query.addEqualCondition<int>("statistics", "stat_players", players);
-                        query.addEqualCondition<int>("statistics", "stat_bin", bin.first);
-                        query.addServerTable("statistics");
-                        query.execute();
-                    }
-                }
-
-                bins.clear();
-                ++players;
+        for (const auto &bin : bins) {
+            const int type = std::get<0>(bin.first);
+            const int players = std::get<1>(bin.first);
+            const int lowerBound = std::get<2>(bin.first);
+            auto dbIterator = statisticsDB.find(bin.first);
+
+            if (dbIterator == statisticsDB.end()) {
+                statisticsDB.insert(bin);
+
+                insertQuery.addValue<int>(versionColumn, versionId);
+                insertQuery.addValue<int>(typeColumn, type);
+                insertQuery.addValue<int>(playersColumn, players);
+                insertQuery.addValue<int>(binColumn, lowerBound);
+                insertQuery.addValue<int>(countColumn, bin.second);
+            } else {
+                dbIterator->second += bin.second;
+
+                Database::UpdateQuery query;
+                query.addAssignColumn<int>("stat_count", dbIterator->second);
+                query.addEqualCondition<int>("statistics", "stat_version", versionId);
+                query.addEqualCondition<int>("statistics", "stat_type", type);
+                query.addEqualCondition<int>("statistics", "stat_players", players);
+                query.addEqualCondition<int>("statistics", "stat_bin", lowerBound);
+                query.addServerTable("statistics");
+                query.execute();
             }
-
-            ++currentType;
         }
 
         insertQuery.execute();
@@ -280,7 +465,30 @@ void Statistics::save() {
         Logger::error(LogFacility::Other) << "saving statistics caught exception: " << e.what() << Log::end;
         connection->rollbackTransaction();
     }
+}
+
+void Statistics::writeText() {
+    const std::string file = Config::instance().statistics_file;
+
+    if (file == "none") {
+        return;
+    }
 
+    // write aside and rename, so readers never see a partial snapshot
+    const std::string temporary = file + ".tmp";
+
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+
+        if (!out) {
+            Logger::error(LogFacility::Other) << "could not write statistics to " << temporary << Log::end;
+            return;
+        }
+
+        out << exportText();
+    }
+
+    std::rename(temporary.c_str(), file.c_str());
 }
 
 long Statistics::getMillisecondsSinceEpoch() const {
@@ -289,4 +497,3 @@ long Statistics::getMillisecondsSinceEpoch() const {
 }
 
 }
-
@@ -22,50 +22,196 @@
 #define _STATISTICS_HPP_
 
 #include <string>
-#include <limits>
+#include <algorithm>
 #include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <unordered_map>
 
 namespace Statistic {
 
+/**
+* log-linear histogram of durations in milliseconds
+*
+* Values below 64 get a bucket each, every following power of two is split
+* into 32 buckets, so the relative error stays below about 3%. Only one
+* thread may record, any thread may read.
+*/
+class Histogram {
+public:
+    static const int LINEAR_BUCKETS = 64;
+    static const int SUB_BUCKET_BITS = 5;
+    static const int MAX_EXPONENT = 20;
+    static const int BUCKETS = LINEAR_BUCKETS + (MAX_EXPONENT - 6) * (1 << SUB_BUCKET_BITS);
+
+    Histogram();
+
+    void record(int value) {
+        auto &bucket = buckets[bucketOf(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    uint32_t count(int bucket) const {
+        return buckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    static int bucketOf(int value);
+
+    //! smallest value counted in the given bucket
+    static int lowerBound(int bucket);
+
+private:
+    std::atomic<uint32_t> buckets[BUCKETS];
+};
+
+/**
+* collects timings, counters and gauges from any thread
+*
+* Timings are recorded into histograms owned by the recording thread, one per
+* statistics type and range of players online. A thread allocates all of
+* them when it records for the first time, so recording neither locks nor
+* allocates and indexes its histogram directly. The player ranges are 0, 1,
+* then powers of two up to 2048 and more, each saved under its lower bound.
+* A flusher thread merges
+* them once a minute, saves the new samples to the database and, if
+* configured, writes a text snapshot of everything to statistics_file.
+* exportText merges on demand for the metrics endpoint.
+*/
 class Statistics {
 public:
     static Statistics &getInstance();
 
+    /**
+    * @return the id of a statistics type, the id of "unknown" if it is not in the database, -1 without "unknown"
+    */
+    int typeId(const std::string &type) const;
+
     void startTimer(const std::string &type);
-    // not thread-safe, collect statistics in main thread only for now
+    void startTimer(int type);
+
+    // records the time since the last start or stop of the timer on this thread
     void stopTimer(const std::string &type);
+    void stopTimer(int type);
+
+    void logTime(const std::string &type, int duration);
+    void logTime(int type, int duration);
+
+    /**
+    * @return the id of a counter or gauge, registering it if necessary, -1 if there are too many
+    */
+    int counterId(const std::string &counter);
+    int gaugeId(const std::string &gauge);
+
+    void increment(const std::string &counter, int64_t amount = 1);
+    void increment(int counter, int64_t amount = 1);
+    void setGauge(const std::string &gauge, int64_t value);
+    void setGauge(int gauge, int64_t value);
+
+    // recorded timings are broken down by the range this number lies in
+    void setPlayersOnline(size_t players) {
+        playerRange.store(playerRangeOf(players), std::memory_order_relaxed);
+    }
+
+    /**
+    * all histograms since server start, counters and gauges in text form,
+    * one value per line, up to date at the time of the call
+    */
+    std::string exportText();
+
+    /**
+    * flushes one last time and stops the flusher thread
+    */
+    void stop();
 
-    // not thread-safe, collect statistics in main thread only for now
-    void logTime(const std::string& type, int duration);
 private:
     Statistics();
     Statistics(const Statistics &) = delete;
     Statistics &operator=(const Statistics &) = delete;
 
-    typedef std::unordered_map<int, int> BinToCount;
-    typedef std::vector<BinToCount> PlayerData;
-    typedef std::vector<PlayerData> StatTypes;
+    static const int PLAYER_RANGES = 13;
+    static const size_t MAX_METRICS = 4096;
+    static const long SAVE_INTERVAL = 60000; // one minute
 
-    static Statistics *instance;
-    
-    int versionId;
+    struct Slot {
+        Histogram histogram;
+        std::atomic<bool> used{false};
+        // only used by the flusher
+        std::vector<uint32_t> flushed;
+    };
+
+    // one slot per type and player range
+    struct ThreadData {
+        explicit ThreadData(size_t slotCount) : slots(new Slot[slotCount]), slotCount(slotCount) {}
+
+        std::unique_ptr<Slot[]> slots;
+        const size_t slotCount;
+        std::vector<long> startTimes;
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    static int playerRangeOf(size_t players) {
+        if (players == 0) {
+            return 0;
+        }
+
+        const int range = 64 - __builtin_clzll(players);
+        return std::min(range, PLAYER_RANGES - 1);
+    }
+
+    //! smallest number of players online in the given range
+    static int playersOf(int range) {
+        return range == 0 ? 0 : 1 << (range - 1);
+    }
+
+    // type, players online, lower bound of the bin in milliseconds
+    typedef std::tuple<int, int, int> BinKey;
+    typedef std::map<BinKey, uint64_t> Bins;
 
+    int versionId;
+    int maxType = 0;
     std::unordered_map<std::string, int> types;
+    std::unordered_map<int, std::string> typeNames;
 
-    StatTypes statisticsDB;
-    StatTypes statistics;
-    StatTypes statisticsSave;
-    
-    std::vector<long> startTimes;
-    static const long SAVE_INTERVAL = 60000; // one minute
-    static const int DEFAULT_PLAYERS = 50;
-    long lastSaveTime;
+    std::atomic<int> playerRange{0};
+
+    std::mutex threadsMutex;
+    std::vector<std::shared_ptr<ThreadData>> threads;
+
+    std::mutex metricsMutex;
+    std::unordered_map<std::string, int> metricIds;
+    std::vector<std::string> metricNames;
+    std::atomic<int64_t> metrics[MAX_METRICS];
+    std::vector<bool> isGauge;
+    bool metricsFull = false;
+
+    // serialises merging the thread histograms
+    std::mutex collectMutex;
+    std::mutex totalsMutex;
+    Bins totals;
+    // merged, but not yet in the database
+    Bins unsaved;
+    Bins statisticsDB;
+
+    std::mutex flusherMutex;
+    std::condition_variable flusherSignal;
+    bool flusherRunning = true;
+    std::thread flusher;
+
+    ThreadData &threadData();
+    int metricId(const std::string &name, bool gauge);
+    void record(int type, int duration);
 
     void loadTypes();
-    int typeToInt(const std::string &type);
     void load();
-    void save();
+    void flushLoop();
+    void collect();
+    void save(const Bins &bins);
+    void writeText();
     int getVersionId();
     long getMillisecondsSinceEpoch() const;
 };
@@ -73,4 +219,3 @@ private:
 }
 
 #endif
-
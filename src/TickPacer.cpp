@@ -0,0 +1,61 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "TickPacer.hpp"
+
+TickPacer::TickPacer(std::chrono::milliseconds step, std::chrono::milliseconds budget, bool fixedStep, clock::time_point start)
+    : step(step > std::chrono::milliseconds::zero() ? step : std::chrono::milliseconds(1)), budget(budget),
+      fixedStep(fixedStep), start(start), tickStart(start) {
+}
+
+int TickPacer::startTick(clock::time_point now) {
+    tickStart = now;
+
+    if (fixedStep) {
+        skew = std::chrono::milliseconds::zero();
+        ++usedSteps;
+        ++ticks;
+        return 1;
+    }
+
+    const uint64_t steps = std::chrono::duration_cast<std::chrono::milliseconds>(now - start) / step;
+
+    if (steps <= usedSteps) {
+        return 0;
+    }
+
+    const auto points = steps - usedSteps;
+    const auto due = start + step * (usedSteps + 1);
+    skew = std::chrono::duration_cast<std::chrono::milliseconds>(now - due);
+    usedSteps = steps;
+    ++ticks;
+    return static_cast<int>(points);
+}
+
+std::chrono::milliseconds TickPacer::finishTick(clock::time_point now) {
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - tickStart);
+    lastOverrun = budget > std::chrono::milliseconds::zero() && duration > budget;
+
+    if (lastOverrun) {
+        return duration - budget;
+    }
+
+    return std::chrono::milliseconds::zero();
+}
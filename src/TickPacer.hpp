@@ -0,0 +1,102 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _TICK_PACER_HPP_
+#define _TICK_PACER_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+/**
+* hands out the action points of the world ticks by a monotonic clock
+*
+* Every step of wall time since the start is worth one action point, a tick
+* starting late gets the missed ones as well. In fixed step mode every tick
+* is worth exactly one action point no matter how much time passed. A tick
+* taking longer than the budget is an overrun, lower priority work should
+* wait for a tick which stays within budget then. In fixed step mode no tick
+* counts as over budget, so neither action points nor deferred work depend on
+* the speed of the machine and a load test replays the same way.
+*/
+class TickPacer {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /**
+    * @param step wall time worth one action point
+    * @param budget time a tick may take, zero for unlimited
+    * @param fixedStep true for one action point per tick
+    * @param start time of the first step
+    */
+    TickPacer(std::chrono::milliseconds step, std::chrono::milliseconds budget, bool fixedStep, clock::time_point start);
+
+    /**
+    * starts a tick
+    * @return the action points of this tick, 0 if no step passed since the last one
+    */
+    int startTick(clock::time_point now);
+
+    /**
+    * finishes the tick started last
+    * @return by how much the tick exceeded its budget, zero if it did not
+    */
+    std::chrono::milliseconds finishTick(clock::time_point now);
+
+    //! how late the current tick started compared to the step it catches up to
+    std::chrono::milliseconds getSkew() const {
+        return skew;
+    }
+
+    //! true if the current tick used up its budget by now, never in fixed step mode
+    bool isOverBudget(clock::time_point now) const {
+        return !fixedStep && budget > std::chrono::milliseconds::zero() && now - tickStart > budget;
+    }
+
+    //! true if the last finished tick exceeded its budget, never in fixed step mode
+    bool wasOverBudget() const {
+        return !fixedStep && lastOverrun;
+    }
+
+    //! steps handed out so far, the game time of the world in units of step
+    uint64_t getSteps() const {
+        return usedSteps;
+    }
+
+    std::chrono::milliseconds getStep() const {
+        return step;
+    }
+
+    uint64_t getTicks() const {
+        return ticks;
+    }
+
+private:
+    std::chrono::milliseconds step;
+    std::chrono::milliseconds budget;
+    bool fixedStep;
+    clock::time_point start;
+    clock::time_point tickStart;
+    std::chrono::milliseconds skew = std::chrono::milliseconds::zero();
+    uint64_t usedSteps = 0;
+    uint64_t ticks = 0;
+    bool lastOverrun = false;
+};
+
+#endif
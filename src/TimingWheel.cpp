@@ -0,0 +1,65 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "TimingWheel.hpp"
+
+#include <algorithm>
+
+void TimingWheel::schedule(TYPE_OF_CHARACTER_ID id, int32_t due) {
+    insert({id, due}, now + 1);
+    ++count;
+}
+
+void TimingWheel::insert(const Entry &entry, int32_t earliest) {
+    const int32_t time = std::max(entry.due, earliest);
+    const int32_t delta = time - now;
+
+    for (int level = 0; level < LEVELS; ++level) {
+        if (delta < (1 << ((level + 1) * SLOT_BITS))) {
+            slots[level][(time >> (level * SLOT_BITS)) & SLOT_MASK].push_back(entry);
+            return;
+        }
+    }
+
+    overflow.push_back(entry);
+}
+
+void TimingWheel::cascade() {
+    for (int level = 1; level <= LEVELS; ++level) {
+        const int shift = level * SLOT_BITS;
+
+        // the finer level has not wrapped around, nothing to split up
+        if ((now & ((1 << shift) - 1)) != 0) {
+            return;
+        }
+
+        std::vector<Entry> entries;
+
+        if (level < LEVELS) {
+            entries.swap(slots[level][(now >> shift) & SLOT_MASK]);
+        } else {
+            entries.swap(overflow);
+        }
+
+        for (const auto &entry : entries) {
+            insert(entry, now);
+        }
+    }
+}
@@ -0,0 +1,100 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _TIMING_WHEEL_HPP_
+#define _TIMING_WHEEL_HPP_
+
+#include <vector>
+#include <stdint.h>
+#include "types.hpp"
+
+/**
+* a hierarchical timing wheel telling which characters have long time
+* effects due
+*
+* Time is counted in ticks. Entries due within the next 64 ticks are kept
+* in per-tick slots, later ones in coarser levels, which are split up into
+* the finer levels as their time comes closer. Advancing the wheel touches
+* only the entries due in that tick, no matter how many are scheduled.
+* Not thread-safe, only to be used from the main thread.
+*/
+class TimingWheel {
+public:
+    /**
+    * adds an entry to the wheel
+    * @param id the character which has something due
+    * @param due the tick in which it is due, past ticks count as the next
+    */
+    void schedule(TYPE_OF_CHARACTER_ID id, int32_t due);
+
+    /**
+    * moves on to the next tick and hands all entries due in it to a handler,
+    * entries scheduled by the handler are not due before the following tick
+    * @param handler called as handler(id, due) for each entry
+    */
+    template<class Handler>
+    void advance(Handler handler) {
+        ++now;
+        cascade();
+
+        std::vector<Entry> due;
+        due.swap(slots[0][now & SLOT_MASK]);
+        count -= due.size();
+
+        for (const auto &entry : due) {
+            handler(entry.id, entry.due);
+        }
+    }
+
+    /**
+    * @return the last tick the wheel advanced to
+    */
+    int32_t getTime() const {
+        return now;
+    }
+
+    /**
+    * @return the number of scheduled entries
+    */
+    size_t size() const {
+        return count;
+    }
+
+private:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int32_t SLOT_MASK = SLOTS - 1;
+    static const int LEVELS = 4;
+
+    struct Entry {
+        TYPE_OF_CHARACTER_ID id;
+        int32_t due;
+    };
+
+    void insert(const Entry &entry, int32_t earliest);
+    void cascade();
+
+    std::vector<Entry> slots[LEVELS][SLOTS];
+    std::vector<Entry> overflow;
+    int32_t now = 0;
+    size_t count = 0;
+};
+
+#endif
@@ -73,6 +73,12 @@ bool WaypointList::recalcStepList() {
     return (!steplist.empty());
 }
 
+void WaypointList::planMove() {
+    if (steplist.empty()) {
+        recalcStepList();
+    }
+}
+
 bool WaypointList::makeMove() {
     if (steplist.empty()) {
         if (!recalcStepList()) {
@@ -38,6 +38,9 @@ public:
     bool makeMove();
     bool recalcStepList();
 
+    // finds the steps for the next makeMove if there are none yet
+    void planMove();
+
 private:
     std::list<position> positions;
     Character *_movechar;
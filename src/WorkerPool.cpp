@@ -0,0 +1,108 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+const size_t WorkerPool::CHUNK_SIZE;
+
+WorkerPool::WorkerPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+        this->threads.emplace_back(&WorkerPool::work, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    started.notify_all();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)> &task) {
+    if (threads.empty() || count <= CHUNK_SIZE) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        this->count = count;
+        next = 0;
+        working = threads.size();
+        ++generation;
+    }
+
+    started.notify_all();
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] {
+        return working == 0;
+    });
+    currentTask = nullptr;
+}
+
+void WorkerPool::work() {
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        started.wait(lock, [this, seen] {
+            return stopping || generation != seen;
+        });
+
+        if (stopping) {
+            return;
+        }
+
+        seen = generation;
+        lock.unlock();
+        runChunks();
+        lock.lock();
+
+        if (--working == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runChunks() {
+    const auto &task = *currentTask;
+
+    for (size_t begin = next.fetch_add(CHUNK_SIZE); begin < count; begin = next.fetch_add(CHUNK_SIZE)) {
+        const size_t end = std::min(begin + CHUNK_SIZE, count);
+
+        for (size_t i = begin; i < end; ++i) {
+            task(i);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _WORKER_POOL_HPP_
+#define _WORKER_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* a fixed set of threads for the parallel parts of a world tick
+*
+* run hands out indices in small chunks and returns once all of them are
+* done, the calling thread works along. Tasks may run in any order and on
+* any thread, so they must neither call Lua nor change the world.
+*/
+class WorkerPool {
+public:
+    // threads in addition to the calling one, 0 runs everything on the caller
+    explicit WorkerPool(size_t threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void run(size_t count, const std::function<void(size_t)> &task);
+
+    size_t size() const {
+        return threads.size();
+    }
+
+private:
+    static const size_t CHUNK_SIZE = 16;
+
+    void work();
+    void runChunks();
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const std::function<void(size_t)> *currentTask = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    size_t generation = 0;
+    size_t working = 0;
+    bool stopping = false;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include <boost/regex.hpp>
 #include <boost/filesystem.hpp>
 #include <algorithm>
+#include <unordered_set>
 #include <sys/types.h>
 
 #include "make_unique.hpp"
@@ -94,8 +95,10 @@ World *World::get() throw(std::runtime_error) {
 World::World(const std::string &dir, time_t starttime) {
     lastTurnIGDay=getTime("day");
 
-    usedAP = 0;
-    timeStart = starttime*1000;
+    tickPacer = std::make_unique<TickPacer>(std::chrono::milliseconds(MIN_AP_UPDATE),
+                                            std::chrono::milliseconds(Config::instance().tick_budget),
+                                            Config::instance().fixed_tick_step != 0, std::chrono::steady_clock::now());
+    nextSpawnStep = SPAWN_INTERVAL / tickPacer->getStep().count();
 
     currentScript = nullptr;
 
@@ -104,6 +107,12 @@ World::World(const std::string &dir, time_t starttime) {
 
     srand((unsigned) time(nullptr));
 
+    const std::string shardSpec = Config::instance().world_shards;
+
+    if (!shards.configure(shardSpec)) {
+        Logger::error(LogFacility::World) << "Invalid world_shards " << shardSpec << ", keeping the world in one shard" << Log::end;
+    }
+
     unsigned int templi = starttime;
     char temparr[ 80 ];
     sprintf(temparr, "%u", templi);
@@ -122,6 +131,16 @@ bool World::load_maps() {
     int numfiles = 0;
     bool ok = true;
 
+    // the imported maps bring their own warps
+    specialFieldIndex.clear(SpecialFieldIndex::warp);
+
+    // the import is saved as a whole, its fields need no journal
+    Field::setTouchLog(nullptr);
+    Container::setTouchLog(nullptr);
+    touchedFields.clear();
+    touchedContainers.clear();
+    journalPositions.clear();
+
     Logger::info(LogFacility::World) << "Removing old maps." << Log::end;
     
     for (boost::filesystem::directory_iterator end, it(Config::instance().datadir() + "map/"); it != end; ++it) {
@@ -148,6 +167,11 @@ bool World::load_maps() {
         ++numfiles;
     }
 
+    if (mapJournal) {
+        Field::setTouchLog(&touchedFields);
+        Container::setTouchLog(&touchedContainers);
+    }
+
     if (numfiles <= 0) {
         perror("Could not import maps");
         return false;
@@ -292,6 +316,7 @@ bool World::load_from_editor(const std::string &filename) {
 
     maptilesfile.close();
     maps.InsertMap(tempmap);
+    specialFieldIndex.cover(tempmap->Z_Level, tempmap->Min_X, tempmap->Min_Y, tempmap->Max_X, tempmap->Max_Y);
 
     // now try to load warpfields
     std::ifstream warpfile((filename + ".warps.txt").c_str());
@@ -344,6 +369,7 @@ bool World::load_from_editor(const std::string &filename) {
         start.x += h_x;
         start.y += h_y;
         GetField(start)->SetWarpField(target);
+        specialFieldIndex.add(start, SpecialFieldIndex::warp);
 
         warpfile >> start.x;
     }
@@ -485,34 +511,86 @@ void World::ignoreComments(std::ifstream &inputStream) {
 }
 
 World::~World() {
+    Field::setTouchLog(nullptr);
+    Container::setTouchLog(nullptr);
 }
 
 
 void World::turntheworld() {
-    ftime(&now);
-    unsigned long timeNow = now.time*1000 + now.millitm;
-
-    ap = timeNow/MIN_AP_UPDATE - timeStart/MIN_AP_UPDATE - usedAP;
+    const auto tickStart = std::chrono::steady_clock::now();
+    ap = std::min(tickPacer->startTick(tickStart), 0x7FFF);
 
     if (ap > 0) {
-        usedAP += ap;
-
         using namespace Statistic;
-
-        Statistics::getInstance().startTimer("cycle player");
+        static const int cyclePlayer = Statistics::getInstance().typeId("cycle player");
+        static const int cycleMonster = Statistics::getInstance().typeId("cycle monster");
+        static const int cycleNPC = Statistics::getInstance().typeId("cycle npc");
+        static const int cycleEffects = Statistics::getInstance().typeId("cycle effects");
+        static const int cycleJournal = Statistics::getInstance().typeId("cycle map journal");
+        static const int tickSkew = Statistics::getInstance().typeId("tick skew");
+        static const int tickOverrun = Statistics::getInstance().typeId("tick overrun");
+        static const int tickOverruns = Statistics::getInstance().counterId("tick overruns");
+        static const int deferredNPCCycles = Statistics::getInstance().counterId("deferred npc cycles");
+        static const int tickDuration = Statistics::getInstance().gaugeId("tick duration us");
+
+        Statistics::getInstance().logTime(tickSkew, tickPacer->getSkew().count());
+
+        Statistics::getInstance().startTimer(cyclePlayer);
         checkPlayers();
-        Statistics::getInstance().stopTimer("cycle player");
+        Statistics::getInstance().stopTimer(cyclePlayer);
 
-        Statistics::getInstance().startTimer("cycle monster");
+        Statistics::getInstance().startTimer(cycleMonster);
         checkMonsters();
-        Statistics::getInstance().stopTimer("cycle monster");
+        Statistics::getInstance().stopTimer(cycleMonster);
 
-        Statistics::getInstance().startTimer("cycle npc");
-        checkNPC();
-        Statistics::getInstance().stopTimer("cycle npc");
+        if (tickPacer->isOverBudget(std::chrono::steady_clock::now()) && deferredNPCTicks < MAX_DEFERRED_NPC_TICKS) {
+            // NPCs get the action points of the skipped ticks once there is time again
+            ++deferredNPCTicks;
+            deferredNPCAP = std::min(deferredNPCAP + ap, 0x7FFF);
+            Statistics::getInstance().increment(deferredNPCCycles);
+        } else {
+            ap = std::min(ap + deferredNPCAP, 0x7FFF);
+            deferredNPCTicks = 0;
+            deferredNPCAP = 0;
+
+            Statistics::getInstance().startTimer(cycleNPC);
+            checkNPC();
+            Statistics::getInstance().stopTimer(cycleNPC);
+        }
+
+        Statistics::getInstance().startTimer(cycleEffects);
+        checkEffects();
+        Statistics::getInstance().stopTimer(cycleEffects);
+
+        Statistics::getInstance().startTimer(cycleJournal);
+        journalMapChanges();
+        Statistics::getInstance().stopTimer(cycleJournal);
+
+        const auto tickEnd = std::chrono::steady_clock::now();
+        Statistics::getInstance().setGauge(tickDuration, std::chrono::duration_cast<std::chrono::microseconds>(tickEnd - tickStart).count());
+
+        const auto overrun = tickPacer->finishTick(tickEnd);
+
+        if (overrun > std::chrono::milliseconds::zero()) {
+            Statistics::getInstance().increment(tickOverruns);
+            Statistics::getInstance().logTime(tickOverrun, overrun.count());
+        }
     }
 }
 
+void World::runWhenIdle(const std::function<void()> &task, const std::string &taskname) {
+    if (!tickPacer->wasOverBudget()) {
+        task();
+        return;
+    }
+
+    using Statistic::Statistics;
+    static const int deferredTasks = Statistics::getInstance().counterId("deferred tasks");
+    Statistics::getInstance().increment(deferredTasks);
+
+    scheduler.addOneshotTask([this, task, taskname] { runWhenIdle(task, taskname); }, std::chrono::seconds(1), taskname);
+}
+
 
 
 void World::checkPlayers() {
@@ -533,7 +611,6 @@ void World::checkPlayers() {
                 player.workoutCommands();
                 player.checkFightMode();
                 player.ltAction->checkAction();
-                player.effects.checkEffects();
             }
             // User timed out.
             else {
@@ -555,7 +632,7 @@ void World::checkPlayers() {
 
             logoutScript->onLogout(playerPointer);
 
-            PlayerManager::get().getLogOutPlayers().push_back(playerPointer);
+            PlayerManager::get().logout(playerPointer);
             sendRemoveCharToVisiblePlayers(player.getId(), pos);
             lostPlayers.push_back(playerPointer);
         }
@@ -645,12 +722,20 @@ bool World::initRespawns() {
 
 }
 
-bool World::getMonsterDefinition(TYPE_OF_CHARACTER_ID type, MonsterStruct &definition) {
-    return MonsterDescriptions->find(type, definition);
+const MonsterStruct *World::getMonsterDefinition(TYPE_OF_CHARACTER_ID type) {
+    return MonsterDescriptions->find(type);
 }
 
 void World::checkMonsters() {
-    if (monstertimer.next()) {
+    if (tickPacer->getSteps() >= nextSpawnStep) {
+        nextSpawnStep = tickPacer->getSteps() + SPAWN_INTERVAL / tickPacer->getStep().count();
+        spawnPending = true;
+    }
+
+    // spawning waits while the world is over budget
+    if (spawnPending && !tickPacer->wasOverBudget()) {
+        spawnPending = false;
+
         if (isSpawnEnabled()) {
             for (auto &spawn : SpawnList) {
                 spawn.spawn();
@@ -665,281 +750,362 @@ void World::checkMonsters() {
     }
 
     std::vector<Monster *> deadMonsters;
+    std::vector<Monster *> actingMonsters;
 
-    Monsters.for_each([this, &deadMonsters](Monster *monsterPointer) {
+    Monsters.for_each([this, &deadMonsters, &actingMonsters](Monster *monsterPointer) {
         Monster &monster = *monsterPointer;
 
         if (monster.isAlive()) {
+            if (!isSimulated(monsterPointer)) {
+                monster.rest();
+                return;
+            }
+
+            if (monster.isResting()) {
+                monster.catchUp(monster.wake());
+            }
+
             monster.increaseActionPoints(ap);
             monster.increaseFightPoints(ap);
-            monster.effects.checkEffects();
-
-            MonsterStruct monStruct;
-            bool foundMonster = MonsterDescriptions->find(monster.getMonsterType(), monStruct) ;
 
             if (monster.canAct()) {
-                if (!monster.getOnRoute()) {
-                    if (monster.getPosition() == monster.lastTargetPosition) {
-                        monster.lastTargetSeen = false;
-                    }
+                actingMonsters.push_back(monsterPointer);
+            }
+        } else {
+            deadMonsters.push_back(monsterPointer);
+        }
+    });
 
-                    Item itl = monster.GetItemAt(LEFT_TOOL);
-                    Item itr = monster.GetItemAt(RIGHT_TOOL);
+    if (!shardTick && Config::instance().world_shard_threads != 0 && shards.size() > 1) {
+        shardTick = std::make_unique<ShardTick>(shards.size(), [this](ShardTick::Id id) {
+            const Monster *monster = Monsters.find(id);
+            return monster ? shards.getShard(monster->getPosition()) : ShardTick::GONE;
+        });
 
-                    uint16_t range=1;
+        Monsters.for_each([this](Monster *monster) {
+            shardTick->adopt(monster->getId(), shards.getShard(monster->getPosition()));
+        });
+    }
 
-                    if (Data::WeaponItems.exists(itr.getId())) {
-                        range = Data::WeaponItems[itr.getId()].Range;
-                    } else if (Data::WeaponItems.exists(itl.getId())) {
-                        range = Data::WeaponItems[itl.getId()].Range;;
-                    }
+    if (!monsterWorkers && !shardTick) {
+        monsterWorkers = std::make_unique<WorkerPool>(Config::instance().monster_threads);
+    }
 
-                    const auto temp = getTargetsInRange(monster.getPosition(), range);
-                    bool has_attacked=false;
-                    Character *target = nullptr;
+    // all monsters look around and plan their paths while the world stands still
+    std::vector<Monster::Intent> intents(actingMonsters.size());
 
-                    if ((!temp.empty()) && monster.canAttack()) {
-                        if (!monStruct.script || !monStruct.script->setTarget(monsterPointer, temp, target)) {
-                            target = standardFightingScript->setTarget(monsterPointer, temp);
-                        }
+    if (shardTick) {
+        thinkInShards(actingMonsters, intents);
+    } else {
+        monsterWorkers->run(actingMonsters.size(), [&actingMonsters, &intents](size_t i) {
+            actingMonsters[i]->think(intents[i]);
+        });
+    }
 
-                        if (target) {
-                            monster.enemyid = target->getId();
-                            monster.enemytype = Character::character_type(target->getType());
-                            monster.lastTargetPosition = target->getPosition();
-                            monster.lastTargetSeen = true;
-
-                            if (foundMonster) {
-                                if (monStruct.script) {
-                                    if (monStruct.script->enemyNear(monsterPointer, target)) {
-                                        return;
-                                    }
-                                }
-                            } else {
-                                Logger::error(LogFacility::Script) << "cant find a monster id for checking the script!" << Log::end;
-                            }
+    // then they act one after the other, in the same order as ever, so the
+    // outcome does not depend on the number of threads
+    for (size_t i = 0; i < actingMonsters.size(); ++i) {
+        Monster &monster = *actingMonsters[i];
 
-                            monster.turn(target->getPosition());
+        if (monster.isAlive()) {
+            applyMonsterIntent(monster, intents[i]);
+        } else {
+            deadMonsters.push_back(&monster);
+        }
+    }
 
-                            if (monster.canFight()) {
-                                has_attacked = characterAttacks(monsterPointer);
-                            } else {
-                                has_attacked = true;
-                            }
-                        }
-                    }
+    for (const auto &monster : deadMonsters) {
+        killMonster(monster->getId());
+    }
 
-                    if (!has_attacked) {
-                        const auto temp = getTargetsInRange(monster.getPosition(), MONSTERVIEWRANGE);
+    for (auto &monster : newMonsters) {
+        Monsters.insert(monster);
 
-                        bool makeRandomStep=true;
+        if (shardTick) {
+            shardTick->adopt(monster->getId(), shards.getShard(monster->getPosition()));
+        }
 
-                        if ((!temp.empty()) && (monster.canAttack())) {
-                            Character *target = nullptr;
+        const MonsterStruct *monStruct = MonsterDescriptions->find(monster->getMonsterType());
 
-                            if (!monStruct.script || !monStruct.script->setTarget(monsterPointer, temp, target)) {
-                                target = standardFightingScript->setTarget(monsterPointer, temp);
-                            }
+        if (monStruct && monStruct->script) {
+            monStruct->script->onSpawn(monster);
+        }
 
-                            if (target) {
-                                monster.lastTargetSeen = true;
-                                monster.lastTargetPosition = target->getPosition();
+    }
 
-                                if (foundMonster) {
-                                    if (monStruct.script) {
-                                        if (monStruct.script->enemyOnSight(monsterPointer, target)) {
-                                            return;
-                                        }
-                                    }
+    newMonsters.clear();
+}
 
-                                    makeRandomStep=false;
-                                    monster.performStep(target->getPosition());
-                                } else {
-                                    Logger::notice(LogFacility::Script) << "cant find the monster id for calling a script!" << Log::end;
-                                }
 
-                            }
-                        } else if (monster.lastTargetSeen) {
-                            makeRandomStep=false;
-                            monster.performStep(monster.lastTargetPosition);
-                        }
+void World::thinkInShards(std::vector<Monster *> &actingMonsters, std::vector<Monster::Intent> &intents) {
+    const std::unordered_set<const Monster *> acting(actingMonsters.begin(), actingMonsters.end());
+    std::vector<std::vector<std::pair<Monster *, Monster::Intent>>> plans(shardTick->size());
 
-                        if (makeRandomStep) {
-                            int tempr = Random::uniform(1, 25);
+    shardTick->run([this, &acting, &plans](size_t shard, ShardTick::Id id) {
+        Monster *monster = Monsters.find(id);
 
-                            MonsterStruct monsterdef;
+        if (acting.count(monster) > 0) {
+            plans[shard].emplace_back(monster, Monster::Intent());
+            monster->think(plans[shard].back().second);
+        }
+    });
 
-                            bool hasDefinition = MonsterDescriptions->find(monster.getMonsterType() , monsterdef);
+    // monsters act shard by shard, and within a shard in the order it owns
+    // them, a monster just handed over to a shard waits for the next tick
+    actingMonsters.clear();
+    intents.clear();
 
-                            if (!hasDefinition) {
-                                Logger::error(LogFacility::World) << "Data for Healing not Found for monsterrace: " << monster.getMonsterType() << Log::end;
-                            }
+    for (auto &shardPlans : plans) {
+        for (auto &plan : shardPlans) {
+            actingMonsters.push_back(plan.first);
+            intents.push_back(std::move(plan.second));
+        }
+    }
+}
 
-                            if (tempr <= 5 && hasDefinition && monsterdef.canselfheal) {
-                                monster.heal();
-                            } else {
-                                SpawnPoint *spawn = monster.getSpawn();
-
-                                direction dir = (direction)Random::uniform(0,7);
-
-                                if (spawn) {
-                                    position newpos = monster.getPosition();
-                                    newpos.move(dir);
-                                    int yoffs = spawn->get_y() - newpos.y;
-                                    int xoffs = spawn->get_x() - newpos.x;
-
-                                    // if walking out of range, mirroring dir. at spawn area border lets the char stay in range with L_inf metric
-                                    if (abs(xoffs) > spawn->getRange()) {
-                                        switch (dir) {
-                                        case dir_northeast:
-                                            dir = dir_northwest;
-                                            break;
-
-                                        case dir_east:
-                                            dir = dir_west;
-                                            break;
-
-                                        case dir_southeast:
-                                            dir = dir_southwest;
-                                            break;
-
-                                        case dir_southwest:
-                                            dir = dir_southeast;
-                                            break;
-
-                                        case dir_west:
-                                            dir = dir_east;
-                                            break;
-
-                                        case dir_northwest:
-                                            dir = dir_northeast;
-                                            break;
-
-                                        default:
-                                            break;
-                                        }
-                                    }
-
-                                    if (abs(yoffs) > spawn->getRange()) {
-                                        switch (dir) {
-                                        case dir_north:
-                                            dir = dir_south;
-                                            break;
-
-                                        case dir_northeast:
-                                            dir = dir_southeast;
-                                            break;
-
-                                        case dir_southeast:
-                                            dir = dir_northeast;
-                                            break;
-
-                                        case dir_south:
-                                            dir = dir_north;
-                                            break;
-
-                                        case dir_southwest:
-                                            dir = dir_northwest;
-                                            break;
-
-                                        case dir_northwest:
-                                            dir = dir_southwest;
-                                            break;
-
-                                        default:
-                                            break;
-                                        }
-                                    }
-                                }
-
-                                monster.move(dir);
-
-                                // movementrate below normal if noone is near
-                                monster.increaseActionPoints(-20);
-                            }
+void World::applyMonsterIntent(Monster &monster, Monster::Intent &intent) {
+    Monster *monsterPointer = &monster;
+    const MonsterStruct *monStruct = MonsterDescriptions->find(monster.getMonsterType());
+    const bool foundMonster = monStruct != nullptr;
+    LuaMonsterScript *script = foundMonster ? monStruct->script.get() : nullptr;
+
+    // monsters acting before this one may have moved or killed its targets
+    const auto targetsNear = resolveTargets(intent.targetsNear, monster.getPosition(), monster.getAttackRange());
+    const auto targetsInSight = resolveTargets(intent.targetsInSight, monster.getPosition(), MONSTERVIEWRANGE);
+
+    if (!monster.getOnRoute()) {
+        if (monster.getPosition() == monster.lastTargetPosition) {
+            monster.lastTargetSeen = false;
+        }
+
+        const auto &temp = targetsNear;
+        bool has_attacked=false;
+        Character *target = nullptr;
+
+        if ((!temp.empty()) && monster.canAttack()) {
+            if (!script || !script->setTarget(monsterPointer, temp, target)) {
+                target = standardFightingScript->setTarget(monsterPointer, temp);
+            }
+
+            if (target) {
+                monster.enemyid = target->getId();
+                monster.enemytype = Character::character_type(target->getType());
+                monster.lastTargetPosition = target->getPosition();
+                monster.lastTargetSeen = true;
+
+                if (foundMonster) {
+                    if (script) {
+                        if (script->enemyNear(monsterPointer, target)) {
+                            return;
                         }
                     }
                 } else {
-                    Item itl = monster.GetItemAt(LEFT_TOOL);
-                    Item itr = monster.GetItemAt(RIGHT_TOOL);
+                    Logger::error(LogFacility::Script) << "cant find a monster id for checking the script!" << Log::end;
+                }
 
-                    uint16_t range=1;
+                monster.turn(target->getPosition());
 
-                    if (Data::WeaponItems.exists(itr.getId())) {
-                        range = Data::WeaponItems[itr.getId()].Range;
-                    } else if (Data::WeaponItems.exists(itl.getId())) {
-                        range = Data::WeaponItems[itl.getId()].Range;;
-                    }
+                if (monster.canFight()) {
+                    has_attacked = characterAttacks(monsterPointer);
+                } else {
+                    has_attacked = true;
+                }
+            }
+        }
 
-                    const auto temp = getTargetsInRange(monster.getPosition(), range);
+        if (!has_attacked) {
+            const auto &temp = targetsInSight;
 
-                    if (!temp.empty()) {
-                        Character *target = nullptr;
-                        
-                        if (!monStruct.script || !monStruct.script->setTarget(monsterPointer, temp, target)) {
-                            target = standardFightingScript->setTarget(monsterPointer, temp);
-                        }
+            bool makeRandomStep=true;
+
+            if ((!temp.empty()) && (monster.canAttack())) {
+                Character *target = nullptr;
 
-                        if (target) {
-                            if (foundMonster && monStruct.script) {
-                                monStruct.script->enemyNear(monsterPointer, target);
-                            } else {
-                                Logger::error(LogFacility::World) << "cant find a monster id for checking the script!" << Log::end;
+                if (!script || !script->setTarget(monsterPointer, temp, target)) {
+                    target = standardFightingScript->setTarget(monsterPointer, temp);
+                }
+
+                if (target) {
+                    monster.lastTargetSeen = true;
+                    monster.lastTargetPosition = target->getPosition();
+
+                    if (foundMonster) {
+                        if (script) {
+                            if (script->enemyOnSight(monsterPointer, target)) {
+                                return;
                             }
                         }
+
+                        makeRandomStep=false;
+                        monster.performStep(target->getPosition());
+                    } else {
+                        Logger::notice(LogFacility::Script) << "cant find the monster id for calling a script!" << Log::end;
                     }
 
-                    const auto temp2 = getTargetsInRange(monster.getPosition(), MONSTERVIEWRANGE);
+                }
+            } else if (monster.lastTargetSeen) {
+                makeRandomStep=false;
+                monster.performStep(monster.lastTargetPosition);
+            }
 
-                    if (!temp2.empty()) {
-                        Character *target = nullptr;
+            if (makeRandomStep) {
+                int tempr = Random::uniform(1, 25);
 
-                        if (!monStruct.script || !monStruct.script->setTarget(monsterPointer, temp2, target)) {
-                            target = standardFightingScript->setTarget(monsterPointer, temp2);
-                        }
+                if (!foundMonster) {
+                    Logger::error(LogFacility::World) << "Data for Healing not Found for monsterrace: " << monster.getMonsterType() << Log::end;
+                }
+
+                if (tempr <= 5 && foundMonster && monStruct->canselfheal) {
+                    monster.heal();
+                } else {
+                    SpawnPoint *spawn = monster.getSpawn();
+
+                    direction dir = (direction)Random::uniform(0,7);
+
+                    if (spawn) {
+                        position newpos = monster.getPosition();
+                        newpos.move(dir);
+                        int yoffs = spawn->get_y() - newpos.y;
+                        int xoffs = spawn->get_x() - newpos.x;
+
+                        // if walking out of range, mirroring dir. at spawn area border lets the char stay in range with L_inf metric
+                        if (abs(xoffs) > spawn->getRange()) {
+                            switch (dir) {
+                            case dir_northeast:
+                                dir = dir_northwest;
+                                break;
+
+                            case dir_east:
+                                dir = dir_west;
+                                break;
+
+                            case dir_southeast:
+                                dir = dir_southwest;
+                                break;
 
-                        if (target) {
-                            if (foundMonster && monStruct.script) {
-                                monStruct.script->enemyOnSight(monsterPointer, target);
+                            case dir_southwest:
+                                dir = dir_southeast;
+                                break;
+
+                            case dir_west:
+                                dir = dir_east;
+                                break;
+
+                            case dir_northwest:
+                                dir = dir_northeast;
+                                break;
+
+                            default:
+                                break;
                             }
                         }
-                    }
 
-                    if (!monster.waypoints.makeMove()) {
-                        monster.setOnRoute(false);
+                        if (abs(yoffs) > spawn->getRange()) {
+                            switch (dir) {
+                            case dir_north:
+                                dir = dir_south;
+                                break;
 
-                        if (foundMonster && monStruct.script) {
-                            monStruct.script->abortRoute(monsterPointer);
-                        } else {
-                            Logger::notice(LogFacility::Script) << "cant find the monster id for calling a script!" << Log::end;
+                            case dir_northeast:
+                                dir = dir_southeast;
+                                break;
+
+                            case dir_southeast:
+                                dir = dir_northeast;
+                                break;
+
+                            case dir_south:
+                                dir = dir_north;
+                                break;
+
+                            case dir_southwest:
+                                dir = dir_northwest;
+                                break;
+
+                            case dir_northwest:
+                                dir = dir_southwest;
+                                break;
+
+                            default:
+                                break;
+                            }
                         }
                     }
+
+                    monster.move(dir);
+
+                    // movementrate below normal if noone is near
+                    monster.increaseActionPoints(-20);
                 }
             }
-        } else {
-            deadMonsters.push_back(monsterPointer);
         }
-    });
+    } else {
+        const auto &temp = targetsNear;
 
-    for (const auto &monster : deadMonsters) {
-        killMonster(monster->getId());
+        if (!temp.empty()) {
+            Character *target = nullptr;
+            
+            if (!script || !script->setTarget(monsterPointer, temp, target)) {
+                target = standardFightingScript->setTarget(monsterPointer, temp);
+            }
+
+            if (target) {
+                if (foundMonster && script) {
+                    script->enemyNear(monsterPointer, target);
+                } else {
+                    Logger::error(LogFacility::World) << "cant find a monster id for checking the script!" << Log::end;
+                }
+            }
+        }
+
+        const auto &temp2 = targetsInSight;
+
+        if (!temp2.empty()) {
+            Character *target = nullptr;
+
+            if (!script || !script->setTarget(monsterPointer, temp2, target)) {
+                target = standardFightingScript->setTarget(monsterPointer, temp2);
+            }
+
+            if (target) {
+                if (foundMonster && script) {
+                    script->enemyOnSight(monsterPointer, target);
+                }
+            }
+        }
+
+        if (!monster.waypoints.makeMove()) {
+            monster.setOnRoute(false);
+
+            if (foundMonster && script) {
+                script->abortRoute(monsterPointer);
+            } else {
+                Logger::notice(LogFacility::Script) << "cant find the monster id for calling a script!" << Log::end;
+            }
+        }
     }
+}
 
-    for (auto &monster : newMonsters) {
-        Monsters.insert(monster);
-        MonsterStruct monStruct;
-        bool foundMonster = MonsterDescriptions->find(monster->getMonsterType(), monStruct) ;
+std::vector<Character *> World::resolveTargets(const std::vector<Monster::Intent::Target> &targets, const position &pos, int range) const {
+    std::vector<Character *> resolved;
 
-        if (foundMonster && monStruct.script) {
-            monStruct.script->onSpawn(monster);
+    for (const auto &target : targets) {
+        Character *character = target.player ? static_cast<Character *>(Players.find(target.handle)) : Monsters.find(target.handle);
+
+        if (!character || !character->isAlive()) {
+            continue;
         }
 
+        const position &targetPos = character->getPosition();
+
+        if (targetPos.z == pos.z && abs(targetPos.x - pos.x) <= range && abs(targetPos.y - pos.y) <= range) {
+            resolved.push_back(character);
+        }
     }
 
-    newMonsters.clear();
+    return resolved;
 }
 
-
 std::vector<Character *> World::getTargetsInRange(const position &pos, int radius) const {
     Range range;
     range.radius = radius;
@@ -958,6 +1124,19 @@ std::vector<Character *> World::getTargetsInRange(const position &pos, int radiu
     return targets;
 }
 
+std::vector<Monster::Intent::Target> World::getTargetHandlesInRange(const position &pos, int radius) const {
+    std::vector<Monster::Intent::Target> handles;
+
+    for (const auto &target : getTargetsInRange(pos, radius)) {
+        Monster::Intent::Target handle;
+        handle.player = target->getType() == Character::player;
+        handle.handle = handle.player ? Players.getHandle(target->getId()) : Monsters.getHandle(target->getId());
+        handles.push_back(handle);
+    }
+
+    return handles;
+}
+
 
 void World::checkNPC() {
     deleteAllLostNPC();
@@ -965,8 +1144,13 @@ void World::checkNPC() {
     Npc.for_each([this](NPC* npc) {
 
         if (npc->isAlive()) {
+            if (!isSimulated(npc)) {
+                npc->rest();
+                return;
+            }
+
+            npc->wake();
             npc->increaseActionPoints(ap);
-            npc->effects.checkEffects();
             std::shared_ptr<LuaNPCScript> npcScript = npc->getScript();
 
             if (npc->canAct() && npcScript) {
@@ -978,13 +1162,24 @@ void World::checkNPC() {
                 }
             }
         } else {
-            npc->increaseAttrib("hitpoints", MAXHPS);
+            npc->increaseAttribute(Character::hitpoints, MAXHPS);
             sendSpinToAllVisiblePlayers(npc);
         }
     });
 }
 
 
+void World::checkEffects() {
+    effectWheel.advance([this](TYPE_OF_CHARACTER_ID id, int32_t scheduledTime) {
+        Character *character = findCharacter(id);
+
+        if (character) {
+            character->effects.checkEffects(scheduledTime);
+        }
+    });
+}
+
+
 void World::workout_CommandBuffer(Player *&cp) {
 }
 
@@ -1029,10 +1224,17 @@ void World::initScheduler() {
     scheduler.addRecurringTask([&] { Players.for_each(reduceMC); }, std::chrono::seconds(10), "increase_player_learn_points");
     scheduler.addRecurringTask([&] { Monsters.for_each(reduceMC); Npc.for_each(reduceMC); }, std::chrono::seconds(10), "increase_monster_learn_points");
     scheduler.addRecurringTask([&] { monitoringClientList->CheckClients(); }, std::chrono::milliseconds(250), "check_monitoring_clients");
+    scheduler.addRecurringTask([&] { monitoringClientList->flush(); }, std::chrono::milliseconds(std::max<uint16_t>(Config::instance().monitoring_interval, 10)), "flush_monitoring_clients");
     scheduler.addRecurringTask([&] { scheduledScripts->nextCycle(); }, std::chrono::seconds(1), "check_scheduled_scripts");
-    scheduler.addRecurringTask([&] { ageInventory(); }, std::chrono::minutes(3), "age_inventory");
-    scheduler.addRecurringTask([&] { ageMaps(); }, std::chrono::minutes(3), "age_maps");
+    scheduler.addRecurringTask([&] { runWhenIdle([this] { ageInventory(); }, "age_inventory"); }, std::chrono::minutes(3), "age_inventory");
+    scheduler.addRecurringTask([&] { runWhenIdle([this] { ageMaps(); }, "age_maps"); }, std::chrono::minutes(3), "age_maps");
     scheduler.addRecurringTask([&] { turntheworld(); }, std::chrono::milliseconds(100), "turntheworld");
+    scheduler.addRecurringTask([&] { updateMetrics(); }, std::chrono::seconds(1), "update_metrics");
+    scheduler.addRecurringTask([&] { updateActivity(); }, std::chrono::seconds(1), "update_activity", true);
+
+    if (shards.size() > 1) {
+        scheduler.addRecurringTask([&] { updateShardStatistics(); }, std::chrono::seconds(10), "update_shard_statistics", true);
+    }
     scheduler.addRecurringTask([&] { sendIGTimeToAllPlayers(); }, std::chrono::hours(8), getNextIGDayTime(), "update_ig_day");
 }
 
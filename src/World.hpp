@@ -31,18 +31,29 @@
 //falls nicht auskommentiert, werden die Gespraeche der Player gespeichert
 #define   LOG_TALK
 
-#include <sys/timeb.h>
 
 #include <memory>
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 #include <boost/regex.hpp>
 
 #include "NewClientView.hpp"
+#include "MapStripeCache.hpp"
+#include "DialogCache.hpp"
+#include "ActivityMap.hpp"
+#include "TimingWheel.hpp"
+#include "WorkerPool.hpp"
+#include "WorldShards.hpp"
+#include "ShardTick.hpp"
+#include "TickPacer.hpp"
+#include "SpecialFieldIndex.hpp"
+#include "MapJournal.hpp"
 #include "CharacterContainer.hpp"
 #include "SpawnPoint.hpp"
 #include "TableStructs.hpp"
 #include "Character.hpp"
+#include "Monster.hpp"
 #include "Language.hpp"
 #include "Timer.hpp"
 #include "MilTimer.hpp"
@@ -144,9 +155,48 @@ struct BlockingObject {
 class World {
 
 public:
-    /////////////////////////
-    NewClientView clientview;
-    /////////////////////////
+    /**
+    * encoded map stripes shared by all players
+    */
+    MapStripeCache mapStripes;
+
+    /**
+    * encoded merchant and crafting dialogs shared by all players
+    */
+    DialogCache dialogCache;
+
+    /**
+    * regions close to players, only there monsters and NPCs are simulated
+    */
+    ActivityMap activity;
+
+    /**
+    * tells which characters have long time effects due, advanced once per
+    * turn of the world
+    */
+    TimingWheel effectWheel;
+
+    /**
+    * the shards the map is divided into by world_shards, with
+    * world_shard_threads their monsters are ticked on a thread per shard
+    */
+    WorldShards shards;
+
+    /**
+    * warps and triggers of the map, warps are kept in sync by addWarpField
+    * and removeWarpField, triggers are reindexed whenever the tables were
+    * reloaded
+    */
+    SpecialFieldIndex specialFieldIndex;
+
+    /**
+    * checks if a monster or NPC needs to be simulated in this tick
+    * @param cc the character to check
+    * @return true if it is close to a player or marked as always active
+    */
+    bool isSimulated(const Character *cc) const {
+        return cc->isAlwaysActive() || activity.isActive(cc->getPosition());
+    }
 
     /**
     *a typedef for holding Players
@@ -195,20 +245,16 @@ public:
     NPCVECTOR Npc;
 
     /**
-    *npcs which should be deleted
+    *npcs which should be deleted, by handle since the same npc may be
+    *deleted twice and its id may be given to a new one meanwhile
     */
-    std::vector< TYPE_OF_CHARACTER_ID > LostNpcs;
+    std::vector<CharacterHandle> LostNpcs;
 
     /**
      * holds the monitoring clients on the World
      */
     std::unique_ptr<MonitoringClients> monitoringClientList = nullptr;
 
-    timeb now; /**< current time of the server used in @see turntheworld() **/
-
-    unsigned long int timeStart;
-    unsigned long int usedAP;
-
     short int ap; /**< actionpoints since the last loop call **/
 
     WorldMap maps; /**< a vector which holds all the maps*/
@@ -270,7 +316,7 @@ public:
 
     void invalidatePlayerDialogs();
 
-    virtual bool getMonsterDefinition(TYPE_OF_CHARACTER_ID type, MonsterStruct &definition);
+    virtual const MonsterStruct *getMonsterDefinition(TYPE_OF_CHARACTER_ID type);
 
     /**
     *checks all actions of the monsters and updates them
@@ -282,6 +328,11 @@ public:
     */
     void checkNPC();
 
+    /**
+    *calls the long time effects of all characters which have some due
+    */
+    void checkEffects();
+
     /**
     *init method for npc's
     *loads the npc's from the db and sets them on the map
@@ -437,6 +488,36 @@ public:
 
     bool findEmptyCFieldNear(Field *&cf, position &pos);
 
+    enum itemAttributeIndex {
+        ia_bodyparts,
+        ia_strokearmor,
+        ia_thrustarmor,
+        ia_armormagicdisturbance,
+        ia_agingspeed,
+        ia_objectafterrot,
+        ia_weight,
+        ia_modificator,
+        ia_accuracy,
+        ia_attack,
+        ia_defence,
+        ia_range,
+        ia_weapontype,
+        ia_weaponmagicdisturbance,
+        ia_unknown
+    };
+
+    typedef std::unordered_map<std::string, itemAttributeIndex> item_attribute_map_t;
+    static item_attribute_map_t itemAttributeMap;
+
+    /**
+    * resolves an item attribute name to its index, resolve once and reuse the
+    * index with getItemAttrib(itemAttributeIndex, TYPE_OF_ITEM_ID)
+    * @param s the name of the attribute
+    * @return the attribute index or ia_unknown
+    */
+    static itemAttributeIndex getItemAttribIndex(const std::string &s);
+
+    int getItemAttrib(itemAttributeIndex attribute, TYPE_OF_ITEM_ID ItemID);
     int getItemAttrib(const std::string &s, TYPE_OF_ITEM_ID ItemID);
 
     /**
@@ -448,7 +529,8 @@ public:
     void updatePlayerView(short int startx, short int endx);
 
     void Load();
-    void Save();
+    // writes a snapshot of all maps, false if it could not be written completely
+    bool Save();
 
     /**
     *@brief changes one part of the weather and sends the new weather to all players
@@ -1079,14 +1161,18 @@ private:
     //! IG day of last turntheworld
     int lastTurnIGDay;
 
-    // check spawns every minute
-    Timer monstertimer = {60};
+    // check spawns every minute of game time, counted in steps of tickPacer
+    static const int SPAWN_INTERVAL = 60000; // milliseconds
+    uint64_t nextSpawnStep = 0;
 
     //! das home-Verzeichnis des Servers
     std::string directory;
 
     void ageMaps();
     void ageInventory();
+    void updateMetrics();
+    void updateActivity();
+    void updateShardStatistics();
 
     //! das Verzeichnis mit den Skripten
     std::string scriptDir;
@@ -1136,8 +1222,93 @@ public:
     void checkPlayerImmediateCommands();
     void addPlayerImmediateActionQueue(Player* player);
 
-private:
+    /**
+    * @return all living players and monsters within range of pos on its level, except monsters at pos
+    */
     std::vector<Character *> getTargetsInRange(const position &pos, int range) const;
+
+    /**
+    * @return handles to the targets getTargetsInRange finds
+    */
+    std::vector<Monster::Intent::Target> getTargetHandlesInRange(const position &pos, int range) const;
+
+private:
+    /**
+    * lets a monster act on what it found out in Monster::think
+    * @param monster the monster to act, alive and able to act
+    * @param intent the targets found by think, stale ones are dropped first
+    */
+    void applyMonsterIntent(Monster &monster, Monster::Intent &intent);
+
+    /**
+    * @return the targets which are still there, alive and in range of pos
+    */
+    std::vector<Character *> resolveTargets(const std::vector<Monster::Intent::Target> &targets, const position &pos, int range) const;
+
+    // runs Monster::think for all acting monsters in parallel
+    std::unique_ptr<WorkerPool> monsterWorkers;
+
+    // runs Monster::think on a thread per shard instead, with world_shard_threads
+    std::unique_ptr<ShardTick> shardTick;
+
+    /**
+    * lets every monster think on the thread of its shard, the intents of
+    * the acting ones are collected per shard in the order they thought
+    */
+    void thinkInShards(std::vector<Monster *> &actingMonsters, std::vector<Monster::Intent> &intents);
+
+    // action points, budget and overruns of turntheworld
+    std::unique_ptr<TickPacer> tickPacer;
+
+    // NPCs wait for a tick within budget, but for at most this many ticks
+    static const int MAX_DEFERRED_NPC_TICKS = 10;
+    int deferredNPCTicks = 0;
+    short int deferredNPCAP = 0;
+
+    // set when spawning was due while the world was over budget
+    bool spawnPending = false;
+
+    // table generation the triggers in specialFieldIndex are from
+    uint32_t indexedTriggerGeneration = 0;
+    bool triggersIndexed = false;
+
+    // adds the warps loaded with a map to specialFieldIndex
+    void indexWarpFields(const WorldMap::map_t &map, short int z);
+
+    // records the map changes between two snapshots, nullptr if switched off
+    std::unique_ptr<MapJournal> mapJournal;
+    // fields changed in the current tick, filled by Field::touch
+    std::vector<const Field *> touchedFields;
+    // outermost containers changed in the current tick, filled by Container::touch
+    std::vector<const Container *> touchedContainers;
+    // positions to journal at the end of the current tick
+    std::unordered_set<position> journalPositions;
+    uint64_t reportedJournalFailures = 0;
+
+    /**
+    * replays the map journal over the loaded snapshot, folds it into a new
+    * snapshot and starts recording map changes if map_journal is set
+    */
+    void openMapJournal();
+
+    // true once every file of the last snapshot is synced to disk
+    bool syncSnapshot();
+
+    // hands the fields changed in this tick to the map journal as one batch
+    void journalMapChanges();
+
+    // a field with the containers lying on it, as recorded in the map journal
+    std::string encodeJournalRecord(const position &pos, Map &map, Field &field) const;
+    void applyJournalRecord(const std::string &record);
+
+    // true if pos has a trigger script, reindexes the triggers after a reload
+    bool isTriggerField(const position &pos);
+
+    /**
+    * runs task now, or retries it a second later while the last tick was
+    * over budget, for work which may wait like aging
+    */
+    void runWhenIdle(const std::function<void()> &task, const std::string &taskname);
     
     bool active_language_command(Player *cp, const std::string &language);
 
@@ -417,7 +417,7 @@ void World::forceLogoutOfAllPlayers() {
         sendMonitoringMessage(message);
         ServerCommandPointer cmd = std::make_shared<LogOutTC>(SERVERSHUTDOWN);
         player->Connection->shutdownSend(cmd);
-        PlayerManager::get().getLogOutPlayers().push_back(player);
+        PlayerManager::get().logout(player);
     });
 
     Players.clear();
@@ -978,6 +978,11 @@ bool World::reload_defs(Player *cp) {
         ok = Data::reload();
     }
 
+    if (ok) {
+        // cached stripes contain movement costs from the old tile data
+        mapStripes.clear();
+    }
+
     if (ok) {
         MonsterDescriptions_temp = new MonsterTable();
 
@@ -1177,6 +1182,7 @@ void create_area_command(World *world, Player *player,const std::string &params)
         }
 
     world->maps.InsertMap(tempmap);
+    world->specialFieldIndex.cover(tempmap->Z_Level, tempmap->Min_X, tempmap->Min_Y, tempmap->Max_X, tempmap->Max_Y);
 
     std::string tmessage = "Map inserted.";
     player->inform(tmessage);
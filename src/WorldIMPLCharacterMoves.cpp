@@ -81,7 +81,7 @@ void World::checkFieldAfterMove(Character *cc, Field *cfstart) {
         }
     }
 
-    if (cc->isAlive() && Data::Triggers.exists(cc->getPosition())) {
+    if (cc->isAlive() && isTriggerField(cc->getPosition())) {
         const auto &script = Data::Triggers.script(cc->getPosition());
 
         if (script) {
@@ -90,8 +90,25 @@ void World::checkFieldAfterMove(Character *cc, Field *cfstart) {
     }
 }
 
+bool World::isTriggerField(const position &pos) {
+    const auto generation = Data::getTableGeneration();
+
+    if (!triggersIndexed || indexedTriggerGeneration != generation) {
+        specialFieldIndex.clear(SpecialFieldIndex::trigger);
+
+        for (const auto &trigger : Data::Triggers) {
+            specialFieldIndex.add(trigger.first, SpecialFieldIndex::trigger);
+        }
+
+        indexedTriggerGeneration = generation;
+        triggersIndexed = true;
+    }
+
+    return specialFieldIndex.has(pos, SpecialFieldIndex::trigger);
+}
+
 void World::TriggerFieldMove(Character *cc, bool moveto) {
-    if (cc && cc->isAlive() && Data::Triggers.exists(cc->getPosition())) {
+    if (cc && cc->isAlive() && isTriggerField(cc->getPosition())) {
         const auto &script = Data::Triggers.script(cc->getPosition());
 
         if (script) {
@@ -105,6 +122,21 @@ void World::TriggerFieldMove(Character *cc, bool moveto) {
 }
 
 void World::moveTo(Character *cc, const position& to) {
+    if (shards.size() > 1) {
+        const size_t from = shards.getShard(cc->getPosition());
+        const size_t into = shards.getShard(to);
+
+        if (from != into) {
+            using Statistic::Statistics;
+            static const int crossShardMoves = Statistics::getInstance().counterId("cross shard moves");
+            Statistics::getInstance().increment(crossShardMoves);
+
+            if (shardTick && cc->getType() == Character::monster) {
+                shardTick->handOver(cc->getId(), from, into);
+            }
+        }
+    }
+
     switch(cc->getType()) {
         case Character::player:
             Players.update(dynamic_cast<Player *>(cc), to);
@@ -253,6 +285,7 @@ bool World::addWarpField(const position &where, const position &target, unsigned
 
         cfstart->SetWarpField(target);
         cfstart->updateFlags();
+        specialFieldIndex.add(where, SpecialFieldIndex::warp);
 
         return true;
     } else {
@@ -310,6 +343,7 @@ bool World::removeWarpField(const position &where) {
 
     if (GetPToCFieldAt(cfstart, where)) {
         cfstart->UnsetWarpField();
+        specialFieldIndex.remove(where, SpecialFieldIndex::warp);
         return true;
     }
 
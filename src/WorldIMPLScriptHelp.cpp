@@ -56,7 +56,7 @@ bool World::deleteNPC(unsigned int npcid) {
         }
     }
     return false;*/
-    LostNpcs.push_back(npcid);
+    LostNpcs.push_back(Npc.getHandle(npcid));
     return true;
 }
 
@@ -595,6 +595,7 @@ bool World::createSavedArea(uint16_t tileid, const position &pos, uint16_t heigh
         }
 
     maps.InsertMap(tempmap);
+    specialFieldIndex.cover(tempmap->Z_Level, tempmap->Min_X, tempmap->Min_Y, tempmap->Max_X, tempmap->Max_Y);
     Logger::info(LogFacility::World) << "Map created by createSavedArea command at " << pos << " height: " << height << " width: " << width << " standard tile: " << tileid << "!" << Log::end;
     return true;
 }
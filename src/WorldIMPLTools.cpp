@@ -20,7 +20,10 @@
 
 #include "World.hpp"
 
+#include <array>
+#include <cstdio>
 #include <list>
+#include <sstream>
 #include <stdlib.h>
 
 #include "Player.hpp"
@@ -28,6 +31,8 @@
 #include "Monster.hpp"
 #include "Field.hpp"
 #include "Map.hpp"
+#include "Config.hpp"
+#include "make_unique.hpp"
 
 #include "data/Data.hpp"
 #include "data/ArmorObjectTable.hpp"
@@ -52,7 +57,7 @@ extern std::shared_ptr<LuaWeaponScript> standardFightingScript;
 void World::deleteAllLostNPC() {
     Field *tempf;
 
-    for (const TYPE_OF_CHARACTER_ID &npcToDelete : LostNpcs) {
+    for (const auto &npcToDelete : LostNpcs) {
         const auto &npc = Npc.find(npcToDelete);
 
         if (npc) {
@@ -61,6 +66,7 @@ void World::deleteAllLostNPC() {
             }
 
             sendRemoveCharToVisiblePlayers(npc->getId(), npc->getPosition());
+            Npc.erase(npc->getId());
             delete npc;
         }
     }
@@ -422,12 +428,10 @@ bool World::characterAttacks(Character *cp) {
 
             if (temppl != nullptr) {
                 if (cp->isInRange(temppl, temppl->getScreenRange())) {
-                    MonsterStruct monStruct;
+                    const MonsterStruct *monStruct = MonsterDescriptions->find(temppl->getMonsterType());
 
-                    if (MonsterDescriptions->find(temppl->getMonsterType(), monStruct)) {
-                        if (monStruct.script) {
-                            monStruct.script->onAttacked(temppl,cp);
-                        }
+                    if (monStruct && monStruct->script) {
+                        monStruct->script->onAttacked(temppl,cp);
                     }
 
                     if (!cp->attack(temppl)) {
@@ -555,84 +559,132 @@ bool World::findEmptyCFieldNear(Field *&cf, position &pos) {
 }
 
 
+World::item_attribute_map_t World::itemAttributeMap = {
+    {"bodyparts", ia_bodyparts},
+    {"strokearmor", ia_strokearmor},
+    {"thrustarmor", ia_thrustarmor},
+    {"armormagicdisturbance", ia_armormagicdisturbance},
+    {"agingspeed", ia_agingspeed},
+    {"objectafterrot", ia_objectafterrot},
+    {"weight", ia_weight},
+    {"modificator", ia_modificator},
+    {"accuracy", ia_accuracy},
+    {"attack", ia_attack},
+    {"defence", ia_defence},
+    {"range", ia_range},
+    {"weapontype", ia_weapontype},
+    {"weaponmagicdisturbance", ia_weaponmagicdisturbance}
+};
+
+World::itemAttributeIndex World::getItemAttribIndex(const std::string &s) {
+    const auto it = itemAttributeMap.find(s);
+
+    if (it == itemAttributeMap.end()) {
+        return ia_unknown;
+    }
+
+    return it->second;
+}
+
 int World::getItemAttrib(const std::string &s, TYPE_OF_ITEM_ID ItemID) {
+    return getItemAttrib(getItemAttribIndex(s), ItemID);
+}
 
+int World::getItemAttrib(itemAttributeIndex attribute, TYPE_OF_ITEM_ID ItemID) {
+    switch (attribute) {
     // Armor //
-    if (s == "bodyparts") {
-        if (Data::ArmorItems.exists(ItemID)) {
-            return Data::ArmorItems[ItemID].BodyParts;
-        }
-    } else if (s == "strokearmor") {
-        if (Data::ArmorItems.exists(ItemID)) {
-            return Data::ArmorItems[ItemID].StrokeArmor;
-        }
-    } else if (s == "thrustarmor") {
-        if (Data::ArmorItems.exists(ItemID)) {
-            return Data::ArmorItems[ItemID].ThrustArmor;
+    case ia_bodyparts:
+    case ia_strokearmor:
+    case ia_thrustarmor:
+    case ia_armormagicdisturbance: {
+        const auto armor = Data::ArmorItems.find(ItemID);
+
+        if (!armor) {
+            return 0;
         }
-    } else if (s == "armormagicdisturbance") {
-        if (Data::ArmorItems.exists(ItemID)) {
-            return Data::ArmorItems[ItemID].MagicDisturbance;
+
+        switch (attribute) {
+        case ia_bodyparts:
+            return armor->BodyParts;
+
+        case ia_strokearmor:
+            return armor->StrokeArmor;
+
+        case ia_thrustarmor:
+            return armor->ThrustArmor;
+
+        default:
+            return armor->MagicDisturbance;
         }
     }
 
     // Common //
-    else if (s == "agingspeed") {
-        const auto &common = Data::CommonItems[ItemID];
+    case ia_agingspeed:
+    case ia_objectafterrot:
+    case ia_weight: {
+        const auto common = Data::CommonItems.find(ItemID);
 
-        if (common.isValid()) {
-            return common.AgeingSpeed;
+        if (!common || !common->isValid()) {
+            return 0;
         }
-    } else if (s == "objectafterrot") {
-        const auto &common = Data::CommonItems[ItemID];
 
-        if (common.isValid()) {
-            return common.ObjectAfterRot;
-        }
-    } else if (s == "weight") {
-        const auto &common = Data::CommonItems[ItemID];
+        switch (attribute) {
+        case ia_agingspeed:
+            return common->AgeingSpeed;
+
+        case ia_objectafterrot:
+            return common->ObjectAfterRot;
 
-        if (common.isValid()) {
-            return common.Weight;
+        default:
+            return common->Weight;
         }
     }
 
     // Tiles Modificator //
-    else if (s == "modificator") {
-        if (Data::TilesModItems.exists(ItemID)) {
-            return Data::TilesModItems[ItemID].Modificator;
-        }
+    case ia_modificator: {
+        const auto tilesMod = Data::TilesModItems.find(ItemID);
+        return tilesMod ? tilesMod->Modificator : 0;
     }
 
     // Weapon //
-    else if (s == "accuracy") {
-        if (Data::WeaponItems.exists(ItemID)) {
-            return Data::WeaponItems[ItemID].Accuracy;
-        }
-    } else if (s == "attack") {
-        if (Data::WeaponItems.exists(ItemID)) {
-            return Data::WeaponItems[ItemID].Attack;
-        }
-    } else if (s == "defence") {
-        if (Data::WeaponItems.exists(ItemID)) {
-            return Data::WeaponItems[ItemID].Defence;
+    case ia_accuracy:
+    case ia_attack:
+    case ia_defence:
+    case ia_range:
+    case ia_weapontype:
+    case ia_weaponmagicdisturbance: {
+        const auto weapon = Data::WeaponItems.find(ItemID);
+
+        if (!weapon) {
+            return 0;
         }
-    } else if (s == "range") {
-        if (Data::WeaponItems.exists(ItemID)) {
-            return Data::WeaponItems[ItemID].Range;
-        }
-    } else if (s == "weapontype") {
-        if (Data::WeaponItems.exists(ItemID)) {
-            return Data::WeaponItems[ItemID].Type;
-        }
-    } else if (s == "weaponmagicdisturbance") {
-        if (Data::WeaponItems.exists(ItemID)) {
-            return Data::WeaponItems[ItemID].MagicDisturbance;
+
+        switch (attribute) {
+        case ia_accuracy:
+            return weapon->Accuracy;
+
+        case ia_attack:
+            return weapon->Attack;
+
+        case ia_defence:
+            return weapon->Defence;
+
+        case ia_range:
+            return weapon->Range;
+
+        case ia_weapontype:
+            return weapon->Type;
+
+        default:
+            return weapon->MagicDisturbance;
         }
     }
 
-    return 0;
+    case ia_unknown:
+        break;
+    }
 
+    return 0;
 }
 
 
@@ -656,21 +708,113 @@ void World::ageMaps() {
 }
 
 
+void World::updateMetrics() {
+    using Statistic::Statistics;
+    auto &statistics = Statistics::getInstance();
+    static const int players = statistics.gaugeId("players");
+    static const int monsters = statistics.gaugeId("monsters");
+    static const int npcs = statistics.gaugeId("npcs");
+    static const int deepestSendQueue = statistics.gaugeId("deepest send queue");
+    static const int largestSendQueue = statistics.gaugeId("largest send queue bytes");
+    static const int databaseConnections = statistics.gaugeId("database connections");
+    static const int databaseConnectionsOpened = statistics.gaugeId("database connections opened");
+
+    statistics.setGauge(players, Players.size());
+    statistics.setGauge(monsters, Monsters.size());
+    statistics.setGauge(npcs, Npc.size());
+
+    size_t deepest = 0;
+    size_t largest = 0;
+
+    Players.for_each([&deepest, &largest](Player *player) {
+        deepest = std::max(deepest, player->Connection->getQueueSize());
+        largest = std::max(largest, player->Connection->getQueuedBytes());
+    });
+
+    statistics.setGauge(deepestSendQueue, deepest);
+    statistics.setGauge(largestSendQueue, largest);
+    statistics.setGauge(databaseConnections, Database::Connection::getOpenConnections());
+    statistics.setGauge(databaseConnectionsOpened, Database::Connection::getTotalConnections());
+}
+
+void World::updateActivity() {
+    activity.reset(Config::instance().activity_radius);
+
+    Players.for_each([this](Player *player) {
+        activity.addObserver(player->getPosition());
+    });
+
+    using Statistic::Statistics;
+    auto &statistics = Statistics::getInstance();
+    static const int activeRegions = statistics.gaugeId("active regions");
+    static const int dormantMonsters = statistics.gaugeId("dormant monsters");
+    static const int dormantNpcs = statistics.gaugeId("dormant npcs");
+
+    size_t monsters = 0;
+    size_t npcs = 0;
+
+    Monsters.for_each([&monsters](Monster *monster) {
+        monsters += monster->isResting();
+    });
+
+    Npc.for_each([&npcs](NPC *npc) {
+        npcs += npc->isResting();
+    });
+
+    statistics.setGauge(activeRegions, activity.size());
+    statistics.setGauge(dormantMonsters, monsters);
+    statistics.setGauge(dormantNpcs, npcs);
+}
+
+void World::updateShardStatistics() {
+    using Statistic::Statistics;
+    auto &statistics = Statistics::getInstance();
+    static std::vector<std::array<int, 3>> gauges;
+
+    for (size_t shard = gauges.size(); shard < shards.size(); ++shard) {
+        const std::string prefix = "shard " + std::to_string(shard) + " ";
+        gauges.push_back({{statistics.gaugeId(prefix + "players"), statistics.gaugeId(prefix + "monsters"), statistics.gaugeId(prefix + "npcs")}});
+    }
+
+    // how many characters each shard would have to simulate
+    std::vector<std::array<int64_t, 3>> counts(shards.size(), {{0, 0, 0}});
+
+    Players.for_each([this, &counts](Player *player) {
+        ++counts[shards.getShard(player->getPosition())][0];
+    });
+
+    Monsters.for_each([this, &counts](Monster *monster) {
+        ++counts[shards.getShard(monster->getPosition())][1];
+    });
+
+    Npc.for_each([this, &counts](NPC *npc) {
+        ++counts[shards.getShard(npc->getPosition())][2];
+    });
+
+    for (size_t shard = 0; shard < shards.size(); ++shard) {
+        for (size_t kind = 0; kind < 3; ++kind) {
+            statistics.setGauge(gauges[shard][kind], counts[shard][kind]);
+        }
+    }
+}
+
+
 void World::ageInventory() {
     Players.for_each(&Player::ageInventory);
     Monsters.for_each(&Monster::ageInventory);
 }
 
 
-void World::Save() {
+bool World::Save() {
     std::string path = directory + std::string(MAPDIR) + worldName;
 
-    maps.saveToDisk(path);
+    bool saved = maps.saveToDisk(path);
 
     std::ofstream specialfile((path + "_specialfields").c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
 
     if (! specialfile.good()) {
         Logger::error(LogFacility::World) << "World::Save: error writing specialfields!" << Log::end;
+        saved = false;
     } else {
         unsigned short int size = specialfields.size();
         Logger::error(LogFacility::World) << "World::Save: saving " << size << " special fields." << Log::end;
@@ -683,8 +827,22 @@ void World::Save() {
         }
 
         specialfile.close();
+        saved = saved && !specialfile.fail();
     }
 
+    if (mapJournal) {
+        // the journal may only go once the snapshot replacing it is on disk
+        if (saved && syncSnapshot()) {
+            touchedFields.clear();
+            touchedContainers.clear();
+            journalPositions.clear();
+            mapJournal->truncate();
+        } else {
+            Logger::error(LogFacility::World) << "World::Save: could not write the maps to disk, keeping the map journal" << Log::end;
+        }
+    }
+
+    return saved;
 }
 
 
@@ -699,6 +857,7 @@ void World::Load() {
         load_maps();
         Logger::info(LogFacility::World) << "Saving World..." << Log::end;
         Save();
+        openMapJournal();
         return;
     } else {
         unsigned short int size;
@@ -730,6 +889,8 @@ void World::Load() {
             // if the map loads ok...
             if (tempMap->Load(mname, 0, 0)) {
                 maps.InsertMap(tempMap);    // insert it
+                specialFieldIndex.cover(tZ_Level, tempMap->Min_X, tempMap->Min_Y, tempMap->Max_X, tempMap->Max_Y);
+                indexWarpFields(tempMap, tZ_Level);
             }
         }
 
@@ -761,6 +922,188 @@ void World::Load() {
         specialfile.close();
     }
 
+    openMapJournal();
+}
+
+void World::openMapJournal() {
+    const std::string path = directory + std::string(MAPDIR) + worldName + "_journal";
+
+    const auto result = MapJournal::replay(path, [this](const std::string &record) {
+        applyJournalRecord(record);
+    });
+
+    if (result.torn) {
+        Logger::warn(LogFacility::World) << "Map journal ends in a torn record, changes after it are lost" << Log::end;
+    }
+
+    if (result.records > 0) {
+        Logger::info(LogFacility::World) << "Replayed " << result.records << " map changes from the journal, saving World..." << Log::end;
+
+        if (!Save() || !syncSnapshot()) {
+            Logger::error(LogFacility::World) << "Could not write the maps to disk, keeping the map journal and recording no changes" << Log::end;
+            return;
+        }
+    }
+
+    // opening the journal drops what has just been folded into the snapshot
+    if (Config::instance().map_journal != 0) {
+        mapJournal = std::make_unique<MapJournal>(path, std::chrono::milliseconds(Config::instance().map_journal_sync));
+        Field::setTouchLog(&touchedFields);
+        Container::setTouchLog(&touchedContainers);
+    } else {
+        std::remove(path.c_str());
+    }
+}
+
+bool World::syncSnapshot() {
+    const std::string dir = directory + std::string(MAPDIR);
+    const std::string path = dir + worldName;
+
+    // the directory holds the entries of newly created files
+    return maps.syncToDisk(path) && MapJournal::syncFile(path + "_specialfields") && MapJournal::syncFile(dir);
+}
+
+void World::journalMapChanges() {
+    if (!mapJournal) {
+        return;
+    }
+
+    for (const auto field : touchedFields) {
+        position pos;
+        WorldMap::map_t map;
+
+        // fields which are not on a map are temporary copies
+        if (maps.findPosOfField(field, pos, map)) {
+            journalPositions.insert(pos);
+        }
+    }
+
+    touchedFields.clear();
+
+    if (!touchedContainers.empty()) {
+        const std::unordered_set<const Container *> containers(touchedContainers.begin(), touchedContainers.end());
+        touchedContainers.clear();
+
+        // containers in inventories and depots are not on any map
+        maps.findPosOfContainers(containers, journalPositions);
+    }
+
+    if (journalPositions.empty()) {
+        return;
+    }
+
+    using Statistic::Statistics;
+    static const int journalRecords = Statistics::getInstance().counterId("map journal records");
+
+    std::string batch;
+
+    for (const auto &pos : journalPositions) {
+        Field *field;
+        WorldMap::map_t map;
+
+        if (GetPToCFieldAt(field, pos, map)) {
+            MapJournal::addRecord(batch, encodeJournalRecord(pos, *map, *field));
+            Statistics::getInstance().increment(journalRecords);
+        }
+    }
+
+    journalPositions.clear();
+    mapJournal->append(std::move(batch));
+
+    const auto failures = mapJournal->getFailedWrites();
+
+    if (failures > reportedJournalFailures) {
+        Logger::error(LogFacility::World) << "Writing the map journal failed " << (failures - reportedJournalFailures) << " times" << Log::end;
+        reportedJournalFailures = failures;
+    }
+}
+
+std::string World::encodeJournalRecord(const position &pos, Map &map, Field &field) const {
+    std::ostringstream record(std::ios::binary | std::ios::out);
+    record.write((char *) & pos.x, sizeof(pos.x));
+    record.write((char *) & pos.y, sizeof(pos.y));
+    record.write((char *) & pos.z, sizeof(pos.z));
+
+    field.Save(record, record, record);
+
+    const auto containers = map.maincontainers.find(MAP_POSITION(pos));
+    MAXCOUNTTYPE count = 0;
+
+    if (containers != map.maincontainers.end()) {
+        count = containers->second.size();
+    }
+
+    record.write((char *) & count, sizeof(count));
+
+    if (count > 0) {
+        for (const auto &container : containers->second) {
+            record.write((char *) & container.first, sizeof(container.first));
+            container.second->Save(record);
+        }
+    }
+
+    return record.str();
+}
+
+void World::applyJournalRecord(const std::string &record) {
+    std::istringstream in(record, std::ios::binary | std::ios::in);
+    position pos;
+    in.read((char *) & pos.x, sizeof(pos.x));
+    in.read((char *) & pos.y, sizeof(pos.y));
+    in.read((char *) & pos.z, sizeof(pos.z));
+
+    Field *field;
+    WorldMap::map_t map;
+
+    if (!GetPToCFieldAt(field, pos, map)) {
+        Logger::warn(LogFacility::World) << "Map journal: no field at " << pos << ", change skipped" << Log::end;
+        return;
+    }
+
+    field->Load(in, in, in);
+    field->updateFlags();
+
+    if (field->IsWarpField()) {
+        specialFieldIndex.add(pos, SpecialFieldIndex::warp);
+    } else {
+        specialFieldIndex.remove(pos, SpecialFieldIndex::warp);
+    }
+
+    const MAP_POSITION mapPos(pos);
+    auto old = map->maincontainers.find(mapPos);
+
+    if (old != map->maincontainers.end()) {
+        for (auto &container : old->second) {
+            delete container.second;
+        }
+
+        map->maincontainers.erase(old);
+    }
+
+    MAXCOUNTTYPE count = 0;
+    in.read((char *) & count, sizeof(count));
+
+    for (MAXCOUNTTYPE i = 0; i < count; ++i) {
+        Container::CONTAINERMAP::key_type key;
+        in.read((char *) & key, sizeof(key));
+
+        Item::id_type id = 0;
+
+        for (const auto &item : field->items) {
+            if (item.isContainer() && item.getNumber() == key) {
+                id = item.getId();
+            }
+        }
+
+        auto container = new Container(id);
+        container->Load(in);
+
+        if (id != 0) {
+            map->maincontainers[mapPos].insert(Container::CONTAINERMAP::value_type(key, container));
+        } else {
+            delete container;
+        }
+    }
 }
 
 int World::getTime(const std::string &timeType) {
@@ -859,18 +1202,20 @@ int World::getTime(const std::string &timeType) {
 
 
 bool World::findWarpFieldsInRange(const position &pos, short int range, std::vector<position> &warppositions) {
-    for (int x = pos.x - range; x <= pos.x + range; ++x) {
-        for (int y = pos.y - range; y <= pos.y + range; ++y) {
-            const position p(x, y, pos.z);
-            Field *cf = 0;
+    specialFieldIndex.findInRange(pos, range, SpecialFieldIndex::warp, warppositions);
+    return !warppositions.empty();
+}
+
+void World::indexWarpFields(const WorldMap::map_t &map, short int z) {
+    for (int x = map->GetMinX(); x <= map->GetMaxX(); ++x) {
+        for (int y = map->GetMinY(); y <= map->GetMaxY(); ++y) {
+            Field *cf = nullptr;
 
-            if (GetPToCFieldAt(cf, p) && cf->IsWarpField()) {
-                warppositions.push_back(p);
+            if (map->GetPToCFieldAt(cf, x, y) && cf->IsWarpField()) {
+                specialFieldIndex.add(position(x, y, z), SpecialFieldIndex::warp);
             }
         }
     }
-
-    return !warppositions.empty();
 }
 
 
@@ -19,7 +19,9 @@
 
 #include "WorldMap.hpp"
 #include "Map.hpp"
+#include "MapJournal.hpp"
 #include "Logger.hpp"
+#include "Statistics.hpp"
 
 #include <stdexcept>
 #include <boost/algorithm/string/replace.hpp>
@@ -28,6 +30,7 @@
 void WorldMap::clear() {
     maps.clear();
     world_map.clear();
+    columns.clear();
 }
 
 bool WorldMap::mapInRangeOf(const position &upperleft, unsigned short int dx, unsigned short int dy) const {
@@ -85,6 +88,43 @@ bool WorldMap::findMapForPos(const position &pos, WorldMap::map_t &map) const {
     return false;
 }
 
+bool WorldMap::findPosOfField(const Field *field, position &pos, WorldMap::map_t &map) const {
+    auto it = columns.upper_bound(field);
+
+    if (it == columns.begin()) {
+        return false;
+    }
+
+    --it;
+    const auto offset = reinterpret_cast<uintptr_t>(field) - reinterpret_cast<uintptr_t>(it->first);
+
+    if (offset % sizeof(Field) != 0 || offset / sizeof(Field) >= it->second.height) {
+        return false;
+    }
+
+    map = it->second.map;
+    pos = position(it->second.x, map->Min_Y + offset / sizeof(Field), map->Z_Level);
+    return true;
+}
+
+void WorldMap::findPosOfContainers(const std::unordered_set<const Container *> &containers, std::unordered_set<position> &positions) const {
+    size_t found = 0;
+
+    for (const auto &map : maps) {
+        for (const auto &field : map->maincontainers) {
+            for (const auto &container : field.second) {
+                if (containers.count(container.second) > 0) {
+                    positions.insert(position(field.first.x, field.first.y, map->Z_Level));
+
+                    if (++found == containers.size()) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
 bool WorldMap::InsertMap(WorldMap::map_t newMap) {
     if (newMap) {
         for (auto it = maps.begin(); it < maps.end(); ++it) {
@@ -104,6 +144,14 @@ bool WorldMap::InsertMap(WorldMap::map_t newMap) {
             }
         }
 
+        for (size_t i = 0; i < newMap->MainMap.size(); ++i) {
+            const auto &column = newMap->MainMap[i];
+
+            if (!column.empty()) {
+                columns[column.data()] = {newMap, short(newMap->Min_X + i), column.size()};
+            }
+        }
+
         return true;
     }
 
@@ -114,6 +162,9 @@ bool WorldMap::InsertMap(WorldMap::map_t newMap) {
 bool WorldMap::allMapsAged() {
     using std::chrono::steady_clock;
     using std::chrono::milliseconds;
+    using Statistic::Statistics;
+    static const int mapsAged = Statistics::getInstance().gaugeId("maps aged");
+    static const int mapCount = Statistics::getInstance().gaugeId("maps");
 
     auto startTime = steady_clock::now();
 
@@ -121,6 +172,9 @@ bool WorldMap::allMapsAged() {
         maps[ageIndex++]->age();
     }
 
+    Statistics::getInstance().setGauge(mapsAged, ageIndex);
+    Statistics::getInstance().setGauge(mapCount, maps.size());
+
     if (ageIndex < maps.size()) {
         return false;
     }
@@ -210,11 +264,13 @@ bool WorldMap::exportTo(const std::string &exportDir) const {
     return true;
 }
 
-void WorldMap::saveToDisk(const std::string &prefix) const {
+bool WorldMap::saveToDisk(const std::string &prefix) const {
     std::ofstream mapinitfile((prefix + "_initmaps").c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+    bool saved = true;
 
     if (!mapinitfile.good()) {
         Logger::error(LogFacility::World) << "Could not create initmaps!" << Log::end;
+        saved = false;
     } else {
         unsigned short int size = maps.size();
         Logger::info(LogFacility::World) << "Saving " << size << " maps." << Log::end;
@@ -230,10 +286,33 @@ void WorldMap::saveToDisk(const std::string &prefix) const {
             mapinitfile.write((char *) & (*mapI)->Height, sizeof((*mapI)->Height));
 
             sprintf(mname, "%s_%6d_%6d_%6d", prefix.c_str(), (*mapI)->Z_Level, (*mapI)->Min_X, (*mapI)->Min_Y);
-            (*mapI)->Save(mname);
+            saved = (*mapI)->Save(mname) && saved;
         }
 
         mapinitfile.close();
     }
+
+    return saved && !mapinitfile.fail();
+}
+
+bool WorldMap::syncToDisk(const std::string &prefix) const {
+    if (!MapJournal::syncFile(prefix + "_initmaps")) {
+        return false;
+    }
+
+    char mname[200];
+
+    for (const auto &map : maps) {
+        sprintf(mname, "%s_%6d_%6d_%6d", prefix.c_str(), map->Z_Level, map->Min_X, map->Min_Y);
+        const std::string name = mname;
+
+        for (const auto suffix : {"_map", "_item", "_warp", "_container"}) {
+            if (!MapJournal::syncFile(name + suffix)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
 
@@ -20,12 +20,16 @@
 #ifndef _WORLDMAP_HPP_
 #define _WORLDMAP_HPP_
 
+#include <map>
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include "globals.hpp"
 
 class Map;
+class Field;
+class Container;
 
 //falls nicht auskommentiert, werden mehr Bildschirmausgaben gemacht:
 /* #define WorldMap_DEBUG */
@@ -44,16 +48,34 @@ public:
     bool mapInRangeOf(const position &upperleft, unsigned short int dx, unsigned short int dy) const;
     bool findMapForPos(const position &pos, map_t &map) const;
 
+    // finds map and position of a field from its address, false if it lies on no map
+    bool findPosOfField(const Field *field, position &pos, map_t &map) const;
+
+    // adds the positions of those containers which lie on a map
+    void findPosOfContainers(const std::unordered_set<const Container *> &containers, std::unordered_set<position> &positions) const;
+
     bool InsertMap(map_t newMap);
 
     bool allMapsAged();
 
     bool exportTo(const std::string &exportDir) const;
-    void saveToDisk(const std::string &prefix) const;
+    // false if a file could not be written completely
+    bool saveToDisk(const std::string &prefix) const;
+    // syncs the files written by saveToDisk, false if one fails
+    bool syncToDisk(const std::string &prefix) const;
 
 private:
     map_vector_t maps;
     std::unordered_map<position, map_t> world_map;
+
+    struct Column {
+        map_t map;
+        short int x;
+        size_t height;
+    };
+
+    // the fields of a map column lie in one vector, keyed by its first field
+    std::map<const Field *, Column> columns;
     size_t ageIndex = 0;
 };
 #endif
@@ -0,0 +1,120 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "WorldShards.hpp"
+
+#include <sstream>
+
+bool WorldShards::configure(const std::string &spec) {
+    shards.clear();
+
+    if (spec.empty() || spec == "none") {
+        return true;
+    }
+
+    std::istringstream specStream(spec);
+    std::string text;
+
+    while (std::getline(specStream, text, ';')) {
+        Shard shard;
+
+        if (!parseShard(text, shard)) {
+            shards.clear();
+            return false;
+        }
+
+        shards.push_back(shard);
+    }
+
+    return true;
+}
+
+bool WorldShards::parseShard(const std::string &text, Shard &shard) {
+    std::istringstream shardStream(text);
+    std::string axis;
+    bool empty = true;
+
+    while (std::getline(shardStream, axis, ',')) {
+        if (axis.size() < 2 || axis[1] != ':') {
+            return false;
+        }
+
+        Range *range = nullptr;
+
+        switch (axis[0]) {
+        case 'x':
+            range = &shard.x;
+            break;
+
+        case 'y':
+            range = &shard.y;
+            break;
+
+        case 'z':
+            range = &shard.z;
+            break;
+
+        default:
+            return false;
+        }
+
+        if (!parseRange(axis.substr(2), *range)) {
+            return false;
+        }
+
+        empty = false;
+    }
+
+    return !empty;
+}
+
+bool WorldShards::parseRange(const std::string &text, Range &range) {
+    const auto dots = text.find("..");
+    const std::string from = dots == std::string::npos ? text : text.substr(0, dots);
+    const std::string to = dots == std::string::npos ? text : text.substr(dots + 2);
+
+    if (from.empty() && to.empty()) {
+        return false;
+    }
+
+    try {
+        size_t used = 0;
+
+        if (!from.empty()) {
+            range.from = std::stoi(from, &used);
+
+            if (used != from.size()) {
+                return false;
+            }
+        }
+
+        if (!to.empty()) {
+            range.to = std::stoi(to, &used);
+
+            if (used != to.size()) {
+                return false;
+            }
+        }
+    } catch (std::exception &) {
+        return false;
+    }
+
+    return range.from <= range.to;
+}
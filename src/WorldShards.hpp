@@ -0,0 +1,95 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _WORLD_SHARDS_HPP_
+#define _WORLD_SHARDS_HPP_
+
+#include <string>
+#include <vector>
+#include "globals.hpp"
+
+/**
+* divides the map into shards, boxes of fields given in the config
+*
+* A shard is written as up to three axis ranges separated by commas, like
+* x:0..499,z:-3..3, an axis left out or a bound left open is unlimited.
+* Shards are separated by semicolons and numbered from 1 in that order, the
+* first one containing a position wins. Shard 0 holds everything else, so
+* "none" leaves the whole world in shard 0.
+*
+* World reports the characters in every shard and the moves across shard
+* borders. With world_shard_threads the monsters of every shard think on a
+* thread of the shard, see ShardTick, everything else still ticks on the
+* main thread.
+*/
+class WorldShards {
+public:
+    /**
+    * replaces the shards
+    * @param spec the shards as described above, or none
+    * @return false if spec could not be parsed, all positions are in shard 0 then
+    */
+    bool configure(const std::string &spec);
+
+    /**
+    * @return the shard containing pos
+    */
+    size_t getShard(const position &pos) const {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (shards[i].contains(pos)) {
+                return i + 1;
+            }
+        }
+
+        return 0;
+    }
+
+    /**
+    * @return the number of shards including shard 0
+    */
+    size_t size() const {
+        return shards.size() + 1;
+    }
+
+private:
+    struct Range {
+        int from = -0x8000;
+        int to = 0x7FFF;
+
+        bool contains(int value) const {
+            return from <= value && value <= to;
+        }
+    };
+
+    struct Shard {
+        Range x, y, z;
+
+        bool contains(const position &pos) const {
+            return x.contains(pos.x) && y.contains(pos.y) && z.contains(pos.z);
+        }
+    };
+
+    static bool parseShard(const std::string &text, Shard &shard);
+    static bool parseRange(const std::string &text, Range &range);
+
+    std::vector<Shard> shards;
+};
+
+#endif
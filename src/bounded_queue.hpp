@@ -0,0 +1,225 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef __bounded_queue_hpp
+#define __bounded_queue_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/**
+* a lock-free bounded queue for many producers and many consumers
+*
+* Every cell carries a sequence number telling producers and consumers
+* whose turn it is, so try_push and try_pop need one compare-and-swap and
+* never allocate. push and pop wait while the queue is full or empty, but
+* only lock if somebody actually waits.
+*/
+template<class T> class bounded_queue {
+public:
+    // capacity is rounded up to a power of two
+    explicit bounded_queue(size_t capacity) {
+        size_t size = 2;
+
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bounded_queue(const bounded_queue &) = delete;
+    bounded_queue &operator=(const bounded_queue &) = delete;
+
+    // false if the queue is full
+    bool try_push(const T &item) {
+        if (!tryPush(item)) {
+            ++fullCount;
+            return false;
+        }
+
+        wakeWaiters();
+        return true;
+    }
+
+    // false if the queue is empty
+    bool try_pop(T &item) {
+        if (!tryPop(item)) {
+            return false;
+        }
+
+        wakeWaiters();
+        return true;
+    }
+
+    // waits while the queue is full, pushes even if it was closed
+    void push(const T &item) {
+        if (tryPush(item)) {
+            wakeWaiters();
+            return;
+        }
+
+        ++fullCount;
+
+        while (!tryPush(item)) {
+            wait([this] {
+                return size() < capacity();
+            });
+        }
+
+        wakeWaiters();
+    }
+
+    // waits for an item, false once the queue is closed and empty
+    bool pop(T &item) {
+        while (!tryPop(item)) {
+            if (closed) {
+                return tryPop(item);
+            }
+
+            wait([this] {
+                return !empty() || closed;
+            });
+        }
+
+        wakeWaiters();
+        return true;
+    }
+
+    // lets pop return once the queue ran empty
+    void close() {
+        closed = true;
+        std::lock_guard<std::mutex> lock(waitMutex);
+        changed.notify_all();
+    }
+
+    size_t size() const {
+        const size_t pushed = enqueuePos.value.load();
+        const size_t popped = dequeuePos.value.load();
+        return pushed > popped ? pushed - popped : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // number of pushes that found the queue full
+    uint64_t getFullCount() const {
+        return fullCount;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    // producers and consumers should not share a cache line
+    struct Position {
+        std::atomic<size_t> value{0};
+        char padding[64 - sizeof(std::atomic<size_t>)];
+    };
+
+    bool tryPush(const T &item) {
+        size_t pos = enqueuePos.value.load(std::memory_order_relaxed);
+
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (enqueuePos.value.compare_exchange_weak(pos, pos + 1)) {
+                    cell.item = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T &item) {
+        size_t pos = dequeuePos.value.load(std::memory_order_relaxed);
+
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (dequeuePos.value.compare_exchange_weak(pos, pos + 1)) {
+                    item = std::move(cell.item);
+                    cell.item = T();
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template<class Predicate> void wait(Predicate ready) {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        ++waiters;
+        changed.wait(lock, ready);
+        --waiters;
+    }
+
+    void wakeWaiters() {
+        if (waiters > 0) {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            changed.notify_all();
+        }
+    }
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    Position enqueuePos;
+    Position dequeuePos;
+    std::atomic<int> waiters{0};
+    std::atomic<bool> closed{false};
+    std::atomic<uint64_t> fullCount{0};
+
+    std::mutex waitMutex;
+    std::condition_variable changed;
+};
+
+#endif
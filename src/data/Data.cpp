@@ -87,10 +87,18 @@ void reloadScripts() {
     }
 }
 
+static uint32_t tableGeneration = 0;
+
+uint32_t getTableGeneration() {
+    return tableGeneration;
+}
+
 void activateTables() {
     for (auto &table : getTables()) {
         table->activateBuffer();
     }
+
+    ++tableGeneration;
 }
 
 bool reload() {
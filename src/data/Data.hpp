@@ -58,6 +58,12 @@ extern LongTimeEffectTable LongTimeEffects;
 std::vector<Table *> getTables();
 bool reloadTables();
 void reloadScripts();
+
+/**
+* changes whenever reloaded tables are activated, values derived from the
+* tables before are outdated then
+*/
+uint32_t getTableGeneration();
 void activateTables();
 bool reload();
 
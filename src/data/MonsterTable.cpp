@@ -240,7 +240,7 @@ void MonsterTable::reload() {
                     }
                 }
 
-                m_table[id] = temprecord;
+                m_table.emplace(id, std::move(temprecord));
                 m_dataOK = true;
             }
         }
@@ -254,16 +254,14 @@ void MonsterTable::reload() {
 
 }
 
-bool MonsterTable::find(TYPE_OF_CHARACTER_ID Id, MonsterStruct &ret) {
-    TABLE::iterator iterator;
-    iterator = m_table.find(Id);
+const MonsterStruct *MonsterTable::find(TYPE_OF_CHARACTER_ID Id) const {
+    const auto iterator = m_table.find(Id);
 
     if (iterator == m_table.end()) {
-        return false;
-    } else {
-        ret = (*iterator).second;
-        return true;
+        return nullptr;
     }
+
+    return &iterator->second;
 }
 
 void MonsterTable::clearOldTable() {
@@ -25,7 +25,7 @@
 #include <map>
 #include <vector>
 #include <memory>
-#include <boost/unordered_map.hpp>
+#include <unordered_map>
 #include "script/LuaMonsterScript.hpp"
 #include "types.hpp"
 #include "Character.hpp"
@@ -88,10 +88,12 @@ public:
         return m_dataOK;
     }
 
-    bool find(TYPE_OF_CHARACTER_ID Id, MonsterStruct &ret);
+    // definitions are immutable once loaded, a reload builds a new table;
+    // returns nullptr if there is no monster with this id
+    const MonsterStruct *find(TYPE_OF_CHARACTER_ID Id) const;
 
 private:
-    typedef boost::unordered_map<TYPE_OF_CHARACTER_ID, MonsterStruct> TABLE;
+    typedef std::unordered_map<TYPE_OF_CHARACTER_ID, MonsterStruct> TABLE;
     TABLE m_table;
 
     void clearOldTable();
@@ -85,6 +85,17 @@ public:
         return structs.at(id);
     }
 
+    // single lookup alternative to exists() followed by operator[]
+    const StructType *find(const IdType &id) const {
+        const auto it = structs.find(id);
+
+        if (it == structs.end()) {
+            return nullptr;
+        }
+
+        return &it->second;
+    }
+
     typename ContainerType::const_iterator begin() const {
         return structs.cbegin();
     }
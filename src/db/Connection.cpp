@@ -27,8 +27,17 @@
 
 using namespace Database;
 
+std::atomic<size_t> Connection::openConnections{0};
+std::atomic<uint64_t> Connection::totalConnections{0};
+
 Connection::Connection(const std::string &connectionString) {
     internalConnection = std::make_unique<pqxx::connection>(connectionString);
+    openConnections.fetch_add(1, std::memory_order_relaxed);
+    totalConnections.fetch_add(1, std::memory_order_relaxed);
+}
+
+Connection::~Connection() {
+    openConnections.fetch_sub(1, std::memory_order_relaxed);
 }
 
 void Connection::beginTransaction() {
@@ -21,6 +21,7 @@
 #ifndef _CONNECTION_HPP_
 #define _CONNECTION_HPP_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <pqxx/connection.hxx>
@@ -37,8 +38,12 @@ private:
     std::unique_ptr<pqxx::connection> internalConnection = nullptr;
     std::unique_ptr<pqxx::transaction_base> transaction = nullptr;
 
+    static std::atomic<size_t> openConnections;
+    static std::atomic<uint64_t> totalConnections;
+
 public:
     Connection(const std::string &connectionString);
+    ~Connection();
     void beginTransaction(void);
     pqxx::result query(const std::string &query);
     void commitTransaction(void);
@@ -52,6 +57,15 @@ public:
         return bool(transaction);
     }
 
+    // connections are not pooled, every query opens its own
+    static size_t getOpenConnections() {
+        return openConnections.load(std::memory_order_relaxed);
+    }
+
+    static uint64_t getTotalConnections() {
+        return totalConnections.load(std::memory_order_relaxed);
+    }
+
 private:
     Connection(const Connection &org) = delete;
     Connection &operator=(const Connection &org) = delete;
@@ -0,0 +1,325 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "loadtest/Bot.hpp"
+#include <functional>
+#include "constants.hpp"
+#include "netinterface/protocol/ClientCommands.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
+
+namespace LoadTest {
+
+namespace {
+
+// builds one client command including its header, mirroring BasicClientCommand
+class ClientMessage {
+public:
+    explicit ClientMessage(unsigned char id) : data{id, static_cast<unsigned char>(id xor 255), 0, 0, 0, 0} {
+    }
+
+    ClientMessage &addUnsignedChar(unsigned char value) {
+        data.push_back(value);
+        checkSum += value;
+        return *this;
+    }
+
+    ClientMessage &addShortInt(int16_t value) {
+        addUnsignedChar(value >> 8);
+        return addUnsignedChar(value & 255);
+    }
+
+    ClientMessage &addInt(int32_t value) {
+        addShortInt(value >> 16);
+        return addShortInt(value & 0xFFFF);
+    }
+
+    ClientMessage &addString(const std::string &value) {
+        addShortInt(value.length());
+
+        for (const char c : value) {
+            addUnsignedChar(c);
+        }
+
+        return *this;
+    }
+
+    const std::vector<unsigned char> &finish() {
+        const uint16_t length = data.size() - 6;
+        const uint16_t crc = checkSum % 0xFFFF;
+        data[2] = length >> 8;
+        data[3] = length & 255;
+        data[4] = crc >> 8;
+        data[5] = crc & 255;
+        return data;
+    }
+
+private:
+    std::vector<unsigned char> data;
+    uint32_t checkSum = 0;
+};
+
+int16_t readShort(const std::vector<unsigned char> &buffer, size_t pos) {
+    return static_cast<int16_t>((buffer[pos] << 8) | buffer[pos + 1]);
+}
+
+int32_t readInt(const std::vector<unsigned char> &buffer, size_t pos) {
+    return static_cast<int32_t>((buffer[pos] << 24) | (buffer[pos + 1] << 16) | (buffer[pos + 2] << 8) | buffer[pos + 3]);
+}
+
+}
+
+Bot::Bot(boost::asio::io_service &io_service, const BotSettings &settings, const std::string &name, unsigned int seed)
+    : socket(io_service), actionTimer(io_service), settings(settings), name(name), random(seed) {
+}
+
+void Bot::start(const boost::asio::ip::tcp::endpoint &endpoint) {
+    socket.async_connect(endpoint, std::bind(&Bot::handleConnect, shared_from_this(), std::placeholders::_1));
+}
+
+void Bot::stop() {
+    if (stopping) {
+        return;
+    }
+
+    stopping = true;
+    actionTimer.cancel();
+
+    if (socket.is_open()) {
+        send(ClientMessage(C_LOGOUT_TS).finish());
+    }
+}
+
+void Bot::handleConnect(const boost::system::error_code &error) {
+    if (error) {
+        statistics.connectionLost = true;
+        return;
+    }
+
+    boost::asio::ip::tcp::no_delay noDelay(true);
+    socket.set_option(noDelay);
+
+    ClientMessage login(C_LOGIN_TS);
+    login.addUnsignedChar(settings.clientVersion);
+    login.addString(name);
+    login.addString(settings.password);
+    send(login.finish());
+
+    readHeader();
+}
+
+void Bot::readHeader() {
+    boost::asio::async_read(socket, boost::asio::buffer(headerBuffer, 6), std::bind(&Bot::handleHeader, shared_from_this(), std::placeholders::_1));
+}
+
+void Bot::handleHeader(const boost::system::error_code &error) {
+    if (error) {
+        close();
+        return;
+    }
+
+    if ((headerBuffer[0] xor 255) != headerBuffer[1]) {
+        // the server never sends garbage, so the stream is out of sync
+        close();
+        return;
+    }
+
+    const uint16_t length = (headerBuffer[2] << 8) | headerBuffer[3];
+    readBuffer.resize(length);
+    statistics.bytesReceived += 6 + length;
+
+    if (length == 0) {
+        handleCommand(headerBuffer[0]);
+        readHeader();
+        return;
+    }
+
+    boost::asio::async_read(socket, boost::asio::buffer(readBuffer), std::bind(&Bot::handleData, shared_from_this(), std::placeholders::_1));
+}
+
+void Bot::handleData(const boost::system::error_code &error) {
+    if (error) {
+        close();
+        return;
+    }
+
+    handleCommand(headerBuffer[0]);
+    readHeader();
+}
+
+void Bot::handleCommand(unsigned char command) {
+    ++statistics.commandsReceived;
+
+    switch (command) {
+    case SC_ID_TC:
+        if (readBuffer.size() >= 4) {
+            id = readInt(readBuffer, 0);
+
+            if (!statistics.loggedIn) {
+                statistics.loggedIn = true;
+                scheduleAction();
+            }
+        }
+
+        break;
+
+    case SC_SETCOORDINATE_TC:
+        if (readBuffer.size() >= 6) {
+            x = readShort(readBuffer, 0);
+            y = readShort(readBuffer, 2);
+            z = readShort(readBuffer, 4);
+        }
+
+        break;
+
+    case SC_MOVEACK_TC:
+        if (readBuffer.size() >= 10 && readInt(readBuffer, 0) == id) {
+            x = readShort(readBuffer, 4);
+            y = readShort(readBuffer, 6);
+            z = readShort(readBuffer, 8);
+
+            if (!pendingMoves.empty()) {
+                const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - pendingMoves.front());
+                statistics.moveLatencies.push_back(latency.count());
+                pendingMoves.pop_front();
+            }
+        }
+
+        break;
+
+    case SC_LOGOUT_TC:
+        statistics.loggedOut = true;
+        close();
+        break;
+    }
+}
+
+void Bot::scheduleAction() {
+    if (stopping) {
+        return;
+    }
+
+    // spread the bots so they don't all act in the same tick
+    std::uniform_int_distribution<int> jitter(0, settings.actionInterval.count() / 2);
+    actionTimer.expires_from_now(settings.actionInterval + std::chrono::milliseconds(jitter(random)));
+    actionTimer.async_wait(std::bind(&Bot::handleAction, shared_from_this(), std::placeholders::_1));
+}
+
+void Bot::handleAction(const boost::system::error_code &error) {
+    if (error || stopping || !socket.is_open()) {
+        return;
+    }
+
+    std::uniform_int_distribution<int> choice(0, 99);
+    const int action = choice(random);
+
+    if (action < 60) {
+        walk();
+    } else if (action < 75) {
+        talk();
+    } else if (action < 90) {
+        use();
+    } else {
+        look();
+    }
+
+    // the server drops connections that stay silent for too long
+    if (++actions % 20 == 0) {
+        send(ClientMessage(C_KEEPALIVE_TS).finish());
+    }
+
+    scheduleAction();
+}
+
+void Bot::walk() {
+    std::uniform_int_distribution<int> direction(0, 7);
+    ClientMessage move(C_CHARMOVE_TS);
+    move.addInt(id);
+    move.addUnsignedChar(direction(random));
+    move.addUnsignedChar(NORMALMOVE);
+    pendingMoves.push_back(Clock::now());
+    send(move.finish());
+}
+
+void Bot::talk() {
+    ClientMessage say(C_SAY_TS);
+    say.addString("load test message " + std::to_string(actions) + " from " + name);
+    send(say.finish());
+}
+
+void Bot::use() {
+    ClientMessage use(C_USE_TS);
+    use.addUnsignedChar(UID_KOORD);
+    use.addShortInt(x);
+    use.addShortInt(y);
+    use.addShortInt(z);
+    send(use.finish());
+}
+
+void Bot::look() {
+    std::uniform_int_distribution<int> slot(0, MAX_BODY_ITEMS + MAX_BELT_SLOTS - 1);
+    ClientMessage lookAt(C_LOOKATINVENTORYITEM_TS);
+    lookAt.addUnsignedChar(slot(random));
+    send(lookAt.finish());
+}
+
+void Bot::send(const Buffer &command) {
+    statistics.bytesSent += command.size();
+    ++statistics.commandsSent;
+    writeQueue.push_back(command);
+
+    if (writeQueue.size() == 1) {
+        writeNext();
+    }
+}
+
+void Bot::writeNext() {
+    boost::asio::async_write(socket, boost::asio::buffer(writeQueue.front()), std::bind(&Bot::handleWrite, shared_from_this(), std::placeholders::_1));
+}
+
+void Bot::handleWrite(const boost::system::error_code &error) {
+    if (error) {
+        close();
+        return;
+    }
+
+    writeQueue.pop_front();
+
+    if (!writeQueue.empty()) {
+        writeNext();
+    }
+}
+
+void Bot::close() {
+    if (!socket.is_open()) {
+        return;
+    }
+
+    if (!stopping && !statistics.loggedOut) {
+        statistics.connectionLost = true;
+    }
+
+    stopping = true;
+    actionTimer.cancel();
+    boost::system::error_code error;
+    socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+    socket.close(error);
+}
+
+}
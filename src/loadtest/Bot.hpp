@@ -0,0 +1,118 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _LOADTEST_BOT_HPP_
+#define _LOADTEST_BOT_HPP_
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+
+namespace LoadTest {
+
+struct BotSettings {
+    uint8_t clientVersion = 122;
+    std::string password;
+    std::chrono::milliseconds actionInterval{500};
+};
+
+struct BotStatistics {
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t commandsSent = 0;
+    uint64_t commandsReceived = 0;
+    // microseconds between a move and its acknowledgement
+    std::vector<uint32_t> moveLatencies;
+    bool loggedIn = false;
+    bool loggedOut = false;
+    bool connectionLost = false;
+};
+
+/**
+* a synthetic client speaking the game protocol
+*
+* After logging in the bot randomly walks, talks, uses the field it stands
+* on and looks at its inventory, one action per action interval.
+* All handlers run on the io_service of the load test, so one thread can
+* drive many bots.
+*/
+class Bot : public std::enable_shared_from_this<Bot> {
+public:
+    Bot(boost::asio::io_service &io_service, const BotSettings &settings, const std::string &name, unsigned int seed);
+
+    void start(const boost::asio::ip::tcp::endpoint &endpoint);
+
+    /**
+    * sends a logout and closes the connection shortly after
+    */
+    void stop();
+
+    const BotStatistics &getStatistics() const {
+        return statistics;
+    }
+
+private:
+    typedef std::vector<unsigned char> Buffer;
+    typedef std::chrono::steady_clock Clock;
+
+    void handleConnect(const boost::system::error_code &error);
+    void readHeader();
+    void handleHeader(const boost::system::error_code &error);
+    void handleData(const boost::system::error_code &error);
+    void handleCommand(unsigned char id);
+
+    void scheduleAction();
+    void handleAction(const boost::system::error_code &error);
+    void walk();
+    void talk();
+    void use();
+    void look();
+
+    void send(const Buffer &command);
+    void writeNext();
+    void handleWrite(const boost::system::error_code &error);
+    void close();
+
+    boost::asio::ip::tcp::socket socket;
+    boost::asio::steady_timer actionTimer;
+    BotSettings settings;
+    std::string name;
+    std::mt19937 random;
+
+    unsigned char headerBuffer[6];
+    Buffer readBuffer;
+    std::deque<Buffer> writeQueue;
+
+    int32_t id = 0;
+    int16_t x = 0, y = 0, z = 0;
+    uint32_t actions = 0;
+    std::deque<Clock::time_point> pendingMoves;
+    bool stopping = false;
+
+    BotStatistics statistics;
+};
+
+}
+
+#endif
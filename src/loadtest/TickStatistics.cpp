@@ -0,0 +1,103 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "loadtest/TickStatistics.hpp"
+#include "db/SelectQuery.hpp"
+#include "db/Result.hpp"
+
+namespace LoadTest {
+
+Histogram loadHistogram(const std::string &type) {
+    using namespace Database;
+
+    SelectQuery typeQuery;
+    typeQuery.addColumn("statistics_types", "stat_type_id");
+    typeQuery.addEqualCondition<std::string>("statistics_types", "stat_type_name", type);
+    typeQuery.addServerTable("statistics_types");
+
+    auto typeResult = typeQuery.execute();
+    Histogram histogram;
+
+    if (typeResult.empty()) {
+        return histogram;
+    }
+
+    SelectQuery query;
+    query.addColumn("statistics", "stat_bin");
+    query.addColumn("statistics", "stat_count");
+    query.addEqualCondition<int>("statistics", "stat_type", typeResult.front()["stat_type_id"].as<int>());
+    // ticks without anybody online are not part of the load
+    query.addNotEqualCondition<int>("statistics", "stat_players", 0);
+    query.addServerTable("statistics");
+
+    for (const auto &row : query.execute()) {
+        histogram[row["stat_bin"].as<int>()] += row["stat_count"].as<uint64_t>();
+    }
+
+    return histogram;
+}
+
+Histogram subtract(const Histogram &after, const Histogram &before) {
+    Histogram difference;
+
+    for (const auto &bin : after) {
+        const auto it = before.find(bin.first);
+        const uint64_t old = (it == before.end()) ? 0 : it->second;
+
+        if (bin.second > old) {
+            difference[bin.first] = bin.second - old;
+        }
+    }
+
+    return difference;
+}
+
+uint64_t sampleCount(const Histogram &histogram) {
+    uint64_t count = 0;
+
+    for (const auto &bin : histogram) {
+        count += bin.second;
+    }
+
+    return count;
+}
+
+int percentile(const Histogram &histogram, double fraction) {
+    const uint64_t count = sampleCount(histogram);
+
+    if (count == 0) {
+        return -1;
+    }
+
+    const auto rank = static_cast<uint64_t>(fraction * (count - 1));
+    uint64_t seen = 0;
+
+    for (const auto &bin : histogram) {
+        seen += bin.second;
+
+        if (seen > rank) {
+            return bin.first;
+        }
+    }
+
+    return histogram.rbegin()->first;
+}
+
+}
@@ -0,0 +1,56 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _LOADTEST_TICK_STATISTICS_HPP_
+#define _LOADTEST_TICK_STATISTICS_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace LoadTest {
+
+// number of samples per duration in milliseconds
+typedef std::map<int, uint64_t> Histogram;
+
+/**
+* reads a timing statistic the server persists through Statistic::Statistics,
+* summed over all server versions and player counts except an empty server
+* @param type name of the statistics type, e.g. "turntheworld" for the world tick task
+* @return the histogram, empty if the type is unknown
+*/
+Histogram loadHistogram(const std::string &type);
+
+/**
+* @return the samples recorded in after but not yet in before
+*/
+Histogram subtract(const Histogram &after, const Histogram &before);
+
+uint64_t sampleCount(const Histogram &histogram);
+
+/**
+* @param fraction the percentile as fraction, e.g. 0.99
+* @return the smallest duration at or below which the fraction of samples lies, -1 if there are no samples
+*/
+int percentile(const Histogram &histogram, double fraction);
+
+}
+
+#endif
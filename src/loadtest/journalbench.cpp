@@ -0,0 +1,104 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+
+
+
+// Measures what the map journal costs per field change. Run
+//   journalbench [changes per tick] [ticks] [record bytes]
+// Every tick frames one record per change into a batch and hands it to the
+// journal, the way the world does at the end of a tick. The time spent on
+// the tick thread is reported apart from the time until everything is
+// synced to disk, for several sync intervals.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "MapJournal.hpp"
+
+namespace {
+
+struct Result {
+    double tickSeconds;
+    double totalSeconds;
+};
+
+Result run(const std::string &path, std::chrono::milliseconds syncInterval, int changes, int ticks, const std::string &record) {
+    double tickSeconds = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    {
+        MapJournal journal(path, syncInterval);
+
+        for (int tick = 0; tick < ticks; ++tick) {
+            const auto tickStart = std::chrono::steady_clock::now();
+            std::string batch;
+
+            for (int i = 0; i < changes; ++i) {
+                MapJournal::addRecord(batch, record);
+            }
+
+            journal.append(std::move(batch));
+            tickSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - tickStart).count();
+        }
+
+        journal.flush();
+
+        if (journal.getFailedWrites() > 0) {
+            std::cerr << "journal writes failed" << std::endl;
+        }
+    }
+
+    std::remove(path.c_str());
+    return {tickSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const int changes = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int ticks = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const int recordBytes = argc > 3 ? std::atoi(argv[3]) : 80;
+
+    if (changes <= 0 || ticks <= 0 || recordBytes <= 0) {
+        std::cerr << "usage: " << argv[0] << " [changes per tick] [ticks] [record bytes]" << std::endl;
+        return 1;
+    }
+
+    const std::string path = "journalbench_" + std::to_string(::getpid());
+    const std::string record(recordBytes, 'x');
+    const int syncIntervals[] = {0, 10, 100};
+
+    for (const auto interval : syncIntervals) {
+        const auto result = run(path, std::chrono::milliseconds(interval), changes, ticks, record);
+        const double total = double(changes) * ticks;
+
+        std::cout << "sync every " << interval << " ms: "
+                  << static_cast<int>(result.tickSeconds / total * 1e9) << " ns per change on the tick, "
+                  << static_cast<int>(total / result.totalSeconds / 1000) << "k changes/s synced" << std::endl;
+    }
+
+    return 0;
+}
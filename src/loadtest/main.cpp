@@ -0,0 +1,263 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+// Load test for the game server: drives a number of synthetic clients
+// against a running server and reports latency, traffic and tick durations.
+// Bots log in as <prefix><number>, setup/loadtest.sql creates matching
+// accounts and characters.
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "Config.hpp"
+#include "db/ConnectionManager.hpp"
+#include "db/SchemaHelper.hpp"
+#include "loadtest/Bot.hpp"
+#include "loadtest/TickStatistics.hpp"
+
+using namespace LoadTest;
+
+namespace {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 3012;
+    unsigned int bots = 50;
+    unsigned int duration = 120;
+    unsigned int rampUp = 50;
+    std::string prefix = "Loadbot";
+    BotSettings bot;
+    std::string config;
+    int maxTickP99 = -1;
+    int maxLatencyP99 = -1;
+};
+
+void usage(const char *program) {
+    std::cout << "usage: " << program << " [options]\n"
+              << "  --host <address>        server address (127.0.0.1)\n"
+              << "  --port <port>           server port (3012)\n"
+              << "  --bots <n>              number of synthetic clients (50)\n"
+              << "  --duration <s>          seconds to run after all bots started (120)\n"
+              << "  --ramp-up <ms>          delay between two bot logins (50)\n"
+              << "  --prefix <name>         character names are <prefix><n> (Loadbot)\n"
+              << "  --password <pwd>        password sent by every bot (loadbot)\n"
+              << "  --client-version <v>    client version sent on login (122)\n"
+              << "  --interval <ms>         mean time between two actions of a bot (500)\n"
+              << "  --config <file>         server config, enables tick durations from the database\n"
+              << "  --max-tick-p99 <ms>     fail if the 99th percentile tick duration is higher\n"
+              << "  --max-latency-p99 <ms>  fail if the 99th percentile move latency is higher\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+    options.bot.password = "loadbot";
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+
+        try {
+            if (option == "--host") {
+                options.host = value;
+            } else if (option == "--port") {
+                options.port = std::stoi(value);
+            } else if (option == "--bots") {
+                options.bots = std::stoi(value);
+            } else if (option == "--duration") {
+                options.duration = std::stoi(value);
+            } else if (option == "--ramp-up") {
+                options.rampUp = std::stoi(value);
+            } else if (option == "--prefix") {
+                options.prefix = value;
+            } else if (option == "--password") {
+                options.bot.password = value;
+            } else if (option == "--client-version") {
+                options.bot.clientVersion = std::stoi(value);
+            } else if (option == "--interval") {
+                options.bot.actionInterval = std::chrono::milliseconds(std::stoi(value));
+            } else if (option == "--config") {
+                options.config = value;
+            } else if (option == "--max-tick-p99") {
+                options.maxTickP99 = std::stoi(value);
+            } else if (option == "--max-latency-p99") {
+                options.maxLatencyP99 = std::stoi(value);
+            } else {
+                return false;
+            }
+        } catch (std::exception &) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+double latencyPercentile(std::vector<uint32_t> &samples, double fraction) {
+    if (samples.empty()) {
+        return -1;
+    }
+
+    const auto rank = samples.begin() + static_cast<size_t>(fraction * (samples.size() - 1));
+    std::nth_element(samples.begin(), rank, samples.end());
+    return *rank / 1000.0;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const bool withTicks = !options.config.empty();
+    Histogram ticksBefore;
+
+    if (withTicks) {
+        if (!Config::load(options.config)) {
+            std::cerr << "could not read config " << options.config << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        Database::ConnectionManager::getInstance().setupManager();
+        Database::SchemaHelper::setSchemata();
+        ticksBefore = loadHistogram("turntheworld");
+    }
+
+    boost::asio::io_service io_service;
+    const boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string(options.host), options.port);
+
+    std::vector<std::shared_ptr<Bot>> bots;
+    boost::asio::steady_timer rampTimer(io_service);
+    boost::asio::steady_timer runTimer(io_service);
+
+    std::function<void(const boost::system::error_code &)> startNext = [&](const boost::system::error_code &) {
+        auto bot = std::make_shared<Bot>(io_service, options.bot, options.prefix + std::to_string(bots.size() + 1), bots.size() + 1);
+        bot->start(endpoint);
+        bots.push_back(bot);
+
+        if (bots.size() < options.bots) {
+            rampTimer.expires_from_now(std::chrono::milliseconds(options.rampUp));
+            rampTimer.async_wait(startNext);
+        } else {
+            runTimer.expires_from_now(std::chrono::seconds(options.duration));
+            runTimer.async_wait([&](const boost::system::error_code &) {
+                for (const auto &bot : bots) {
+                    bot->stop();
+                }
+
+                // give the server time to confirm the logouts
+                runTimer.expires_from_now(std::chrono::seconds(5));
+                runTimer.async_wait([&](const boost::system::error_code &) {
+                    io_service.stop();
+                });
+            });
+        }
+    };
+
+    if (options.bots > 0) {
+        io_service.post(std::bind(startNext, boost::system::error_code()));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    io_service.run();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned int loggedIn = 0, lost = 0;
+    uint64_t bytesSent = 0, bytesReceived = 0, commandsSent = 0;
+    std::vector<uint32_t> latencies;
+
+    for (const auto &bot : bots) {
+        const auto &statistics = bot->getStatistics();
+        loggedIn += statistics.loggedIn ? 1 : 0;
+        lost += statistics.connectionLost ? 1 : 0;
+        bytesSent += statistics.bytesSent;
+        bytesReceived += statistics.bytesReceived;
+        commandsSent += statistics.commandsSent;
+        latencies.insert(latencies.end(), statistics.moveLatencies.begin(), statistics.moveLatencies.end());
+    }
+
+    const double players = std::max(loggedIn, 1u);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "bots logged in:         " << loggedIn << "/" << options.bots << ", connections lost: " << lost << "\n";
+    std::cout << "commands sent:          " << commandsSent << " in " << seconds << " s\n";
+    std::cout << "bytes sent per player:  " << bytesSent / players << " (" << bytesSent / players / seconds << " /s)\n";
+    std::cout << "bytes recv per player:  " << bytesReceived / players << " (" << bytesReceived / players / seconds << " /s)\n";
+    std::cout << "move acks:              " << latencies.size() << "\n";
+
+    const double latencyP99 = latencyPercentile(latencies, 0.99);
+
+    if (!latencies.empty()) {
+        std::cout << "move latency ms:        p50 " << latencyPercentile(latencies, 0.5)
+                  << "  p90 " << latencyPercentile(latencies, 0.9)
+                  << "  p99 " << latencyP99
+                  << "  max " << latencyPercentile(latencies, 1.0) << "\n";
+    }
+
+    int tickP99 = -1;
+
+    if (withTicks) {
+        // the server persists its statistics once a minute, wait for the save covering the end of the run
+        const Histogram ticksAtEnd = loadHistogram("turntheworld");
+        Histogram ticksAfter = ticksAtEnd;
+
+        for (int attempt = 0; attempt < 15 && ticksAfter == ticksAtEnd; ++attempt) {
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+            ticksAfter = loadHistogram("turntheworld");
+        }
+
+        const Histogram ticks = subtract(ticksAfter, ticksBefore);
+        tickP99 = percentile(ticks, 0.99);
+        std::cout << "ticks:                  " << sampleCount(ticks) << "\n";
+        std::cout << "tick duration ms:       p50 " << percentile(ticks, 0.5)
+                  << "  p90 " << percentile(ticks, 0.9)
+                  << "  p99 " << tickP99
+                  << "  max " << percentile(ticks, 1.0) << "\n";
+    }
+
+    bool failed = loggedIn < options.bots || lost > 0;
+
+    if (options.maxLatencyP99 >= 0 && latencyP99 > options.maxLatencyP99) {
+        std::cout << "FAILED: move latency p99 above " << options.maxLatencyP99 << " ms\n";
+        failed = true;
+    }
+
+    if (options.maxTickP99 >= 0 && tickP99 > options.maxTickP99) {
+        std::cout << "FAILED: tick duration p99 above " << options.maxTickP99 << " ms\n";
+        failed = true;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+
+
+// Measures handing items between threads under contention, comparing the
+// bounded_queue with a std::list guarded by one mutex, which is how
+// thread_safe_vector used to work. Run
+//   queuebench [items per producer]
+// Every combination of producers and consumers hands over the given number
+// of items per producer, consumers either poll or block in pop.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.hpp"
+
+namespace {
+
+class LockedList {
+public:
+    void push(int item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(item);
+    }
+
+    bool pop(int &item) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (items.empty()) {
+            return false;
+        }
+
+        item = items.front();
+        items.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::list<int> items;
+};
+
+struct Result {
+    double seconds;
+    uint64_t full;
+};
+
+template<class Push, class Pop> Result run(int producers, int consumers, int items, Push push, Pop pop) {
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&push, items] {
+            for (int i = 1; i <= items; ++i) {
+                push(i);
+            }
+        });
+    }
+
+    const int total = producers * items;
+    const int perConsumer = total / consumers;
+
+    for (int c = 0; c < consumers; ++c) {
+        const int share = c == 0 ? total - perConsumer * (consumers - 1) : perConsumer;
+
+        threads.emplace_back([&pop, share] {
+            for (int i = 0; i < share; ++i) {
+                pop();
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    return {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 0};
+}
+
+void print(const char *name, int producers, int consumers, int items, const Result &result) {
+    const double perSecond = producers * items / result.seconds;
+    std::cout << name << " " << producers << "x" << consumers << ": "
+              << static_cast<int>(perSecond / 1000) << "k items/s";
+
+    if (result.full > 0) {
+        std::cout << ", full " << result.full << " times";
+    }
+
+    std::cout << std::endl;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const int items = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    if (items <= 0) {
+        std::cerr << "usage: " << argv[0] << " [items per producer]" << std::endl;
+        return 1;
+    }
+
+    const int setups[][2] = {{1, 1}, {4, 1}, {1, 4}, {4, 4}};
+
+    for (const auto &setup : setups) {
+        const int producers = setup[0];
+        const int consumers = setup[1];
+
+        {
+            LockedList list;
+            const auto result = run(producers, consumers, items,
+            [&list](int item) {
+                list.push(item);
+            },
+            [&list] {
+                int item;
+
+                while (!list.pop(item)) {
+                    std::this_thread::yield();
+                }
+            });
+            print("locked list         ", producers, consumers, items, result);
+        }
+
+        {
+            bounded_queue<int> queue(1024);
+            auto result = run(producers, consumers, items,
+            [&queue](int item) {
+                queue.push(item);
+            },
+            [&queue] {
+                int item;
+
+                while (!queue.try_pop(item)) {
+                    std::this_thread::yield();
+                }
+            });
+            result.full = queue.getFullCount();
+            print("bounded queue, poll ", producers, consumers, items, result);
+        }
+
+        {
+            bounded_queue<int> queue(1024);
+            auto result = run(producers, consumers, items,
+            [&queue](int item) {
+                queue.push(item);
+            },
+            [&queue] {
+                int item;
+                queue.pop(item);
+            });
+            result.full = queue.getFullCount();
+            print("bounded queue, wait ", producers, consumers, items, result);
+        }
+    }
+
+    return 0;
+}
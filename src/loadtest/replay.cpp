@@ -0,0 +1,265 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+// Replays a client command capture against a running server. Start the
+// server on a snapshot of the world taken when the capture began and with
+// random_seed set to the seed of the capture, then run
+//   replay <capture> [--host <address>] [--port <port>] [--speed <factor>]
+// Every captured connection is opened again and sends its commands with the
+// recorded timing divided by the speed factor, 0 sends as fast as possible.
+
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <boost/asio.hpp>
+
+#include "netinterface/CommandCapture.hpp"
+
+namespace {
+
+typedef std::vector<unsigned char> Buffer;
+
+class ReplayConnection : public std::enable_shared_from_this<ReplayConnection> {
+public:
+    explicit ReplayConnection(boost::asio::io_service &io_service) : socket(io_service) {
+    }
+
+    void start(const boost::asio::ip::tcp::endpoint &endpoint) {
+        socket.async_connect(endpoint, std::bind(&ReplayConnection::handleConnect, shared_from_this(), std::placeholders::_1));
+    }
+
+    void send(const CommandCapture::Record &record) {
+        Buffer frame = {
+            record.command,
+            static_cast<unsigned char>(record.command xor 255),
+            static_cast<unsigned char>(record.data.size() >> 8),
+            static_cast<unsigned char>(record.data.size() & 255),
+            static_cast<unsigned char>(record.checkSum >> 8),
+            static_cast<unsigned char>(record.checkSum & 255)
+        };
+        frame.insert(frame.end(), record.data.begin(), record.data.end());
+        writeQueue.push_back(std::move(frame));
+
+        if (connected && writeQueue.size() == 1) {
+            writeNext();
+        }
+    }
+
+    // closes the connection once everything queued was sent
+    void finish() {
+        finishing = true;
+
+        if (connected && writeQueue.empty()) {
+            close();
+        }
+    }
+
+    uint64_t getBytesReceived() const {
+        return bytesReceived;
+    }
+
+    bool failed() const {
+        return connectFailed;
+    }
+
+private:
+    void handleConnect(const boost::system::error_code &error) {
+        if (error) {
+            connectFailed = true;
+            writeQueue.clear();
+            return;
+        }
+
+        connected = true;
+        read();
+
+        if (!writeQueue.empty()) {
+            writeNext();
+        } else if (finishing) {
+            close();
+        }
+    }
+
+    void read() {
+        socket.async_read_some(boost::asio::buffer(readBuffer), std::bind(&ReplayConnection::handleRead, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+    }
+
+    void handleRead(const boost::system::error_code &error, size_t bytes) {
+        if (error) {
+            return;
+        }
+
+        // server commands are not interpreted, only counted
+        bytesReceived += bytes;
+        read();
+    }
+
+    void writeNext() {
+        boost::asio::async_write(socket, boost::asio::buffer(writeQueue.front()), std::bind(&ReplayConnection::handleWrite, shared_from_this(), std::placeholders::_1));
+    }
+
+    void handleWrite(const boost::system::error_code &error) {
+        if (error) {
+            writeQueue.clear();
+            return;
+        }
+
+        writeQueue.pop_front();
+
+        if (!writeQueue.empty()) {
+            writeNext();
+        } else if (finishing) {
+            close();
+        }
+    }
+
+    void close() {
+        boost::system::error_code error;
+        socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+        socket.close(error);
+    }
+
+    boost::asio::ip::tcp::socket socket;
+    std::deque<Buffer> writeQueue;
+    unsigned char readBuffer[4096];
+    uint64_t bytesReceived = 0;
+    bool connected = false;
+    bool connectFailed = false;
+    bool finishing = false;
+};
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc % 2 != 0) {
+        std::cout << "usage: " << argv[0] << " <capture> [--host <address>] [--port <port>] [--speed <factor>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string host = "127.0.0.1";
+    uint16_t port = 3012;
+    double speed = 1.0;
+
+    try {
+        for (int i = 2; i < argc; i += 2) {
+            const std::string option = argv[i];
+
+            if (option == "--host") {
+                host = argv[i + 1];
+            } else if (option == "--port") {
+                port = std::stoi(argv[i + 1]);
+            } else if (option == "--speed") {
+                speed = std::stod(argv[i + 1]);
+            } else {
+                throw std::invalid_argument(option);
+            }
+        }
+    } catch (std::exception &e) {
+        std::cout << "invalid argument: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    CommandCapture::Reader reader(argv[1]);
+
+    if (!reader.isValid()) {
+        std::cout << argv[1] << " is not a command capture" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "replaying " << argv[1] << ", the server has to run with random_seed " << reader.getSeed() << std::endl;
+
+    boost::asio::io_service io_service;
+    const boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string(host), port);
+    boost::asio::steady_timer timer(io_service);
+    std::unordered_map<uint32_t, std::shared_ptr<ReplayConnection>> connections;
+    std::vector<std::shared_ptr<ReplayConnection>> finished;
+    CommandCapture::Record record;
+    uint64_t records = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::function<void()> scheduleNext;
+
+    const auto dispatch = [&](const boost::system::error_code &) {
+        auto &connection = connections[record.connection];
+
+        if (!connection) {
+            connection = std::make_shared<ReplayConnection>(io_service);
+            connection->start(endpoint);
+        }
+
+        if (record.command == CommandCapture::CONNECTION_CLOSED) {
+            connection->finish();
+            finished.push_back(connection);
+            connections.erase(record.connection);
+        } else {
+            connection->send(record);
+        }
+
+        ++records;
+        scheduleNext();
+    };
+
+    scheduleNext = [&]() {
+        if (!reader.next(record)) {
+            for (auto &connection : connections) {
+                connection.second->finish();
+                finished.push_back(connection.second);
+            }
+
+            connections.clear();
+
+            // let the server process the last commands before disconnecting everybody
+            timer.expires_from_now(std::chrono::seconds(5));
+            timer.async_wait([&](const boost::system::error_code &) {
+                io_service.stop();
+            });
+            return;
+        }
+
+        if (speed > 0) {
+            timer.expires_at(start + std::chrono::milliseconds(static_cast<int64_t>(record.time / speed)));
+        } else {
+            timer.expires_from_now(std::chrono::milliseconds(0));
+        }
+
+        timer.async_wait(dispatch);
+    };
+
+    scheduleNext();
+    io_service.run();
+
+    uint64_t bytesReceived = 0;
+    unsigned int failed = 0;
+
+    for (const auto &connection : finished) {
+        bytesReceived += connection->getBytesReceived();
+        failed += connection->failed() ? 1 : 0;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "replayed " << records << " records on " << finished.size() << " connections in " << seconds << " s, "
+              << bytesReceived << " bytes received, " << failed << " connections failed" << std::endl;
+
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -31,6 +31,7 @@
 #include <sys/time.h>
 
 #include <sstream>
+#include <random>
 
 #include "Field.hpp"
 #include "Player.hpp"
@@ -44,12 +45,14 @@
 #include "InitialConnection.hpp"
 #include "tuningConstants.hpp"
 #include "MonitoringClients.hpp"
+#include "Random.hpp"
 
 #include "data/Data.hpp"
 #include "data/ScriptVariablesTable.hpp"
 
 #include "netinterface/protocol/ServerCommands.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
+#include "netinterface/CommandCapture.hpp"
 
 #include "db/SchemaHelper.hpp"
 #include "db/ConnectionManager.hpp"
@@ -93,11 +96,35 @@ int main(int argc, char *argv[]) {
 
     checkArguments(argc, argv);
 
+    if (!start_log_writer(Config::instance().logfile())) {
+        Logger::error(LogFacility::Other) << "main: could not open log file " << Config::instance().logfile() << ", logging synchronously to syslog" << Log::end;
+    }
+
     Logger::info(LogFacility::Other) << "main: server requires clientversion: " << Config::instance().clientversion << Log::end;
     Logger::info(LogFacility::Other) << "main: listen port: " << Config::instance().port << Log::end;
     Logger::info(LogFacility::Other) << "main: data directory: " << Config::instance().datadir() << Log::end;
     Logger::notice(LogFacility::Script) << "Initialising script log ..." << Log::end;
 
+    // a capture can only be replayed with the same random numbers
+    uint32_t seed = Config::instance().random_seed;
+    const std::string capture = Config::instance().command_capture;
+
+    if (seed == 0 && capture != "none") {
+        seed = std::random_device()();
+    }
+
+    if (seed != 0) {
+        Random::seed(seed);
+    }
+
+    if (capture != "none") {
+        if (CommandCapture::Recorder::get().start(capture, Random::getSeed())) {
+            Logger::notice(LogFacility::Other) << "main: capturing client commands to " << capture << " with random seed " << Random::getSeed() << Log::end;
+        } else {
+            Logger::error(LogFacility::Other) << "main: could not open command capture " << capture << Log::end;
+        }
+    }
+
     // initialise DB Manager
     Database::ConnectionManager::getInstance().setupManager();
     Database::SchemaHelper::setSchemata();
@@ -124,7 +151,7 @@ int main(int argc, char *argv[]) {
     Logger::info(LogFacility::Other) << "create PlayerManager" << Log::end;
     PlayerManager::get().activate();
     Logger::info(LogFacility::Other) << "PlayerManager activated" << Log::end;
-    PlayerManager::TPLAYERVECTOR &newplayers = PlayerManager::get().getLogInPlayers();
+    PlayerManager::PLAYERQUEUE &newplayers = PlayerManager::get().getLogInPlayers();
     world->initNPC();
 
     try {
@@ -142,17 +169,20 @@ int main(int argc, char *argv[]) {
     running = true;
 
     using namespace Statistic;
-    Statistics::getInstance().startTimer("cycle");
+    auto &statistics = Statistics::getInstance();
+    const int cycle = statistics.typeId("cycle");
+    statistics.startTimer(cycle);
 
     while (running) {
         // make sure we don't block the server with processing new players...
         int new_players_processed = 0;
 
         // process new players from connection thread
-        while (!newplayers.empty() && new_players_processed < MAXPLAYERSPROCESSED) {
+        Player *newPlayer = nullptr;
+
+        while (new_players_processed < MAXPLAYERSPROCESSED && newplayers.try_pop(newPlayer)) {
 
             new_players_processed++;
-            Player *newPlayer = newplayers.pop_front();
 
             if (newPlayer) {
                 login_save(newPlayer);
@@ -168,7 +198,7 @@ int main(int argc, char *argv[]) {
                     } catch (Player::LogoutException &e) {
                         ServerCommandPointer cmd = std::make_shared<LogOutTC>(e.getReason());
                         newPlayer->Connection->shutdownSend(cmd);
-                        PlayerManager::get().getLogOutPlayers().push_back(newPlayer);
+                        PlayerManager::get().logout(newPlayer);
                     }
                 }
             }
@@ -177,7 +207,8 @@ int main(int argc, char *argv[]) {
         // run scheduler until next task or for 25ms
         world->scheduler.run_once(std::chrono::seconds(1));
         world->checkPlayerImmediateCommands();
-        Statistics::getInstance().stopTimer("cycle");
+        statistics.setPlayersOnline(world->Players.size());
+        statistics.stopTimer(cycle);
     }
 
 
@@ -191,12 +222,16 @@ int main(int argc, char *argv[]) {
     world->takeMonsterAndNPCFromMap();
 
     world->Save();
+    statistics.stop();
     delete world;
     world = nullptr;
 
     reset_sighandlers();
 
+    CommandCapture::Recorder::get().stop();
+
     Logger::info(LogFacility::Other) << "Illarion has been successfully terminated! " << Log::end;
+    stop_log_writer();
 
     return EXIT_SUCCESS;
 }
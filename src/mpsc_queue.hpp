@@ -0,0 +1,83 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef __mpsc_queue_hpp
+#define __mpsc_queue_hpp
+
+#include <atomic>
+#include <utility>
+
+/**
+* an unbounded lock-free queue for many producers and a single consumer
+*
+* Pushing is one atomic exchange, popping never waits for producers. An
+* item pushed by a producer that was interrupted halfway is only visible
+* once that producer finished its push.
+*/
+template<class T> class mpsc_queue {
+public:
+    mpsc_queue() : head(new Node), tail(head.load()) {
+    }
+
+    mpsc_queue(const mpsc_queue &) = delete;
+    mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+    ~mpsc_queue() {
+        T item;
+
+        while (pop(item)) {
+        }
+
+        delete tail;
+    }
+
+    // any thread
+    void push(const T &item) {
+        Node *node = new Node;
+        node->item = item;
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // consumer thread only
+    bool pop(T &item) {
+        Node *next = tail->next.load(std::memory_order_acquire);
+
+        if (!next) {
+            return false;
+        }
+
+        item = std::move(next->item);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        T item;
+    };
+
+    std::atomic<Node *> head;
+    Node *tail;
+};
+
+#endif
@@ -108,6 +108,13 @@ public:
         return length;
     }
 
+    /**
+     *returns the checksum transmitted in the header
+     */
+    uint16_t getCheckSum() {
+        return checkSum;
+    }
+
     inline uint16_t getMinAP() {
 	return minAP;
     }
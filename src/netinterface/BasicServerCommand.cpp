@@ -23,6 +23,7 @@
 #include <iostream>
 #include <assert.h>
 #include <malloc.h>
+#include <algorithm>
 #include "Connection.hpp"
 #include "netinterface/NetInterface.hpp"
 #include "Logger.hpp"
@@ -63,10 +64,18 @@ void BasicServerCommand::addHeader() {
     //at place 2 and 3 add the length
     if (bufferPos >= 6) { //check if the buffer is large enough to add the data
         int16_t crc = static_cast<int16_t>(checkSum % 0xFFFF);
-        buffer[2] = ((bufferPos-6) >> 8);
-        buffer[3] = ((bufferPos-6) & 255);
-        buffer[4] = (crc >> 8);
-        buffer[5] = (crc & 255);
+        const char header[4] = {
+            static_cast<char>((bufferPos-6) >> 8),
+            static_cast<char>((bufferPos-6) & 255),
+            static_cast<char>(crc >> 8),
+            static_cast<char>(crc & 255)
+        };
+
+        // commands can be shared between connections, don't write to a
+        // finished header while another connection might be sending it
+        if (!std::equal(header, header + 4, buffer + 2)) {
+            std::copy(header, header + 4, buffer + 2);
+        }
     }
 }
 
@@ -74,6 +83,14 @@ int BasicServerCommand::getLength() {
     return bufferPos;
 }
 
+uint64_t BasicServerCommand::getSupersedeKey() const {
+    return supersedeKey;
+}
+
+void BasicServerCommand::setSupersedeKey(uint64_t key) {
+    supersedeKey = key;
+}
+
 char *BasicServerCommand::cmdData() {
     return buffer;
 
@@ -112,6 +129,16 @@ void BasicServerCommand::addUnsignedCharToBuffer(unsigned char data) {
     bufferPos++;
 }
 
+void BasicServerCommand::addDataToBuffer(const std::string &data, uint32_t dataCheckSum) {
+    while ((bufferPos + data.size() + 1) >= static_cast<size_t>(bufferSizeMod*STDBUFFERSIZE)) {
+        resizeBuffer();
+    }
+
+    std::copy(data.begin(), data.end(), buffer + bufferPos);
+    checkSum += dataCheckSum;
+    bufferPos += data.size();
+}
+
 void BasicServerCommand::resizeBuffer() {
     Logger::info(LogFacility::Other) << "Not enough memory. Resizing the send buffer. Current size: " << bufferSizeMod*STDBUFFERSIZE << " bytes." << Log::end;
     //increase the buffer size modifikator
@@ -98,13 +98,32 @@ public:
     */
     void addUnsignedCharToBuffer(unsigned char data);
 
+    /**
+    * Function which adds already encoded data to the buffer of the command
+    * @param data The encoded data
+    * @param dataCheckSum The sum of all bytes of data
+    */
+    void addDataToBuffer(const std::string &data, uint32_t dataCheckSum);
+
     /**
     * Adds all the header information to the top of the buffer
     * which depends on the commands data, like length and checksum
     */
     void addHeader();
 
+    /**
+    * Commands with the same non-zero key describe the same thing, so a newer
+    * one replaces an older one which is still waiting in a send queue
+    * @return The key of this command, 0 if it never replaces another one
+    */
+    uint64_t getSupersedeKey() const;
+
+protected:
+    void setSupersedeKey(uint64_t key);
+
 private:
+    uint64_t supersedeKey = 0;
+
     uint16_t STDBUFFERSIZE; /*<the size of the standard buffer*/
 
     char *buffer;  /*<a pointer to the receive buffer*/
@@ -0,0 +1,122 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "netinterface/CommandCapture.hpp"
+#include <cstring>
+
+namespace CommandCapture {
+
+namespace {
+
+const char MAGIC[8] = {'I', 'L', 'L', 'C', 'A', 'P', '0', '1'};
+
+template<typename T>
+void write(std::ostream &os, T value) {
+    for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+        os.put(static_cast<char>((value >> shift) & 255));
+    }
+}
+
+template<typename T>
+bool read(std::istream &is, T &value) {
+    value = 0;
+
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        const int c = is.get();
+
+        if (c == std::char_traits<char>::eof()) {
+            return false;
+        }
+
+        value = (value << 8) | static_cast<unsigned char>(c);
+    }
+
+    return true;
+}
+
+}
+
+Recorder &Recorder::get() {
+    static Recorder recorder;
+    return recorder;
+}
+
+bool Recorder::start(const std::string &fileName, uint32_t seed) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+
+    file.open(fileName, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.write(MAGIC, sizeof(MAGIC));
+    write(file, seed);
+    startTime = std::chrono::steady_clock::now();
+    active = true;
+    return true;
+}
+
+void Recorder::stop() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    active = false;
+
+    if (file.is_open()) {
+        file.close();
+    }
+}
+
+void Recorder::record(uint32_t connection, unsigned char command, uint16_t checkSum, const unsigned char *data, uint16_t length) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(fileMutex);
+
+    if (!active) {
+        return;
+    }
+
+    write<uint64_t>(file, std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count());
+    write(file, connection);
+    write(file, command);
+    write(file, checkSum);
+    write(file, length);
+    file.write(reinterpret_cast<const char *>(data), length);
+}
+
+Reader::Reader(const std::string &fileName) : file(fileName, std::ios::binary) {
+    char magic[sizeof(MAGIC)];
+
+    if (file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0) {
+        valid = read(file, seed);
+    }
+}
+
+bool Reader::next(Record &record) {
+    uint16_t length;
+
+    if (!valid || !read(file, record.time) || !read(file, record.connection) || !read(file, record.command)
+        || !read(file, record.checkSum) || !read(file, length)) {
+        return false;
+    }
+
+    record.data.resize(length);
+    return length == 0 || file.read(reinterpret_cast<char *>(record.data.data()), length);
+}
+
+}
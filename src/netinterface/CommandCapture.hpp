@@ -0,0 +1,122 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef _COMMAND_CAPTURE_HPP_
+#define _COMMAND_CAPTURE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+* capture files of client command streams, used to replay a busy evening
+* against a snapshot of the world
+*
+* A capture starts with a magic string and the seed of Random, followed by
+* one record per received command: milliseconds since the capture started,
+* the connection it arrived on, the command id, its checksum and the raw
+* command data as sent by the client. Captures include login commands and
+* thereby passwords, so they have to be kept as safe as the account database.
+*/
+namespace CommandCapture {
+
+//! command id of the record written when a client closed its connection
+static const unsigned char CONNECTION_CLOSED = 0x00;
+
+struct Record {
+    uint64_t time = 0;
+    uint32_t connection = 0;
+    unsigned char command = 0;
+    uint16_t checkSum = 0;
+    std::vector<unsigned char> data;
+};
+
+class Recorder {
+public:
+    static Recorder &get();
+
+    /**
+    * starts writing a capture
+    * @param file the capture file, overwritten if it exists
+    * @param seed the seed Random was initialised with
+    * @return false if the file could not be opened
+    */
+    bool start(const std::string &file, uint32_t seed);
+    void stop();
+
+    bool isActive() const {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * @return a number identifying a new connection in the capture
+    */
+    uint32_t nextConnection() {
+        return ++connectionCounter;
+    }
+
+    void record(uint32_t connection, unsigned char command, uint16_t checkSum, const unsigned char *data, uint16_t length);
+
+private:
+    Recorder() = default;
+    Recorder(const Recorder &) = delete;
+    Recorder &operator=(const Recorder &) = delete;
+
+    std::atomic<bool> active{false};
+    std::atomic<uint32_t> connectionCounter{0};
+    std::mutex fileMutex;
+    std::ofstream file;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string &file);
+
+    /**
+    * @return true if the file is a capture
+    */
+    bool isValid() const {
+        return valid;
+    }
+
+    uint32_t getSeed() const {
+        return seed;
+    }
+
+    /**
+    * reads the next record
+    * @return false at the end of the capture
+    */
+    bool next(Record &record);
+
+private:
+    std::ifstream file;
+    bool valid = false;
+    uint32_t seed = 0;
+};
+
+}
+
+#endif
@@ -30,6 +30,7 @@ CommandFactory::CommandFactory() {
     templateList[C_CRAFTINGDIALOG_TS ] = std::make_unique<CraftingDialogTS>();
     templateList[C_LOGIN_TS ] = std::make_unique<LoginCommandTS>();
     templateList[C_SCREENSIZE_TS ] = std::make_unique<ScreenSizeCommandTS>();
+    templateList[C_MAPTRANSFERMODE_TS ] = std::make_unique<MapTransferModeTS>();
     templateList[C_LOOKATMAPITEM_TS ] = std::make_unique<LookAtMapItemTS>();
     templateList[C_USE_TS ] = std::make_unique<UseTS>();
     templateList[C_CAST_TS ] = std::make_unique<CastTS>();
@@ -17,16 +17,75 @@
 //  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
 #include <iomanip>
 #include <functional>
 #include "netinterface/BasicClientCommand.hpp"
 #include "netinterface/protocol/ClientCommands.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
 #include "CommandFactory.hpp"
+#include "netinterface/CommandCapture.hpp"
 #include "Player.hpp"
+#include "Config.hpp"
+#include "Statistics.hpp"
 
 #include "netinterface/NetInterface.hpp"
 
-NetInterface::NetInterface(boost::asio::io_service &io_servicen) : online(false), socket(io_servicen), inactive(0) {
+namespace {
+
+using Statistic::Statistics;
+
+// queued commands are sent together in a single write
+const size_t maxCommandsPerWrite = 64;
+
+void countBytesIn(int64_t bytes) {
+    static const int bytesIn = Statistics::getInstance().counterId("bytes in");
+    Statistics::getInstance().increment(bytesIn, bytes);
+}
+
+void countBytesOut(int64_t bytes) {
+    static const int bytesOut = Statistics::getInstance().counterId("bytes out");
+    Statistics::getInstance().increment(bytesOut, bytes);
+}
+
+// commands waiting in the send queues of all connections
+void countQueuedCommands(int64_t commands) {
+    static const int queuedCommands = Statistics::getInstance().gaugeId("queued server commands");
+    Statistics::getInstance().increment(queuedCommands, commands);
+}
+
+// bytes waiting in the lanes of all connections
+void countQueuedBytes(int64_t bytes) {
+    static const int queuedBytes = Statistics::getInstance().gaugeId("queued server bytes");
+    Statistics::getInstance().increment(queuedBytes, bytes);
+}
+
+void countLaneCommands(NetInterface::SendLane lane, int64_t commands) {
+    static const std::array<int, NetInterface::sendLanes> laneCommands = {{
+        Statistics::getInstance().gaugeId("queued control commands"),
+        Statistics::getInstance().gaugeId("queued movement commands"),
+        Statistics::getInstance().gaugeId("queued chat commands"),
+        Statistics::getInstance().gaugeId("queued map commands")
+    }};
+    Statistics::getInstance().increment(laneCommands[lane], commands);
+}
+
+// replaced by a newer command before they were sent
+void countSupersededCommands(int64_t commands) {
+    static const int superseded = Statistics::getInstance().counterId("superseded server commands");
+    Statistics::getInstance().increment(superseded, commands);
+}
+
+// never sent because the connection was shut down
+void countDiscardedCommands(int64_t commands) {
+    static const int discarded = Statistics::getInstance().counterId("discarded server commands");
+    Statistics::getInstance().increment(discarded, commands);
+}
+
+}
+
+NetInterface::NetInterface(boost::asio::io_service &io_servicen) : online(false), socket(io_servicen), strand(io_servicen), loginTimer(io_servicen), shutdownTimer(io_servicen),
+    captureConnection(CommandCapture::Recorder::get().nextConnection()) {
     cmd.reset();
 }
 
@@ -38,7 +97,14 @@ std::string NetInterface::getIPAdress() {
 NetInterface::~NetInterface() {
     try {
         online = false;
-        sendQueue.clear();
+        size_t discarded = 0;
+
+        for (size_t lane = 0; lane < sendLanes; ++lane) {
+            discarded += dropLane(static_cast<SendLane>(lane));
+        }
+
+        countDiscardedCommands(discarded);
+        countQueuedCommands(-static_cast<int64_t>(queuedCommands.load()));
         socket.close();
     } catch (std::exception &e) {
         Logger::error(LogFacility::Other) << "Error in NetInterface destructor: " << e.what() << Log::end;
@@ -55,10 +121,19 @@ void NetInterface::closeConnection() {
 
 bool NetInterface::activate(Player* player) {
     try {
-    owner = player;
-        boost::asio::async_read(socket,boost::asio::buffer(headerBuffer,6), std::bind(&NetInterface::handle_read_header, shared_from_this(), std::placeholders::_1));
-        ipadress = socket.remote_endpoint().address().to_string();
+        owner = player;
+
+        if (player) {
+            ownerId = player->getId();
+            ownerName = player->to_string();
+        }
+
+        if (ipadress.empty()) {
+            ipadress = socket.remote_endpoint().address().to_string();
+        }
+
         online = true;
+        strand.post(std::bind(&NetInterface::readHeader, shared_from_this(), 0));
         return true;
     } catch (std::exception &e) {
         Logger::error(LogFacility::Other) << "Error in NetInterface::activate for " << player->to_string() << ": " << e.what() << Log::end;
@@ -67,14 +142,26 @@ bool NetInterface::activate(Player* player) {
 }
 
 
+void NetInterface::readHeader(int start) {
+    boost::asio::async_read(socket,boost::asio::buffer(&headerBuffer[start],6-start), strand.wrap(std::bind(&NetInterface::handle_read_header, shared_from_this(), std::placeholders::_1)));
+}
+
 void NetInterface::handle_read_data(const boost::system::error_code &error) {
     if (!error) {
+        countBytesIn(sizeof(headerBuffer) + cmd->getLength());
+
         if (online) {
             try {
                 cmd->decodeData();
 
                 if (cmd->isDataOk()) {
                     cmd->setReceivedTime();
+
+                    auto &recorder = CommandCapture::Recorder::get();
+
+                    if (recorder.isActive()) {
+                        recorder.record(captureConnection, cmd->getDefinitionByte(), cmd->getCheckSum(), cmd->msg_data(), cmd->getLength());
+                    }
                     
                     if (owner == nullptr) {
                         auto login = std::dynamic_pointer_cast<LoginCommandTS>(cmd);
@@ -85,6 +172,14 @@ void NetInterface::handle_read_data(const boost::system::error_code &error) {
                         }
                         
                         loginData = login;
+                        loginTimer.cancel();
+
+                        if (loginHandler) {
+                            LoginHandler handler;
+                            std::swap(handler, loginHandler);
+                            handler(shared_from_this());
+                        }
+
                         return;
                     } else {
                         owner->receiveCommand(cmd);
@@ -109,19 +204,14 @@ void NetInterface::handle_read_data(const boost::system::error_code &error) {
             }
 
             cmd.reset();
-            boost::asio::async_read(socket,boost::asio::buffer(headerBuffer,6), std::bind(&NetInterface::handle_read_header, shared_from_this(), std::placeholders::_1));
+            readHeader();
         }
     } else {
         closeConnection();
-        boost::asio::async_read(socket,boost::asio::buffer(headerBuffer,6), std::bind(&NetInterface::handle_read_header, shared_from_this(), std::placeholders::_1));
+        readHeader();
     }
 }
 
-bool NetInterface::nextInactive() {
-    inactive++;
-    return (inactive > 1000);
-}
-
 void NetInterface::handle_read_header(const boost::system::error_code &error) {
     if (!error) {
         if ((headerBuffer[0] xor 255) == headerBuffer[1]) {
@@ -134,7 +224,7 @@ void NetInterface::handle_read_header(const boost::system::error_code &error) {
 
             if (cmd) {
                 cmd->setHeaderData(length,checkSum);
-                boost::asio::async_read(socket,boost::asio::buffer(cmd->msg_data(),cmd->getLength()), std::bind(&NetInterface::handle_read_data, shared_from_this(), std::placeholders::_1));
+                boost::asio::async_read(socket,boost::asio::buffer(cmd->msg_data(),cmd->getLength()), strand.wrap(std::bind(&NetInterface::handle_read_data, shared_from_this(), std::placeholders::_1)));
                 return;
             }
         }
@@ -153,18 +243,24 @@ void NetInterface::handle_read_header(const boost::system::error_code &error) {
                 }
 
                 //restheader empfangen
-                boost::asio::async_read(socket,boost::asio::buffer(&headerBuffer[start],6-start), std::bind(&NetInterface::handle_read_header, shared_from_this(), std::placeholders::_1));
+                readHeader(start);
                 return;
             }
         }
 
         //Keine Command Signature gefunden wieder 6 Byte Header auslesen
-        boost::asio::async_read(socket,boost::asio::buffer(headerBuffer,6), std::bind(&NetInterface::handle_read_header, shared_from_this(), std::placeholders::_1));
+        readHeader();
 
     } else {
+        auto &recorder = CommandCapture::Recorder::get();
+
+        if (online && recorder.isActive()) {
+            recorder.record(captureConnection, CommandCapture::CONNECTION_CLOSED, 0, nullptr, 0);
+        }
+
         if (online) {
             if (owner) {
-                Logger::error(LogFacility::Other) << "Error in NetInterface::handle_read_header for " << owner->to_string() << " from " << getIPAdress() << ": " << error.message() << Log::end;
+                Logger::error(LogFacility::Other) << "Error in NetInterface::handle_read_header for " << ownerName << " from " << getIPAdress() << ": " << error.message() << Log::end;
             } else {
                 Logger::error(LogFacility::Other) << "Error in NetInterface::handle_read_header from " << getIPAdress() << ": " << error.message() << Log::end;
             }
@@ -172,6 +268,11 @@ void NetInterface::handle_read_header(const boost::system::error_code &error) {
 
         closeConnection();
 
+        // nobody waits for the login of a closed connection
+        if (!owner) {
+            loginHandler = nullptr;
+            loginTimer.cancel();
+        }
     }
 }
 
@@ -179,28 +280,282 @@ void NetInterface::handle_read_header(const boost::system::error_code &error) {
 void NetInterface::addCommand(const ServerCommandPointer &command) {
     if (online) {
         command->addHeader();
-        std::lock_guard<std::mutex> lock(sendQueueMutex);
-        bool write_in_progress = !sendQueue.empty();
-        sendQueue.push_back(command);
+        incomingCommands.push(command);
+        ++queuedCommands;
+        countQueuedCommands(1);
+
+        // one flush takes care of all commands added until it runs
+        if (!flushPending.exchange(true)) {
+            strand.post(std::bind(&NetInterface::flushCommands, shared_from_this()));
+        }
+    }
+}
+
+NetInterface::SendLane NetInterface::getLane(unsigned char definitionByte) {
+    switch (definitionByte) {
+    case SC_SETCOORDINATE_TC:
+    case SC_MOVEACK_TC:
+    case SC_PLAYERSPIN_TC:
+    case SC_APPEARANCE_TC:
+    case SC_REMOVECHAR_TC:
+        return laneMovement;
+
+    case SC_SAY_TC:
+    case SC_WHISPER_TC:
+    case SC_SHOUT_TC:
+    case SC_INFORM_TC:
+        return laneChat;
+
+    // items on the map have to stay in order with the stripes showing them
+    case SC_MAPSTRIPE_TC:
+    case SC_MAPSTRIPEBUNDLE_TC:
+    case SC_MAPCOMPLETE_TC:
+    case SC_ITEMPUT_TC:
+    case SC_ITEMREMOVE_TC:
+    case SC_ITEMUPDATE_TC:
+    case SC_MAPITEMSWAP:
+        return laneMap;
+
+    default:
+        return laneControl;
+    }
+}
+
+void NetInterface::flushCommands() {
+    flushPending = false;
+    ServerCommandPointer command;
+    size_t discarded = 0;
+
+    while (incomingCommands.pop(command)) {
+        if (shutdownCmd) {
+            ++discarded;
+        } else {
+            enqueue(command);
+        }
+    }
+
+    if (discarded > 0) {
+        queuedCommands -= discarded;
+        countQueuedCommands(-static_cast<int64_t>(discarded));
+        countDiscardedCommands(discarded);
+    }
+
+    if (!shutdownCmd) {
+        checkSendBudget();
+    }
+
+    if (!writing && !shutdownCmd) {
+        writeNext();
+    }
+}
+
+void NetInterface::enqueue(const ServerCommandPointer &command) {
+    const auto definitionByte = command->getDefinitionByte();
+    const auto lane = getLane(definitionByte);
+
+    // a full map follows a new coordinate, so waiting map updates are obsolete
+    if (definitionByte == SC_SETCOORDINATE_TC) {
+        countSupersededCommands(dropLane(laneMap));
+    }
+
+    lanes[lane].push_back({command, false});
+    ++laneCommands;
+    queuedBytes += command->getLength();
+    countQueuedBytes(command->getLength());
+    countLaneCommands(lane, 1);
+
+    const auto key = command->getSupersedeKey();
+
+    // the client waits for the acknowledgement of each of its own moves
+    if (key == 0 || (owner && key == MoveAckTC::supersedeKeyOf(ownerId))) {
+        return;
+    }
+
+    auto &latest = latestByKey[key];
+
+    if (latest && drop(*latest)) {
+        countSupersededCommands(1);
+    }
+
+    latest = &lanes[lane].back();
+}
+
+bool NetInterface::drop(QueuedCommand &entry) {
+    if (entry.dropped) {
+        return false;
+    }
+
+    entry.dropped = true;
+    --laneCommands;
+    queuedBytes -= entry.command->getLength();
+    --queuedCommands;
+    countQueuedBytes(-entry.command->getLength());
+    countQueuedCommands(-1);
+    countLaneCommands(getLane(entry.command->getDefinitionByte()), -1);
+    return true;
+}
+
+size_t NetInterface::dropLane(SendLane lane) {
+    size_t dropped = 0;
+
+    for (auto &entry : lanes[lane]) {
+        if (drop(entry)) {
+            ++dropped;
+        }
+    }
+
+    return dropped;
+}
+
+void NetInterface::popFront(SendLane lane) {
+    auto &entry = lanes[lane].front();
+    const auto key = entry.command->getSupersedeKey();
+
+    if (key != 0) {
+        const auto latest = latestByKey.find(key);
+
+        if (latest != latestByKey.end() && latest->second == &entry) {
+            latestByKey.erase(latest);
+        }
+    }
+
+    if (!entry.dropped) {
+        --laneCommands;
+        queuedBytes -= entry.command->getLength();
+        countQueuedBytes(-entry.command->getLength());
+        countLaneCommands(lane, -1);
+        inFlight.push_back(std::move(entry.command));
+    }
+
+    lanes[lane].pop_front();
+}
+
+void NetInterface::checkSendBudget() {
+    static const size_t maxBytes = Config::instance().send_queue_bytes;
+    static const size_t maxCommands = Config::instance().send_queue_commands;
+    static const std::chrono::seconds grace(Config::instance().send_queue_grace);
+
+    if (queuedBytes <= maxBytes && laneCommands <= maxCommands) {
+        overBudget = false;
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (!overBudget) {
+        overBudget = true;
+        overBudgetSince = now;
+        return;
+    }
+
+    if (now - overBudgetSince < grace) {
+        return;
+    }
+
+    static const int overBudgetLogouts = Statistics::getInstance().counterId("send queue logouts");
+    Statistics::getInstance().increment(overBudgetLogouts);
 
+    Logger::warn(LogFacility::Other) << "Logging out " << (owner ? ownerName : getIPAdress())
+                                     << ", the client did not keep up for " << grace.count() << "s: "
+                                     << laneCommands << " commands and " << queuedBytes << " bytes waiting" << Log::end;
+
+    ServerCommandPointer cmd = std::make_shared<LogOutTC>(UNSTABLECONNECTION);
+    cmd->addHeader();
+    startShutdown(cmd);
+}
+
+void NetInterface::writeNext() {
+    writing = false;
+
+    if (!online) {
+        return;
+    }
+
+    inFlight.clear();
+
+    for (size_t lane = 0; lane < sendLanes; ++lane) {
+        while (inFlight.size() < maxCommandsPerWrite && !lanes[lane].empty()) {
+            popFront(static_cast<SendLane>(lane));
+        }
+    }
+
+    writing = !inFlight.empty();
+
+    if (writing) {
         try {
-            if (!write_in_progress && online) {
-                boost::asio::async_write(socket,boost::asio::buffer(sendQueue.front()->cmdData(),sendQueue.front()->getLength()),
-                                         std::bind(&NetInterface::handle_write, shared_from_this(), std::placeholders::_1));
+            writeBuffers.clear();
+
+            for (const auto &command : inFlight) {
+                writeBuffers.push_back(boost::asio::buffer(command->cmdData(), command->getLength()));
             }
+
+            boost::asio::async_write(socket, writeBuffers,
+                                     strand.wrap(std::bind(&NetInterface::handle_write, shared_from_this(), std::placeholders::_1)));
         } catch (std::exception &e) {
-            Logger::error(LogFacility::Other) << "Exception in NetInterface::addCommand: " << e.what() << Log::end;
+            Logger::error(LogFacility::Other) << "Exception in NetInterface::writeNext: " << e.what() << Log::end;
+            writing = false;
             closeConnection();
         }
     }
 }
 
+size_t NetInterface::getQueueSize() {
+    return queuedCommands;
+}
+
+size_t NetInterface::getQueuedBytes() {
+    return queuedBytes;
+}
+
 void NetInterface::shutdownSend(const ServerCommandPointer &command) {
+    command->addHeader();
+    strand.post(std::bind(&NetInterface::startShutdown, shared_from_this(), command));
+}
+
+void NetInterface::startShutdown(const ServerCommandPointer &command) {
+    if (shutdownCmd) {
+        return;
+    }
+
+    shutdownCmd = command;
+    size_t discarded = 0;
+
+    for (size_t lane = 0; lane < sendLanes; ++lane) {
+        discarded += dropLane(static_cast<SendLane>(lane));
+        lanes[lane].clear();
+    }
+
+    latestByKey.clear();
+    countDiscardedCommands(discarded);
+
+    // a client which stopped reading never completes the running write
+    static const boost::posix_time::seconds grace(uint16_t(Config::instance().send_queue_grace));
+    shutdownTimer.expires_from_now(grace);
+    shutdownTimer.async_wait(strand.wrap(std::bind(&NetInterface::handle_shutdown_timeout, shared_from_this(), std::placeholders::_1)));
+
+    // never interleave with a running write
+    if (!writing) {
+        writeShutdown();
+    }
+}
+
+void NetInterface::handle_shutdown_timeout(const boost::system::error_code &error) {
+    if (error) {
+        return;
+    }
+
+    Logger::info(LogFacility::Other) << "Closing the connection to " << (owner ? ownerName : getIPAdress()) << ", the logout could not be sent" << Log::end;
+    closeConnection();
+
+    // aborts the pending writes
+    boost::system::error_code ignored;
+    socket.close(ignored);
+}
+
+void NetInterface::writeShutdown() {
     try {
-        command->addHeader();
-        shutdownCmd = command;
         boost::asio::async_write(socket,boost::asio::buffer(shutdownCmd->cmdData(),shutdownCmd->getLength()),
-                                 std::bind(&NetInterface::handle_write_shutdown, shared_from_this(), std::placeholders::_1));
+                                 strand.wrap(std::bind(&NetInterface::handle_write_shutdown, shared_from_this(), std::placeholders::_1)));
     } catch (std::exception &e) {
         Logger::error(LogFacility::Other) << "Exception in NetInterface::shutownSend: " << e.what() << Log::end;
         closeConnection();
@@ -208,31 +563,44 @@ void NetInterface::shutdownSend(const ServerCommandPointer &command) {
 }
 
 void NetInterface::handle_write(const boost::system::error_code &error) {
-    try {
-        if (!error) {
-            if (online) {
-                std::lock_guard<std::mutex> lock(sendQueueMutex);
-                sendQueue.pop_front();
-
-                if (!sendQueue.empty() && online) {
-                    boost::asio::async_write(socket,boost::asio::buffer(sendQueue.front()->cmdData(),sendQueue.front()->getLength()),
-                                             std::bind(&NetInterface::handle_write, shared_from_this(), std::placeholders::_1));
-                }
-            }
+    writing = false;
+
+    if (!error) {
+        countBytesOut(boost::asio::buffer_size(writeBuffers));
+        countQueuedCommands(-static_cast<int64_t>(inFlight.size()));
+        queuedCommands -= inFlight.size();
+        inFlight.clear();
+
+        if (shutdownCmd) {
+            writeShutdown();
         } else {
+            checkSendBudget();
+
+            if (!shutdownCmd) {
+                writeNext();
+            }
+        }
+    } else {
+        if (online) {
             Logger::error(LogFacility::Other) << "Error in NetInterface::handle_write: " << error.message() << Log::end;
-            closeConnection();
         }
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::Other) << "Exception in NetInterface::handle_write: " << e.what() << Log::end;
+
         closeConnection();
     }
 }
 
 void NetInterface::handle_write_shutdown(const boost::system::error_code &error) {
+    shutdownTimer.cancel();
+
     if (!error) {
+        countBytesOut(shutdownCmd->getLength());
         closeConnection();
-        shutdownCmd.reset();
+
+        // without a player nothing else releases the socket
+        if (!owner) {
+            boost::system::error_code ignored;
+            socket.close(ignored);
+        }
     } else {
         if (online) {
             Logger::error(LogFacility::Other) << "Error in NetInterface::handle_write_shutdown: " << error.message() << Log::end;
@@ -242,3 +610,24 @@ void NetInterface::handle_write_shutdown(const boost::system::error_code &error)
     }
 }
 
+void NetInterface::awaitLogin(const LoginHandler &handler, uint16_t timeout) {
+    strand.post(std::bind(&NetInterface::startLoginTimer, shared_from_this(), handler, timeout));
+}
+
+void NetInterface::startLoginTimer(const LoginHandler &handler, uint16_t timeout) {
+    loginHandler = handler;
+    loginTimer.expires_from_now(boost::posix_time::seconds(timeout));
+    loginTimer.async_wait(strand.wrap(std::bind(&NetInterface::handle_login_timeout, shared_from_this(), std::placeholders::_1)));
+}
+
+void NetInterface::handle_login_timeout(const boost::system::error_code &error) {
+    if (error || !loginHandler) {
+        return;
+    }
+
+    loginHandler = nullptr;
+    Logger::info(LogFacility::Other) << "Connection from " << getIPAdress() << " did not log in in time" << Log::end;
+    ServerCommandPointer cmd = std::make_shared<LogOutTC>(UNSTABLECONNECTION);
+    shutdownSend(cmd);
+}
+
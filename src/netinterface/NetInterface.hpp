@@ -25,8 +25,8 @@
 */
 
 
-//include thread save vector
-#include "thread_safe_vector.hpp"
+#include "mpsc_queue.hpp"
+#include "types.hpp"
 
 #include "Connection.hpp"
 #include "netinterface/BasicClientCommand.hpp"
@@ -34,8 +34,13 @@
 #include "netinterface/CommandFactory.hpp"
 #include <memory>
 #include <boost/asio.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <deque>
-#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <vector>
 
 class LoginCommandTS;
 
@@ -47,6 +52,17 @@ class LoginCommandTS;
 /**
 *@ingroup Netinterface
 *class which holds the network interface and its thread for sending and receiving data
+*
+*All reads and writes of a connection run on its strand, so several io
+*threads can serve different connections at the same time. Other threads
+*hand over commands through a lock-free queue.
+*
+*Waiting commands are sorted into lanes, control first and map last, so a
+*chat line does not wait behind a full map. A queued move or stripe is
+*dropped when a newer one for the same character or place arrives. A client
+*which stays over the configured send queue budget is logged out. If the
+*logout cannot be written within the grace period either, the socket is
+*closed.
 */
 class NetInterface : public std::enable_shared_from_this<NetInterface> {
 public:
@@ -62,9 +78,17 @@ public:
     */
     ~NetInterface();
 
+    typedef std::function<void(const std::shared_ptr<NetInterface> &)> LoginHandler;
+
     void closeConnection(); /*<closes the connection to the client*/
     bool activate(Player* = nullptr); /*<activates the connection starts the sending and receiving threads, if player == nullptr only login command is accepted and processing stops afterwards*/
-    bool nextInactive();
+
+    /**
+    * hands the connection to handler on an io thread once its login command
+    * arrived, logs it out if that takes longer than timeout seconds
+    * must be called before activate
+    */
+    void awaitLogin(const LoginHandler &handler, uint16_t timeout);
 
     /**
     * adds a command to the send queue so it will be sended correctly to the connection
@@ -76,9 +100,23 @@ public:
 
     std::string getIPAdress();
 
-    volatile bool online; /*< if connection is active*/
+    // number of commands waiting to be sent
+    size_t getQueueSize();
+
+    // number of bytes waiting to be sent
+    size_t getQueuedBytes();
 
-    typedef std::deque<ServerCommandPointer> SERVERCOMMANDLIST;
+    std::atomic<bool> online; /*< if connection is active*/
+
+    enum SendLane {
+        laneControl,
+        laneMovement,
+        laneChat,
+        laneMap,
+        sendLanes
+    };
+
+    static SendLane getLane(unsigned char definitionByte);
 
     boost::asio::ip::tcp::socket &getSocket() {
         return socket;
@@ -90,32 +128,74 @@ public:
 
 private:
 
+    void readHeader(int start = 0);
     void handle_read_header(const boost::system::error_code &error);
     void handle_read_data(const boost::system::error_code &error);
 
+    struct QueuedCommand {
+        ServerCommandPointer command;
+        bool dropped;
+    };
+
+    void flushCommands();
+    void enqueue(const ServerCommandPointer &command);
+    bool drop(QueuedCommand &entry);
+    size_t dropLane(SendLane lane);
+    void popFront(SendLane lane);
+    void checkSendBudget();
+    void writeNext();
     void handle_write(const boost::system::error_code &error);
+    void startShutdown(const ServerCommandPointer &command);
+    void writeShutdown();
     void handle_write_shutdown(const boost::system::error_code &error);
+    void handle_shutdown_timeout(const boost::system::error_code &error);
+
+    void startLoginTimer(const LoginHandler &handler, uint16_t timeout);
+    void handle_login_timeout(const boost::system::error_code &error);
 
     //Buffer for the header of messages
     unsigned char headerBuffer[6];
 
     ClientCommandPointer cmd;
     ServerCommandPointer shutdownCmd;
-    ServerCommandPointer cmdToWrite;
 
-    SERVERCOMMANDLIST sendQueue;
+    // only touched on the strand
+    std::array<std::deque<QueuedCommand>, sendLanes> lanes;
+    std::unordered_map<uint64_t, QueuedCommand *> latestByKey;
+    size_t laneCommands = 0;
+    bool writing = false;
+    std::vector<boost::asio::const_buffer> writeBuffers;
+    std::vector<ServerCommandPointer> inFlight;
+    bool overBudget = false;
+    std::chrono::steady_clock::time_point overBudgetSince;
+
+    // commands handed over by other threads
+    mpsc_queue<ServerCommandPointer> incomingCommands;
+    std::atomic<bool> flushPending{false};
+    std::atomic<size_t> queuedCommands{0};
+    std::atomic<size_t> queuedBytes{0};
 
     std::string ipadress;
 
     boost::asio::ip::tcp::socket socket;
+    boost::asio::io_service::strand strand;
 
     //Factory für Commands vom Client
     CommandFactory commandFactory;
-    uint16_t inactive;
-    std::mutex sendQueueMutex;
     std::shared_ptr<LoginCommandTS> loginData;
+    LoginHandler loginHandler;
+    boost::asio::deadline_timer loginTimer;
+    // closes the socket of a client which does not take its logout
+    boost::asio::deadline_timer shutdownTimer;
 
     Player* owner;
+
+    // copied in activate, the strand must not touch a player being saved
+    TYPE_OF_CHARACTER_ID ownerId = 0;
+    std::string ownerName;
+
+    // identifies this connection in command captures
+    uint32_t captureConnection;
 };
 
 
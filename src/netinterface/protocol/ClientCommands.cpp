@@ -257,16 +257,16 @@ void LookAtCharacterTS::performAction(Player *player) {
         Monster *monster = World::get()->Monsters.find(id);
 
         if (monster) {
-            MonsterStruct mon;
+            const MonsterStruct *mon = MonsterDescriptions->find(monster->getMonsterType());
 
-            if (MonsterDescriptions->find(monster->getMonsterType(), mon)) {
-                if (mon.script && mon.script->existsEntrypoint("lookAtMonster")) {
-                    mon.script->lookAtMonster(player, monster, mode);
+            if (mon) {
+                if (mon->script && mon->script->existsEntrypoint("lookAtMonster")) {
+                    mon->script->lookAtMonster(player, monster, mode);
                     return;
                 }
 
-                std::string german = "Das ist: " + mon.nameDe;
-                std::string english = "This is: " + mon.nameEn;
+                std::string german = "Das ist: " + mon->nameDe;
+                std::string english = "This is: " + mon->nameEn;
 
                 ServerCommandPointer cmd = std::make_shared<CharDescription>(id, player->nls(german, english));
                 player->Connection->addCommand(cmd);
@@ -594,13 +594,11 @@ void CastTS::performAction(Player *player) {
                 LuaMageScript->CastMagicOnCharacter(player, Target.character, static_cast<unsigned char>(LTS_NOLTACTION));
 
                 if (Target.character->getType() == Character::monster) {
-                    MonsterStruct monStruct;
                     Monster *temp = dynamic_cast<Monster *>(Target.character);
+                    const MonsterStruct *monStruct = MonsterDescriptions->find(temp->getMonsterType());
 
-                    if (MonsterDescriptions->find(temp->getMonsterType(), monStruct)) {
-                        if (monStruct.script) {
-                            monStruct.script->onCasted(temp,player);
-                        }
+                    if (monStruct && monStruct->script) {
+                        monStruct->script->onCasted(temp,player);
                     }
                 }
 
@@ -701,10 +699,10 @@ void UseTS::performAction(Player *player) {
                         Logger::debug(LogFacility::Script) << "Character is a monster!" << Log::end;
 
                         Monster *scriptMonster = dynamic_cast<Monster *>(tmpCharacter);
-                        MonsterStruct monStruct;
+                        const MonsterStruct *monStruct = MonsterDescriptions->find(scriptMonster->getMonsterType());
 
-                        if (MonsterDescriptions->find(scriptMonster->getMonsterType(),monStruct)) {
-                            LuaMonsterScript = monStruct.script;
+                        if (monStruct) {
+                            LuaMonsterScript = monStruct->script;
                         } else {
                             Logger::error(LogFacility::Script) << "try to use Monster but id: " << scriptMonster->getMonsterType() << " not found in database!" << Log::end;
                         }
@@ -1435,6 +1433,7 @@ void RefreshTS::decodeData() {
 
 void RefreshTS::performAction(Player *player) {
     Logger::debug(LogFacility::World) << *player << " want sended a refresh_ts, sending map!" << Log::end;
+    player->forgetSentStripes();
     player->sendFullMap();
     World::get()->sendAllVisibleCharactersToPlayer(player, true);
 }
@@ -1651,3 +1650,19 @@ ClientCommandPointer ScreenSizeCommandTS::clone() {
     return cmd;
 }
 
+MapTransferModeTS::MapTransferModeTS() : BasicClientCommand(C_MAPTRANSFERMODE_TS) {
+}
+
+void MapTransferModeTS::decodeData() {
+    mode = getUnsignedCharFromBuffer();
+}
+
+void MapTransferModeTS::performAction(Player *player) {
+    player->setMapTransferMode(mode);
+}
+
+ClientCommandPointer MapTransferModeTS::clone() {
+    ClientCommandPointer cmd = std::make_shared<MapTransferModeTS>();
+    return cmd;
+}
+
@@ -29,6 +29,7 @@
 enum clientcommands {
     C_LOGIN_TS = 0x0D,
     C_SCREENSIZE_TS = 0xA0,
+    C_MAPTRANSFERMODE_TS = 0xA1,
     C_CHARMOVE_TS = 0x10,
     C_PLAYERSPIN_TS = 0x11,
     C_LOOKATMAPITEM_TS = 0xFF,
@@ -603,5 +604,16 @@ public:
     virtual ClientCommandPointer clone() override;
 };
 
+class MapTransferModeTS : public BasicClientCommand {
+private:
+    uint8_t mode;
+
+public:
+    MapTransferModeTS();
+    virtual void decodeData() override;
+    virtual void performAction(Player *player) override;
+    virtual ClientCommandPointer clone() override;
+};
+
 #endif
 
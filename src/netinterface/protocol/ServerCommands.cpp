@@ -18,6 +18,8 @@
 
 #include "ServerCommands.hpp"
 
+#include <algorithm>
+
 #include "globals.hpp"
 #include "Item.hpp"
 #include "Player.hpp"
@@ -37,6 +39,15 @@
 #include "dialog/SelectionDialog.hpp"
 #include "dialog/CraftingDialog.hpp"
 
+namespace {
+
+// header, body and dialog id fit without resizing
+uint16_t dialogBufferSize(const EncodedDialog &encodedDialog) {
+    return std::min<size_t>(encodedDialog.body.size() + 11, 0xFFFF);
+}
+
+}
+
 KeepAliveTC::KeepAliveTC() : BasicServerCommand(SC_KEEPALIVE_TC) {
 }
 
@@ -101,37 +112,46 @@ MessageDialogTC::MessageDialogTC(const MessageDialog &messageDialog, unsigned in
     addIntToBuffer(dialogId);
 }
 
-MerchantDialogTC::MerchantDialogTC(const MerchantDialog &merchantDialog, unsigned int dialogId) : BasicServerCommand(SC_MERCHANTDIALOG_TC) {
-    addStringToBuffer(merchantDialog.getTitle());
+template<class Writer>
+void MerchantDialogTC::encode(Writer &writer, const MerchantDialog &merchantDialog) {
+    writer.addStringToBuffer(merchantDialog.getTitle());
     MerchantDialog::index_type size = merchantDialog.getOffersSize();
-    addUnsignedCharToBuffer(size);
+    writer.addUnsignedCharToBuffer(size);
 
     for (auto it = merchantDialog.getOffersBegin(); it != merchantDialog.getOffersEnd(); ++it) {
         const OfferProduct &offer = *it;
-        addShortIntToBuffer(offer.getItem());
-        addStringToBuffer(offer.getName());
-        addIntToBuffer(offer.getPrice());
-        addShortIntToBuffer(offer.getStack());
+        writer.addShortIntToBuffer(offer.getItem());
+        writer.addStringToBuffer(offer.getName());
+        writer.addIntToBuffer(offer.getPrice());
+        writer.addShortIntToBuffer(offer.getStack());
     }
 
     size = merchantDialog.getPrimaryRequestsSize();
-    addUnsignedCharToBuffer(size);
+    writer.addUnsignedCharToBuffer(size);
 
     for (auto it = merchantDialog.getPrimaryRequestsBegin(); it != merchantDialog.getPrimaryRequestsEnd(); ++it) {
-        addShortIntToBuffer(it->getItem());
-        addStringToBuffer(it->getName());
-        addIntToBuffer(it->getPrice());
+        writer.addShortIntToBuffer(it->getItem());
+        writer.addStringToBuffer(it->getName());
+        writer.addIntToBuffer(it->getPrice());
     }
 
     size = merchantDialog.getSecondaryRequestsSize();
-    addUnsignedCharToBuffer(size);
+    writer.addUnsignedCharToBuffer(size);
 
     for (auto it = merchantDialog.getSecondaryRequestsBegin(); it != merchantDialog.getSecondaryRequestsEnd(); ++it) {
-        addShortIntToBuffer(it->getItem());
-        addStringToBuffer(it->getName());
-        addIntToBuffer(it->getPrice());
+        writer.addShortIntToBuffer(it->getItem());
+        writer.addStringToBuffer(it->getName());
+        writer.addIntToBuffer(it->getPrice());
     }
+}
 
+MerchantDialogTC::MerchantDialogTC(const MerchantDialog &merchantDialog, unsigned int dialogId)
+    : MerchantDialogTC(World::get()->dialogCache.get<MerchantDialogTC>(SC_MERCHANTDIALOG_TC, merchantDialog), dialogId) {
+}
+
+MerchantDialogTC::MerchantDialogTC(const std::shared_ptr<const EncodedDialog> &encodedDialog, unsigned int dialogId)
+    : BasicServerCommand(SC_MERCHANTDIALOG_TC, dialogBufferSize(*encodedDialog)) {
+    addDataToBuffer(encodedDialog->body, encodedDialog->checkSum);
     addIntToBuffer(dialogId);
 }
 
@@ -149,37 +169,46 @@ SelectionDialogTC::SelectionDialogTC(const SelectionDialog &selectionDialog, uns
     addIntToBuffer(dialogId);
 }
 
-CraftingDialogTC::CraftingDialogTC(const CraftingDialog &craftingDialog, unsigned int dialogId) : BasicServerCommand(SC_CRAFTINGDIALOG_TC) {
-    addStringToBuffer(craftingDialog.getTitle());
+template<class Writer>
+void CraftingDialogTC::encode(Writer &writer, const CraftingDialog &craftingDialog) {
+    writer.addStringToBuffer(craftingDialog.getTitle());
     CraftingDialog::index_t numberOfGroups = craftingDialog.getGroupsSize();
-    addUnsignedCharToBuffer(numberOfGroups);
+    writer.addUnsignedCharToBuffer(numberOfGroups);
 
     for (auto it = craftingDialog.getGroupsBegin(); it != craftingDialog.getGroupsEnd(); ++it) {
-        addStringToBuffer(*it);
+        writer.addStringToBuffer(*it);
     }
 
     CraftingDialog::index_t numberOfCraftables = craftingDialog.getCraftablesSize();
-    addUnsignedCharToBuffer(numberOfCraftables);
+    writer.addUnsignedCharToBuffer(numberOfCraftables);
 
     for (auto it = craftingDialog.getCraftablesBegin(); it != craftingDialog.getCraftablesEnd(); ++it) {
         uint8_t craftableId = it->first;
         const Craftable &craftable = it->second;
-        addUnsignedCharToBuffer(craftableId);
-        addUnsignedCharToBuffer(craftable.getGroup());
-        addShortIntToBuffer(craftable.getItem());
-        addStringToBuffer(craftable.getName());
-        addShortIntToBuffer(craftable.getDecisecondsToCraft());
-        addUnsignedCharToBuffer(craftable.getCraftedStackSize());
+        writer.addUnsignedCharToBuffer(craftableId);
+        writer.addUnsignedCharToBuffer(craftable.getGroup());
+        writer.addShortIntToBuffer(craftable.getItem());
+        writer.addStringToBuffer(craftable.getName());
+        writer.addShortIntToBuffer(craftable.getDecisecondsToCraft());
+        writer.addUnsignedCharToBuffer(craftable.getCraftedStackSize());
 
         Craftable::index_t numberOfIngredients = craftable.getIngredientsSize();
-        addUnsignedCharToBuffer(numberOfIngredients);
+        writer.addUnsignedCharToBuffer(numberOfIngredients);
 
         for (const auto &ingredient : craftable) {
-            addShortIntToBuffer(ingredient.getItem());
-            addUnsignedCharToBuffer(ingredient.getNumber());
+            writer.addShortIntToBuffer(ingredient.getItem());
+            writer.addUnsignedCharToBuffer(ingredient.getNumber());
         }
     }
+}
 
+CraftingDialogTC::CraftingDialogTC(const CraftingDialog &craftingDialog, unsigned int dialogId)
+    : CraftingDialogTC(World::get()->dialogCache.get<CraftingDialogTC>(SC_CRAFTINGDIALOG_TC, craftingDialog), dialogId) {
+}
+
+CraftingDialogTC::CraftingDialogTC(const std::shared_ptr<const EncodedDialog> &encodedDialog, unsigned int dialogId)
+    : BasicServerCommand(SC_CRAFTINGDIALOG_TC, dialogBufferSize(*encodedDialog)) {
+    addDataToBuffer(encodedDialog->body, encodedDialog->checkSum);
     addIntToBuffer(dialogId);
 }
 
@@ -470,13 +499,17 @@ UpdateShowcaseSlotTC::UpdateShowcaseSlotTC(unsigned char showcase, TYPE_OF_CONTA
     }
 }
 
-MapStripeTC::MapStripeTC(const position &pos, NewClientView::stripedirection dir) : BasicServerCommand(SC_MAPSTRIPE_TC) {
+MapStripeTC::MapStripeTC(const NewClientView &view) : BasicServerCommand(SC_MAPSTRIPE_TC) {
+    const position pos = view.getViewPosition();
     addShortIntToBuffer(pos.x);
     addShortIntToBuffer(pos.y);
     addShortIntToBuffer(pos.z);
-    addUnsignedCharToBuffer(static_cast<unsigned char>(dir));
-    Field **fields =  World::get()->clientview.mapStripe;
-    uint8_t numberOfTiles = World::get()->clientview.getMaxTiles();
+    addUnsignedCharToBuffer(static_cast<unsigned char>(view.getStripeDirection()));
+    // a newer stripe at the same place replaces this one in a send queue
+    setSupersedeKey(uint64_t(SC_MAPSTRIPE_TC) << 56 | uint64_t(view.getStripeDirection()) << 48
+                    | uint64_t(uint16_t(pos.x)) << 32 | uint64_t(uint16_t(pos.y)) << 16 | uint16_t(pos.z));
+    const Field *const *fields = view.mapStripe;
+    uint8_t numberOfTiles = view.getMaxTiles();
     addUnsignedCharToBuffer(numberOfTiles);
 
     for (int i = 0; i < numberOfTiles; ++i) {
@@ -504,6 +537,15 @@ MapStripeTC::MapStripeTC(const position &pos, NewClientView::stripedirection dir
     }
 }
 
+MapStripeBundleTC::MapStripeBundleTC(uint16_t stripes, uint32_t uncompressedSize, const std::vector<unsigned char> &compressed) : BasicServerCommand(SC_MAPSTRIPEBUNDLE_TC, compressed.size() + 16) {
+    addShortIntToBuffer(stripes);
+    addIntToBuffer(uncompressedSize);
+
+    for (const auto byte : compressed) {
+        addUnsignedCharToBuffer(byte);
+    }
+}
+
 MapCompleteTC::MapCompleteTC() : BasicServerCommand(SC_MAPCOMPLETE_TC) {
 }
 
@@ -514,6 +556,11 @@ MoveAckTC::MoveAckTC(TYPE_OF_CHARACTER_ID id, const position &pos, unsigned char
     addShortIntToBuffer(pos.z);
     addUnsignedCharToBuffer(mode);
     addUnsignedCharToBuffer(waitpages);
+    setSupersedeKey(supersedeKeyOf(id));
+}
+
+uint64_t MoveAckTC::supersedeKeyOf(TYPE_OF_CHARACTER_ID id) {
+    return uint64_t(SC_MOVEACK_TC) << 56 | id;
 }
 
 IntroduceTC::IntroduceTC(TYPE_OF_CHARACTER_ID id, const std::string &name) : BasicServerCommand(SC_INTRODUCE_TC) {
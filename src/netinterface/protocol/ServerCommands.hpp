@@ -26,6 +26,7 @@
 #include "Character.hpp"
 
 #include "netinterface/BasicServerCommand.hpp"
+#include "DialogCache.hpp"
 
 struct WeatherStruct;
 class Item;
@@ -40,6 +41,7 @@ enum ServerCommands {
     SC_SETCOORDINATE_TC = 0xBD,
     SC_MAPSTRIPE_TC = 0xA1,
     SC_MAPCOMPLETE_TC = 0xA2,
+    SC_MAPSTRIPEBUNDLE_TC = 0xA3,
     SC_PLAYERSPIN_TC = 0xE0,
     SC_UPDATEINVENTORYPOS_TC = 0xC1,
     SC_CLEARSHOWCASE_TC = 0xC4,
@@ -130,6 +132,11 @@ class MerchantDialog;
 class MerchantDialogTC : public BasicServerCommand {
 public:
     MerchantDialogTC(const MerchantDialog &merchantDialog, unsigned int dialogId);
+    MerchantDialogTC(const std::shared_ptr<const EncodedDialog> &encodedDialog, unsigned int dialogId);
+
+    // everything but the dialog id, for DialogCache
+    template<class Writer>
+    static void encode(Writer &writer, const MerchantDialog &merchantDialog);
 };
 
 class SelectionDialog;
@@ -142,6 +149,11 @@ class CraftingDialog;
 class CraftingDialogTC : public BasicServerCommand {
 public:
     CraftingDialogTC(const CraftingDialog &craftingDialog, unsigned int dialogId);
+    CraftingDialogTC(const std::shared_ptr<const EncodedDialog> &encodedDialog, unsigned int dialogId);
+
+    // everything but the dialog id, for DialogCache
+    template<class Writer>
+    static void encode(Writer &writer, const CraftingDialog &craftingDialog);
 };
 class CraftingDialogCraftTC : public BasicServerCommand {
 public:
@@ -288,7 +300,12 @@ public:
 
 class MapStripeTC : public BasicServerCommand {
 public:
-    MapStripeTC(const position &pos, NewClientView::stripedirection dir);
+    MapStripeTC(const NewClientView &view);
+};
+
+class MapStripeBundleTC : public BasicServerCommand {
+public:
+    MapStripeBundleTC(uint16_t stripes, uint32_t uncompressedSize, const std::vector<unsigned char> &compressed);
 };
 
 class MapCompleteTC : public BasicServerCommand {
@@ -299,6 +316,9 @@ public:
 class MoveAckTC : public BasicServerCommand {
 public:
     MoveAckTC(TYPE_OF_CHARACTER_ID id, const position &pos, unsigned char mode, unsigned char waitpages);
+
+    // a newer move of the same character replaces this one in a send queue
+    static uint64_t supersedeKeyOf(TYPE_OF_CHARACTER_ID id);
 };
 
 class IntroduceTC : public BasicServerCommand {
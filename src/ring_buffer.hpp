@@ -0,0 +1,85 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef __ring_buffer_hpp
+#define __ring_buffer_hpp
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+* a fixed size ring which overwrites its oldest entry when it is full
+*
+* Not thread safe, the owner has to lock. Meant for feeds where the most
+* recent entries matter and a slow reader must not make the writer grow
+* without bound.
+*/
+template<class T> class ring_buffer {
+public:
+    explicit ring_buffer(size_t capacity): items(capacity > 0 ? capacity : 1) {
+    }
+
+    void push(T item) {
+        if (count == items.size()) {
+            first = (first + 1) % items.size();
+            --count;
+            ++dropCount;
+        }
+
+        items[(first + count) % items.size()] = std::move(item);
+        ++count;
+    }
+
+    // moves all entries, oldest first, into out and empties the ring
+    template<class Container> void drain(Container &out) {
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back(std::move(items[(first + i) % items.size()]));
+        }
+
+        first = 0;
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t capacity() const {
+        return items.size();
+    }
+
+    // number of entries overwritten before they were drained
+    uint64_t getDropCount() const {
+        return dropCount;
+    }
+
+private:
+    std::vector<T> items;
+    size_t first = 0;
+    size_t count = 0;
+    uint64_t dropCount = 0;
+};
+
+#endif
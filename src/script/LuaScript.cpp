@@ -55,6 +55,7 @@ extern "C" {
 #include "character_ptr.hpp"
 #include "Random.hpp"
 #include "Config.hpp"
+#include "Statistics.hpp"
 
 #include "data/ScriptVariablesTable.hpp"
 #include "data/Data.hpp"
@@ -259,6 +260,21 @@ void LuaScript::triggerScriptError(const std::string &msg) throw(luabind::error)
     throw luabind::error(_luaState);
 }
 
+void LuaScript::addCallTime(std::chrono::steady_clock::duration duration) {
+    using Statistic::Statistics;
+    auto &statistics = Statistics::getInstance();
+
+    if (!callCountersRegistered) {
+        const std::string name = _filename.empty() ? "unnamed" : _filename;
+        callCounter = statistics.counterId("lua calls " + name);
+        callTimeCounter = statistics.counterId("lua time us " + name);
+        callCountersRegistered = true;
+    }
+
+    statistics.increment(callCounter);
+    statistics.increment(callTimeCounter, std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
 void LuaScript::writeErrorMsg() {
     const char *c_err = lua_tostring(_luaState, -1);
     lua_pop(_luaState, 1);
@@ -600,15 +616,21 @@ void LuaScript::init_base_functions() {
         .def("getSkillName", &Character::getSkillName)
         .def("getSkill", &Character::getSkill)
         .def("getMinorSkill", &Character::getMinorSkill)
-        .def("increaseAttrib", &Character::increaseAttrib)
-        .def("setAttrib", &Character::setAttrib)
-        .def("isBaseAttributeValid", &Character::isBaseAttribValid)
+        .def("increaseAttrib", (Attribute::attribute_t(Character:: *)(const std::string &, int))&Character::increaseAttrib)
+        .def("increaseAttrib", (Attribute::attribute_t(Character:: *)(Character::attributeIndex, int))&Character::increaseAttrib)
+        .def("setAttrib", (void(Character:: *)(const std::string &, Attribute::attribute_t))&Character::setAttrib)
+        .def("setAttrib", (void(Character:: *)(Character::attributeIndex, Attribute::attribute_t))&Character::setAttrib)
+        .def("isBaseAttributeValid", (bool(Character:: *)(const std::string &, Attribute::attribute_t) const)&Character::isBaseAttribValid)
+        .def("isBaseAttributeValid", (bool(Character:: *)(Character::attributeIndex, Attribute::attribute_t) const)&Character::isBaseAttribValid)
         .def("getBaseAttributeSum", &Character::getBaseAttributeSum)
         .def("getMaxAttributePoints", &Character::getMaxAttributePoints)
         .def("saveBaseAttributes", &Character::saveBaseAttributes)
-        .def("setBaseAttribute", &Character::setBaseAttrib)
-        .def("getBaseAttribute", &Character::getBaseAttrib)
-        .def("increaseBaseAttribute", &Character::increaseBaseAttrib)
+        .def("setBaseAttribute", (bool(Character:: *)(const std::string &, Attribute::attribute_t))&Character::setBaseAttrib)
+        .def("setBaseAttribute", (bool(Character:: *)(Character::attributeIndex, Attribute::attribute_t))&Character::setBaseAttrib)
+        .def("getBaseAttribute", (Attribute::attribute_t(Character:: *)(const std::string &))&Character::getBaseAttrib)
+        .def("getBaseAttribute", (Attribute::attribute_t(Character:: *)(Character::attributeIndex))&Character::getBaseAttrib)
+        .def("increaseBaseAttribute", (bool(Character:: *)(const std::string &, int))&Character::increaseBaseAttrib)
+        .def("increaseBaseAttribute", (bool(Character:: *)(Character::attributeIndex, int))&Character::increaseBaseAttrib)
         .def("increaseSkill", &Character::increaseSkill)
         .def("increaseMinorSkill", &Character::increaseMinorSkill)
         .def("setSkill", &Character::setSkill)
@@ -655,6 +677,7 @@ void LuaScript::init_base_functions() {
         .property("movepoints", &Character::getActionPoints, &Character::setActionPoints)
         .property("fightpoints", &Character::getFightPoints, &Character::setFightPoints)
         .property("isinvisible", &Character::isInvisible, &Character::setInvisible)
+        .property("alwaysActive", &Character::isAlwaysActive, &Character::setAlwaysActive)
         .property("attackmode", &Character::getAttackMode)
         //.def_readonly("isTarget", &Character::isTarget)
         .enum_("body_pos")
@@ -704,6 +727,26 @@ void LuaScript::init_base_functions() {
             luabind::value("dir_up",8),
             luabind::value("dir_down",9)
         ]
+        .enum_("attributes")
+        [
+            luabind::value("strength", Character::strength),
+            luabind::value("dexterity", Character::dexterity),
+            luabind::value("constitution", Character::constitution),
+            luabind::value("agility", Character::agility),
+            luabind::value("intelligence", Character::intelligence),
+            luabind::value("perception", Character::perception),
+            luabind::value("willpower", Character::willpower),
+            luabind::value("essence", Character::essence),
+            luabind::value("hitpoints", Character::hitpoints),
+            luabind::value("mana", Character::mana),
+            luabind::value("foodlevel", Character::foodlevel),
+            luabind::value("sex", Character::sex),
+            luabind::value("age", Character::age),
+            luabind::value("weight", Character::weight),
+            luabind::value("height", Character::height),
+            luabind::value("attitude", Character::attitude),
+            luabind::value("luck", Character::luck)
+        ]
         .enum_("character_type")
         [
             luabind::value("player",0),
@@ -33,6 +33,7 @@ extern "C" {
 #include <luabind/object.hpp>
 #include "character_ptr.hpp"
 #include <map>
+#include <chrono>
 #include <cxxabi.h>
 
 class Character;
@@ -181,8 +182,25 @@ private:
         return foundQuest;
     }
 
+    // adds the time until destruction to the call statistics of a script
+    class CallTimer {
+    public:
+        explicit CallTimer(LuaScript &script) : script(script), start(std::chrono::steady_clock::now()) {}
+        ~CallTimer() {
+            script.addCallTime(std::chrono::steady_clock::now() - start);
+        }
+
+    private:
+        LuaScript &script;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void addCallTime(std::chrono::steady_clock::duration duration);
+
     template<typename... Args>
     void safeCall(const std::string &entrypoint, const Args &... args) {
+        CallTimer timer(*this);
+
         try {
             auto luaEntrypoint = buildEntrypoint(entrypoint);
             luaEntrypoint(args...);
@@ -192,6 +210,8 @@ private:
     };
     template<typename T, typename... Args>
     T safeCall(const std::string &entrypoint, const Args &... args) {
+        CallTimer timer(*this);
+
         try {
             auto luaEntrypoint = buildEntrypoint(entrypoint);
             auto result = luaEntrypoint(args...);
@@ -213,6 +233,10 @@ private:
     char luafile[200];
     typedef std::multimap<const std::string, std::shared_ptr<LuaScript> > QuestScripts;
     QuestScripts questScripts;
+    // statistics counters, registered on the first call
+    bool callCountersRegistered = false;
+    int callCounter = -1;
+    int callTimeCounter = -1;
 };
 
 #endif
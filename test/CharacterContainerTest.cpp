@@ -75,6 +75,76 @@ TEST_F(CharacterContainerTest, update) {
     EXPECT_EQ(1, container.size());
 }
 
+TEST_F(CharacterContainerTest, erase) {
+    container.insert(&character);
+    EXPECT_TRUE(container.erase(42));
+    EXPECT_FALSE(container.find(42));
+    EXPECT_FALSE(container.erase(42));
+    EXPECT_TRUE(container.empty());
+}
+
+TEST_F(CharacterContainerTest, eraseWhileIterating) {
+    MockCharacter other;
+    ON_CALL(other, getId()).WillByDefault(Return(43));
+    EXPECT_CALL(other, getId()).Times(AtLeast(0));
+    ON_CALL(other, getPosition()).WillByDefault(ReturnRef(pos));
+    EXPECT_CALL(other, getPosition()).Times(AtLeast(0));
+
+    container.insert(&character);
+    container.insert(&other);
+    int visited = 0;
+
+    container.for_each([&](Character *current) {
+        ++visited;
+
+        if (current == &character) {
+            container.erase(42);
+        }
+    });
+
+    EXPECT_EQ(2, visited);
+    EXPECT_EQ(1, container.size());
+    EXPECT_EQ(nullptr, container.find(42));
+    EXPECT_EQ(&other, container.find(43));
+}
+
+TEST_F(CharacterContainerTest, eraseAfterConstIteration) {
+    MockCharacter other;
+    ON_CALL(other, getId()).WillByDefault(Return(43));
+    EXPECT_CALL(other, getId()).Times(AtLeast(0));
+    ON_CALL(other, getPosition()).WillByDefault(ReturnRef(pos));
+    EXPECT_CALL(other, getPosition()).Times(AtLeast(0));
+
+    container.insert(&other);
+    container.insert(&character);
+    const auto &constContainer = container;
+
+    // leaves a gap at the end, since a const iteration does not compact
+    constContainer.for_each([&](Character *current) {
+        if (current == &character) {
+            container.erase(42);
+        }
+    });
+
+    EXPECT_TRUE(container.erase(43));
+    EXPECT_TRUE(container.empty());
+    EXPECT_EQ(nullptr, container.find(43));
+}
+
+TEST_F(CharacterContainerTest, handle) {
+    EXPECT_EQ(nullptr, container.find(container.getHandle(42)));
+    container.insert(&character);
+    const auto handle = container.getHandle(42);
+    EXPECT_EQ(&character, container.find(handle));
+    container.erase(42);
+    EXPECT_EQ(nullptr, container.find(handle));
+    container.insert(&character);
+    EXPECT_EQ(nullptr, container.find(handle));
+    EXPECT_EQ(&character, container.find(container.getHandle(42)));
+    container.clear();
+    EXPECT_EQ(nullptr, container.find(container.getHandle(42)));
+}
+
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -16,7 +16,7 @@ public:
     }
 
     MOCK_METHOD1(findCharacter, Character*(TYPE_OF_CHARACTER_ID id));
-    MOCK_METHOD2(getMonsterDefinition, bool(TYPE_OF_CHARACTER_ID, MonsterStruct &));
+    MOCK_METHOD1(getMonsterDefinition, const MonsterStruct *(TYPE_OF_CHARACTER_ID));
 };
 
 class Player {};
@@ -94,6 +94,7 @@ using ::testing::SetArgReferee;
 class monster_bindings : public ::testing::Test {
 public:
     MockWorld world;
+    MonsterStruct definition;
     MockMonster *monster;
 
     ~monster_bindings() {
@@ -102,8 +103,8 @@ public:
     }
 
     monster_bindings() {
-        ON_CALL(world, getMonsterDefinition(_, _)).WillByDefault(Return(true));
-        EXPECT_CALL(world, getMonsterDefinition(_, _)).Times(AtLeast(0));
+        ON_CALL(world, getMonsterDefinition(_)).WillByDefault(Return(&definition));
+        EXPECT_CALL(world, getMonsterDefinition(_)).Times(AtLeast(0));
         monster = new MockMonster();
         ON_CALL(world, findCharacter(monster->getId())).WillByDefault(Return(monster));
         EXPECT_CALL(world, findCharacter(monster->getId())).Times(AtLeast(0));
@@ -511,6 +512,31 @@ TEST_F(monster_bindings, getMinorSkill) {
     EXPECT_EQ(74, result);
 }
 
+TEST_F(monster_bindings, increaseAttribByIndex) {
+    LuaTestSupportScript script {"function test(monster) monster:increaseAttrib(Character.attitude, 3) return monster:increaseAttrib('attitude', 0) end"};
+    auto result = script.test<int, Monster *>(monster);
+    EXPECT_EQ(3, result);
+}
+
+TEST_F(monster_bindings, setAttribByIndex) {
+    LuaTestSupportScript script {"function test(monster) monster:setAttrib(Character.attitude, 5) return monster:increaseAttrib('attitude', 0) end"};
+    auto result = script.test<int, Monster *>(monster);
+    EXPECT_EQ(5, result);
+}
+
+TEST_F(monster_bindings, ignoresUnknownAttributeIndex) {
+    LuaTestSupportScript script {"function test(monster) monster:setAttrib(99, 5) monster:increaseBaseAttribute(99, 5) return monster:getBaseAttribute(99) end"};
+    auto result = script.test<int, Monster *>(monster);
+    EXPECT_EQ(0, result);
+}
+
+TEST_F(monster_bindings, alwaysActive) {
+    LuaTestSupportScript script {"function test(monster) monster.alwaysActive = true; return monster.alwaysActive end"};
+    bool result = script.test<bool, Monster *>(monster);
+    EXPECT_TRUE(result);
+    EXPECT_TRUE(monster->isAlwaysActive());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,106 @@
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+#include "bounded_queue.hpp"
+
+TEST(bounded_queue_tests, capacityIsRoundedUpToPowerOfTwo) {
+    bounded_queue<int> queue(5);
+    EXPECT_EQ(8u, queue.capacity());
+}
+
+TEST(bounded_queue_tests, refusesPushWhenFull) {
+    bounded_queue<int> queue(2);
+    int item = 0;
+
+    EXPECT_TRUE(queue.try_push(1));
+    EXPECT_TRUE(queue.try_push(2));
+    EXPECT_FALSE(queue.try_push(3));
+    EXPECT_EQ(1u, queue.getFullCount());
+    EXPECT_EQ(2u, queue.size());
+
+    EXPECT_TRUE(queue.try_pop(item));
+    EXPECT_EQ(1, item);
+    EXPECT_TRUE(queue.try_push(3));
+    EXPECT_TRUE(queue.try_pop(item));
+    EXPECT_EQ(2, item);
+    EXPECT_TRUE(queue.try_pop(item));
+    EXPECT_EQ(3, item);
+    EXPECT_FALSE(queue.try_pop(item));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(bounded_queue_tests, popReturnsFalseOnceClosedAndEmpty) {
+    bounded_queue<int> queue(4);
+    int item = 0;
+
+    queue.push(1);
+    queue.close();
+
+    EXPECT_TRUE(queue.pop(item));
+    EXPECT_EQ(1, item);
+    EXPECT_FALSE(queue.pop(item));
+}
+
+TEST(bounded_queue_tests, closeWakesWaitingConsumer) {
+    bounded_queue<int> queue(4);
+    bool popped = true;
+
+    std::thread consumer([&queue, &popped] {
+        int item;
+        popped = queue.pop(item);
+    });
+
+    queue.close();
+    consumer.join();
+    EXPECT_FALSE(popped);
+}
+
+TEST(bounded_queue_tests, handsOverEveryItemBetweenManyThreads) {
+    bounded_queue<int> queue(16);
+    const int threads = 4;
+    const int itemsPerThread = 10000;
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+    std::vector<long> sums(threads, 0);
+
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&queue] {
+            for (int i = 1; i <= itemsPerThread; ++i) {
+                queue.push(i);
+            }
+        });
+
+        consumers.emplace_back([&queue, &sums, t] {
+            int item;
+
+            while (queue.pop(item)) {
+                sums[t] += item;
+            }
+        });
+    }
+
+    for (auto &producer : producers) {
+        producer.join();
+    }
+
+    queue.close();
+
+    for (auto &consumer : consumers) {
+        consumer.join();
+    }
+
+    long sum = 0;
+
+    for (long s : sums) {
+        sum += s;
+    }
+
+    EXPECT_EQ(threads * (itemsPerThread * (itemsPerThread + 1L) / 2), sum);
+    EXPECT_TRUE(queue.empty());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,10 +1,16 @@
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <thread>
+
 #include "Container.hpp"
 #include "World.hpp"
+#include "data/Data.hpp"
 
 const Item::id_type itemid_1 = 0x23;
 const Item::id_type itemid_2 = 0x42;
+const Item::id_type bagid = 0x50;
+const Item::id_type anvilid = 0x51;
 
 using ::testing::Return;
 using ::testing::ReturnRef;
@@ -71,6 +77,215 @@ TEST_F(container_tests, eraseItemWithoutDataDoesntDeleteDataItem) {
 	EXPECT_EQ(8, container.eraseItem(itemid_1, 10));
 }
 
+TEST_F(container_tests, firstFreeSlotFollowsInsertAndTake) {
+	Item it1{itemid_1, 1, 0};
+	Item taken;
+	Container *cc = nullptr;
+
+	EXPECT_EQ(0, container.getFirstFreeSlot());
+
+	for (int i = 0; i < 70; ++i) {
+		EXPECT_TRUE(container.InsertItem(it1, false));
+	}
+
+	EXPECT_EQ(70, container.getFirstFreeSlot());
+
+	EXPECT_TRUE(container.TakeItemNr(1, taken, cc, 1));
+	EXPECT_TRUE(container.TakeItemNr(65, taken, cc, 1));
+	EXPECT_EQ(1, container.getFirstFreeSlot());
+
+	EXPECT_TRUE(container.InsertItem(it1, false));
+	EXPECT_EQ(65, container.getFirstFreeSlot());
+
+	EXPECT_EQ(0, container.increaseAtPos(0, -1));
+	EXPECT_EQ(0, container.getFirstFreeSlot());
+}
+
+class WeightedItems : public CommonObjectTable {
+public:
+	WeightedItems() {
+		add(itemid_1, 10, 250);
+		add(itemid_2, 7, 1);
+		add(bagid, 100, 1);
+		add(anvilid, 20000, 1);
+		activateBuffer();
+	}
+
+private:
+	void add(Item::id_type id, TYPE_OF_WEIGHT weight, Item::number_type maxStack) {
+		CommonStruct common;
+		common.id = id;
+		common.Weight = weight;
+		common.MaxStack = maxStack;
+		emplace(id, common);
+	}
+};
+
+class Bags : public ContainerObjectTable {
+public:
+	Bags() {
+		emplace(bagid, 10);
+		activateBuffer();
+	}
+};
+
+class container_weight_tests : public container_tests {
+	public:
+		virtual void SetUp() override {
+			Data::CommonItems = WeightedItems();
+			Data::ContainerItems = Bags();
+		}
+
+		virtual void TearDown() override {
+			Data::CommonItems = CommonObjectTable();
+			Data::ContainerItems = ContainerObjectTable();
+		}
+
+		// weight of all contents, recounted from scratch
+		static int recount(const Container &container) {
+			int weight = 0;
+
+			for (const auto &slot : container.getItems()) {
+				const auto &common = Data::CommonItems[slot.second.getId()];
+
+				if (slot.second.isContainer()) {
+					weight += common.Weight;
+					const auto nested = container.getContainers().find(slot.first);
+
+					if (nested != container.getContainers().end()) {
+						weight += recount(*nested->second);
+					}
+				} else {
+					weight += common.Weight * slot.second.getNumber();
+				}
+			}
+
+			return std::min(weight, 30000);
+		}
+
+		// the container inserted last into slot, nullptr if there is none
+		static Container *nested(Container &container, TYPE_OF_CONTAINERSLOTS slot) {
+			const auto it = container.getContainers().find(slot);
+			return it != container.getContainers().end() ? it->second : nullptr;
+		}
+};
+
+TEST_F(container_weight_tests, followsInsertAndTake) {
+	Item taken;
+	Container *cc = nullptr;
+
+	EXPECT_EQ(0, container.weight());
+
+	EXPECT_TRUE(container.InsertItem(Item{itemid_1, 5, 0}));
+	EXPECT_EQ(50, container.weight());
+	EXPECT_TRUE(container.InsertItem(Item{itemid_1, 3, 0}));
+	EXPECT_EQ(80, container.weight());
+	EXPECT_TRUE(container.InsertItem(Item{itemid_2, 1, 0}));
+	EXPECT_EQ(87, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+
+	EXPECT_TRUE(container.TakeItemNr(0, taken, cc, 2));
+	EXPECT_EQ(2, taken.getNumber());
+	EXPECT_EQ(67, container.weight());
+	EXPECT_EQ(0, container.increaseAtPos(0, 4));
+	EXPECT_EQ(107, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+
+	EXPECT_EQ(0, container.eraseItem(itemid_1, 10));
+	EXPECT_EQ(7, container.weight());
+	EXPECT_TRUE(container.TakeItemNr(1, taken, cc, 1));
+	EXPECT_EQ(0, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+}
+
+TEST_F(container_weight_tests, propagatesToParents) {
+	Item taken;
+	Container *cc = nullptr;
+
+	EXPECT_TRUE(container.InsertItem(Item{bagid, 1, 0}));
+	Container *bag = nested(container, 0);
+	ASSERT_NE(nullptr, bag);
+	EXPECT_EQ(100, container.weight());
+
+	EXPECT_TRUE(bag->InsertItem(Item{itemid_1, 3, 0}));
+	EXPECT_EQ(30, bag->weight());
+	EXPECT_EQ(130, container.weight());
+
+	EXPECT_TRUE(bag->InsertItem(Item{bagid, 1, 0}));
+	Container *inner = nested(*bag, 1);
+	ASSERT_NE(nullptr, inner);
+	EXPECT_TRUE(inner->InsertItem(Item{itemid_2, 1, 0}));
+	EXPECT_EQ(237, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+
+	EXPECT_EQ(0, bag->eraseItem(itemid_2, 1));
+	EXPECT_EQ(230, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+
+	EXPECT_TRUE(container.TakeItemNr(0, taken, cc, 1));
+	EXPECT_EQ(bag, cc);
+	EXPECT_EQ(0, container.weight());
+	EXPECT_EQ(130, cc->weight());
+	EXPECT_EQ(recount(*cc), cc->weight());
+
+	EXPECT_TRUE(container.InsertContainer(taken, cc));
+	EXPECT_EQ(230, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+}
+
+TEST_F(container_weight_tests, capsNestedWeight) {
+	Item taken;
+	Container *cc = nullptr;
+
+	EXPECT_TRUE(container.InsertItem(Item{bagid, 1, 0}));
+	Container *bag = nested(container, 0);
+	ASSERT_NE(nullptr, bag);
+
+	EXPECT_TRUE(bag->InsertItem(Item{anvilid, 1, 0}));
+	EXPECT_TRUE(bag->InsertItem(Item{anvilid, 1, 0}));
+	EXPECT_EQ(30000, bag->weight());
+	EXPECT_EQ(30000, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+
+	EXPECT_TRUE(bag->TakeItemNr(0, taken, cc, 1));
+	EXPECT_EQ(20000, bag->weight());
+	EXPECT_EQ(20100, container.weight());
+	EXPECT_EQ(recount(container), container.weight());
+}
+
+TEST_F(container_weight_tests, touchLogOnlyRecordsItsOwnThread) {
+	std::vector<const Container *> touched;
+	Container::setTouchLog(&touched);
+
+	// player workers load inventories while the main thread changes the map
+	std::vector<std::thread> workers;
+
+	for (int i = 0; i < 4; ++i) {
+		workers.emplace_back([] {
+			for (int round = 0; round < 1000; ++round) {
+				Container depot(bagid);
+
+				for (TYPE_OF_CONTAINERSLOTS slot = 0; slot < 10; ++slot) {
+					depot.InsertItem(Item{itemid_2, 1, 0}, slot);
+				}
+			}
+		});
+	}
+
+	for (TYPE_OF_CONTAINERSLOTS slot = 0; slot < 10; ++slot) {
+		EXPECT_TRUE(container.InsertItem(Item{itemid_2, 1, 0}, slot));
+	}
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+
+	Container::setTouchLog(nullptr);
+
+	EXPECT_EQ(10u, touched.size());
+	EXPECT_EQ(touched.size(), size_t(std::count(touched.begin(), touched.end(), &container)));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
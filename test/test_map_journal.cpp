@@ -0,0 +1,123 @@
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+#include <vector>
+
+#include "MapJournal.hpp"
+
+using std::chrono::milliseconds;
+
+class map_journal_tests : public ::testing::Test {
+protected:
+    const std::string path = "test_map_journal_" + std::to_string(::getpid());
+
+    ~map_journal_tests() {
+        std::remove(path.c_str());
+    }
+
+    std::vector<std::string> replay(bool &torn) const {
+        std::vector<std::string> records;
+        auto result = MapJournal::replay(path, [&records](const std::string &record) {
+            records.push_back(record);
+        });
+        EXPECT_EQ(records.size(), result.records);
+        torn = result.torn;
+        return records;
+    }
+
+    static std::string batch(std::initializer_list<std::string> records) {
+        std::string result;
+
+        for (const auto &record : records) {
+            MapJournal::addRecord(result, record);
+        }
+
+        return result;
+    }
+};
+
+TEST_F(map_journal_tests, replaysRecordsInOrder) {
+    {
+        MapJournal journal(path, milliseconds(1000));
+        journal.append(batch({"one", "two"}));
+        journal.append(batch({std::string("\0three", 6)}));
+        journal.flush();
+    }
+
+    bool torn;
+    auto records = replay(torn);
+    EXPECT_FALSE(torn);
+    EXPECT_THAT(records, ::testing::ElementsAre("one", "two", std::string("\0three", 6)));
+}
+
+TEST_F(map_journal_tests, stopsAtTornRecord) {
+    {
+        MapJournal journal(path, milliseconds(0));
+        journal.append(batch({"one", "two"}));
+    }
+
+    std::string torn = batch({"three"});
+    torn.resize(torn.size() - 1);
+    std::ofstream(path, std::ios::binary | std::ios::app) << torn;
+
+    bool isTorn;
+    EXPECT_THAT(replay(isTorn), ::testing::ElementsAre("one", "two"));
+    EXPECT_TRUE(isTorn);
+}
+
+TEST_F(map_journal_tests, stopsAtCorruptRecord) {
+    {
+        MapJournal journal(path, milliseconds(0));
+        journal.append(batch({"one", "two"}));
+    }
+
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(-1, std::ios::end);
+    file.put('x');
+    file.close();
+
+    bool torn;
+    EXPECT_THAT(replay(torn), ::testing::ElementsAre("one"));
+    EXPECT_TRUE(torn);
+}
+
+TEST_F(map_journal_tests, truncateDropsEverything) {
+    MapJournal journal(path, milliseconds(1000));
+    journal.append(batch({"one"}));
+    journal.flush();
+    journal.append(batch({"two"}));
+    journal.truncate();
+    journal.append(batch({"three"}));
+    journal.flush();
+
+    bool torn;
+    EXPECT_THAT(replay(torn), ::testing::ElementsAre("three"));
+    EXPECT_FALSE(torn);
+}
+
+TEST_F(map_journal_tests, openingStartsEmpty) {
+    {
+        MapJournal journal(path, milliseconds(0));
+        journal.append(batch({"one"}));
+    }
+
+    MapJournal journal(path, milliseconds(0));
+    journal.flush();
+
+    bool torn;
+    EXPECT_TRUE(replay(torn).empty());
+    EXPECT_EQ(0u, journal.getFailedWrites());
+}
+
+TEST_F(map_journal_tests, missingJournalReplaysNothing) {
+    auto result = MapJournal::replay(path, [](const std::string &) {});
+    EXPECT_EQ(0u, result.records);
+    EXPECT_FALSE(result.torn);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+#include "mpsc_queue.hpp"
+
+TEST(mpsc_queue_tests, popsInPushOrder) {
+    mpsc_queue<int> queue;
+    int item = 0;
+
+    EXPECT_FALSE(queue.pop(item));
+
+    queue.push(1);
+    queue.push(2);
+
+    EXPECT_TRUE(queue.pop(item));
+    EXPECT_EQ(1, item);
+    EXPECT_TRUE(queue.pop(item));
+    EXPECT_EQ(2, item);
+    EXPECT_FALSE(queue.pop(item));
+}
+
+TEST(mpsc_queue_tests, keepsItemsOfAllProducers) {
+    mpsc_queue<int> queue;
+    const int producers = 4;
+    const int itemsPerProducer = 10000;
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < itemsPerProducer; ++i) {
+                queue.push(p * itemsPerProducer + i);
+            }
+        });
+    }
+
+    std::vector<int> last(producers, -1);
+    int received = 0;
+    int item;
+
+    while (received < producers * itemsPerProducer) {
+        if (queue.pop(item)) {
+            const int producer = item / itemsPerProducer;
+            EXPECT_LT(last[producer], item);
+            last[producer] = item;
+            ++received;
+        }
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_FALSE(queue.pop(item));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,57 @@
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+#include "ring_buffer.hpp"
+
+TEST(ring_buffer_tests, drainsInOrderAndEmpties) {
+    ring_buffer<int> ring(4);
+    std::vector<int> out;
+
+    ring.push(1);
+    ring.push(2);
+    ring.push(3);
+    EXPECT_EQ(3u, ring.size());
+
+    ring.drain(out);
+    EXPECT_THAT(out, testing::ElementsAre(1, 2, 3));
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(0u, ring.getDropCount());
+}
+
+TEST(ring_buffer_tests, overwritesOldestWhenFull) {
+    ring_buffer<std::string> ring(3);
+    std::vector<std::string> out;
+
+    for (const auto &s : {"a", "b", "c", "d", "e"}) {
+        ring.push(s);
+    }
+
+    EXPECT_EQ(3u, ring.size());
+    EXPECT_EQ(2u, ring.getDropCount());
+
+    ring.drain(out);
+    EXPECT_THAT(out, testing::ElementsAre("c", "d", "e"));
+}
+
+TEST(ring_buffer_tests, keepsWorkingAfterDrain) {
+    ring_buffer<int> ring(2);
+    std::vector<int> out;
+
+    ring.push(1);
+    ring.push(2);
+    ring.drain(out);
+    out.clear();
+
+    ring.push(3);
+    ring.push(4);
+    ring.push(5);
+    ring.drain(out);
+    EXPECT_THAT(out, testing::ElementsAre(4, 5));
+    EXPECT_EQ(1u, ring.getDropCount());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
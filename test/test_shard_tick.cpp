@@ -0,0 +1,144 @@
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "ShardTick.hpp"
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class shard_tick_tests : public ::testing::Test {
+public:
+    static const size_t SHARDS = 3;
+
+    // where every member stands, only changed between runs
+    std::vector<size_t> location;
+    std::vector<std::vector<ShardTick::Id>> seen;
+    std::vector<std::thread::id> threads;
+    ShardTick tick;
+
+    shard_tick_tests() : location(100, ShardTick::GONE), seen(SHARDS), threads(SHARDS), tick(SHARDS, [this](ShardTick::Id id) {
+        return location[id];
+    }) {
+    }
+
+    void place(ShardTick::Id id, size_t shard) {
+        location[id] = shard;
+        tick.adopt(id, shard);
+    }
+
+    void move(ShardTick::Id id, size_t to) {
+        tick.handOver(id, location[id], to);
+        location[id] = to;
+    }
+
+    void run() {
+        for (auto &members : seen) {
+            members.clear();
+        }
+
+        tick.run([this](size_t shard, ShardTick::Id id) {
+            seen[shard].push_back(id);
+            threads[shard] = std::this_thread::get_id();
+        });
+    }
+};
+
+const size_t shard_tick_tests::SHARDS;
+
+TEST_F(shard_tick_tests, runsEveryShardOnAThreadOfItsOwn) {
+    for (ShardTick::Id id = 0; id < 30; ++id) {
+        place(id, id % SHARDS);
+    }
+
+    run();
+
+    for (size_t shard = 0; shard < SHARDS; ++shard) {
+        ASSERT_EQ(10u, seen[shard].size());
+
+        for (size_t i = 0; i < 10; ++i) {
+            EXPECT_EQ(i * SHARDS + shard, seen[shard][i]);
+        }
+
+        EXPECT_NE(std::this_thread::get_id(), threads[shard]);
+        EXPECT_EQ(1, std::count(threads.begin(), threads.end(), threads[shard]));
+    }
+}
+
+TEST_F(shard_tick_tests, handsOverQueuedMovesInOrder) {
+    place(1, 0);
+    place(2, 0);
+    place(3, 0);
+    run();
+
+    move(1, 1);
+    move(2, 1);
+    move(2, 2);
+    move(3, 1);
+    move(3, 0);
+    run();
+
+    EXPECT_THAT(seen[0], ElementsAre(3));
+    EXPECT_THAT(seen[1], ElementsAre(1));
+    EXPECT_THAT(seen[2], ElementsAre(2));
+}
+
+TEST_F(shard_tick_tests, takesOverMembersFoundElsewhere) {
+    place(1, 0);
+    place(2, 0);
+    run();
+
+    // warped without a queued move
+    location[1] = 2;
+    run();
+    EXPECT_THAT(seen[0], ElementsAre(2));
+
+    run();
+    EXPECT_THAT(seen[0], ElementsAre(2));
+    EXPECT_THAT(seen[1], IsEmpty());
+    EXPECT_THAT(seen[2], ElementsAre(1));
+}
+
+TEST_F(shard_tick_tests, dropsMembersWhichAreGone) {
+    place(1, 1);
+    place(2, 1);
+    run();
+
+    location[1] = ShardTick::GONE;
+    run();
+    EXPECT_THAT(seen[1], ElementsAre(2));
+
+    // coming back needs a new adoption
+    location[1] = 1;
+    run();
+    EXPECT_THAT(seen[1], ElementsAre(2));
+
+    tick.adopt(1, 1);
+    run();
+    EXPECT_THAT(seen[1], ElementsAre(2, 1));
+}
+
+TEST_F(shard_tick_tests, canBeReusedManyTimes) {
+    for (ShardTick::Id id = 0; id < 90; ++id) {
+        place(id, id % SHARDS);
+    }
+
+    for (int round = 0; round < 1000; ++round) {
+        move(round % 90, (location[round % 90] + 1) % SHARDS);
+        run();
+
+        size_t members = 0;
+
+        for (const auto &shard : seen) {
+            members += shard.size();
+        }
+
+        ASSERT_EQ(90u, members);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
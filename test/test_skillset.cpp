@@ -0,0 +1,50 @@
+#include <gmock/gmock.h>
+
+#include <vector>
+#include "SkillSet.hpp"
+
+TEST(skill_set, empty) {
+    SkillSet skills;
+    EXPECT_TRUE(skills.empty());
+    EXPECT_EQ(nullptr, skills.find(3));
+}
+
+TEST(skill_set, insertAndFind) {
+    SkillSet skills;
+    skills[200].major = 42;
+    EXPECT_EQ(1, skills.size());
+    ASSERT_NE(nullptr, skills.find(200));
+    EXPECT_EQ(42, skills.find(200)->major);
+    EXPECT_EQ(nullptr, skills.find(199));
+}
+
+TEST(skill_set, erase) {
+    SkillSet skills;
+    skills[7].major = 1;
+    skills.erase(7);
+    EXPECT_TRUE(skills.empty());
+    EXPECT_EQ(nullptr, skills.find(7));
+    EXPECT_EQ(0, skills[7].major);
+}
+
+TEST(skill_set, forEachVisitsSkillsInOrder) {
+    SkillSet skills;
+    skills[130].major = 3;
+    skills[2].major = 1;
+    skills[64].major = 2;
+    std::vector<TYPE_OF_SKILL_ID> ids;
+    std::vector<unsigned short> majors;
+
+    skills.for_each([&](TYPE_OF_SKILL_ID skill, const SkillSet::value &value) {
+        ids.push_back(skill);
+        majors.push_back(value.major);
+    });
+
+    EXPECT_EQ((std::vector<TYPE_OF_SKILL_ID>{2, 64, 130}), ids);
+    EXPECT_EQ((std::vector<unsigned short>{1, 2, 3}), majors);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,117 @@
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include "SpecialFieldIndex.hpp"
+
+using testing::ElementsAre;
+
+TEST(special_field_index_tests, tellsKindsApart) {
+    SpecialFieldIndex index;
+    index.add(position(10, 20, 0), SpecialFieldIndex::warp);
+    index.add(position(10, 20, 0), SpecialFieldIndex::trigger);
+
+    EXPECT_TRUE(index.has(position(10, 20, 0), SpecialFieldIndex::warp));
+    EXPECT_TRUE(index.has(position(10, 20, 0), SpecialFieldIndex::trigger));
+    EXPECT_FALSE(index.has(position(10, 20, 1), SpecialFieldIndex::warp));
+    EXPECT_FALSE(index.has(position(11, 20, 0), SpecialFieldIndex::warp));
+}
+
+TEST(special_field_index_tests, handlesNegativeCoordinates) {
+    SpecialFieldIndex index;
+    index.add(position(-1, -1, -3), SpecialFieldIndex::trigger);
+    index.add(position(-64, -65, -3), SpecialFieldIndex::trigger);
+
+    EXPECT_TRUE(index.has(position(-1, -1, -3), SpecialFieldIndex::trigger));
+    EXPECT_TRUE(index.has(position(-64, -65, -3), SpecialFieldIndex::trigger));
+    EXPECT_FALSE(index.has(position(63, 63, -3), SpecialFieldIndex::trigger));
+    EXPECT_EQ(2u, index.size(SpecialFieldIndex::trigger));
+}
+
+TEST(special_field_index_tests, removeAndClear) {
+    SpecialFieldIndex index;
+    index.add(position(5, 5, 0), SpecialFieldIndex::warp);
+    index.add(position(5, 5, 0), SpecialFieldIndex::warp);
+    index.add(position(6, 5, 0), SpecialFieldIndex::trigger);
+    EXPECT_EQ(1u, index.size(SpecialFieldIndex::warp));
+
+    index.remove(position(5, 5, 0), SpecialFieldIndex::warp);
+    index.remove(position(5, 5, 0), SpecialFieldIndex::warp);
+    EXPECT_FALSE(index.has(position(5, 5, 0), SpecialFieldIndex::warp));
+    EXPECT_EQ(0u, index.size(SpecialFieldIndex::warp));
+
+    index.clear(SpecialFieldIndex::trigger);
+    EXPECT_FALSE(index.has(position(6, 5, 0), SpecialFieldIndex::trigger));
+    EXPECT_EQ(0u, index.size(SpecialFieldIndex::trigger));
+}
+
+TEST(special_field_index_tests, findsOnlyWithinRangeAcrossChunks) {
+    SpecialFieldIndex index;
+    index.add(position(62, 0, 0), SpecialFieldIndex::warp);
+    index.add(position(64, 1, 0), SpecialFieldIndex::warp);
+    index.add(position(70, 0, 0), SpecialFieldIndex::warp);
+    index.add(position(63, -1, 0), SpecialFieldIndex::warp);
+    index.add(position(63, 0, 1), SpecialFieldIndex::warp);
+    index.add(position(63, 0, 0), SpecialFieldIndex::trigger);
+
+    std::vector<position> found;
+    index.findInRange(position(63, 0, 0), 1, SpecialFieldIndex::warp, found);
+    std::sort(found.begin(), found.end(), [](const position &a, const position &b) {
+        return a.x < b.x;
+    });
+
+    EXPECT_THAT(found, ElementsAre(position(62, 0, 0), position(63, -1, 0), position(64, 1, 0)));
+}
+
+TEST(special_field_index_tests, findsWholeChunkRows) {
+    SpecialFieldIndex index;
+
+    for (short x = 0; x < 64; ++x) {
+        index.add(position(x, 3, 0), SpecialFieldIndex::trigger);
+    }
+
+    std::vector<position> found;
+    index.findInRange(position(32, 3, 0), 40, SpecialFieldIndex::trigger, found);
+    EXPECT_EQ(64u, found.size());
+}
+
+TEST(special_field_index_tests, coveredChunksAgreeWithTheRest) {
+    SpecialFieldIndex index;
+    index.add(position(10, 10, 0), SpecialFieldIndex::warp);
+    index.add(position(500, 10, 0), SpecialFieldIndex::warp);
+
+    // covers the first entry, which was added before
+    index.cover(0, -100, -100, 199, 199);
+    index.add(position(-70, 150, 0), SpecialFieldIndex::trigger);
+
+    EXPECT_TRUE(index.has(position(10, 10, 0), SpecialFieldIndex::warp));
+    EXPECT_TRUE(index.has(position(500, 10, 0), SpecialFieldIndex::warp));
+    EXPECT_TRUE(index.has(position(-70, 150, 0), SpecialFieldIndex::trigger));
+    EXPECT_FALSE(index.has(position(-70, 150, 0), SpecialFieldIndex::warp));
+
+    // levels below and above, and growing one
+    index.cover(-2, 0, 0, 63, 63);
+    index.cover(3, 0, 0, 63, 63);
+    index.cover(0, 400, 0, 599, 63);
+    index.add(position(1, 1, -2), SpecialFieldIndex::warp);
+    EXPECT_TRUE(index.has(position(1, 1, -2), SpecialFieldIndex::warp));
+    EXPECT_FALSE(index.has(position(1, 1, 3), SpecialFieldIndex::warp));
+    EXPECT_TRUE(index.has(position(500, 10, 0), SpecialFieldIndex::warp));
+    EXPECT_TRUE(index.has(position(10, 10, 0), SpecialFieldIndex::warp));
+
+    index.remove(position(10, 10, 0), SpecialFieldIndex::warp);
+    index.clear(SpecialFieldIndex::trigger);
+    EXPECT_FALSE(index.has(position(10, 10, 0), SpecialFieldIndex::warp));
+    EXPECT_FALSE(index.has(position(-70, 150, 0), SpecialFieldIndex::trigger));
+
+    index.add(position(10, 11, 0), SpecialFieldIndex::trigger);
+    EXPECT_TRUE(index.has(position(10, 11, 0), SpecialFieldIndex::trigger));
+
+    std::vector<position> found;
+    index.findInRange(position(450, 10, 0), 60, SpecialFieldIndex::warp, found);
+    EXPECT_THAT(found, ElementsAre(position(500, 10, 0)));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,88 @@
+#include <gmock/gmock.h>
+
+#include "TickPacer.hpp"
+
+using std::chrono::milliseconds;
+
+class tick_pacer_tests : public ::testing::Test {
+protected:
+    const TickPacer::clock::time_point start = TickPacer::clock::now();
+};
+
+TEST_F(tick_pacer_tests, handsOutOnePointPerStep) {
+    TickPacer pacer(milliseconds(100), milliseconds(0), false, start);
+
+    EXPECT_EQ(0, pacer.startTick(start + milliseconds(50)));
+    EXPECT_EQ(1, pacer.startTick(start + milliseconds(100)));
+    EXPECT_EQ(0, pacer.startTick(start + milliseconds(150)));
+    EXPECT_EQ(1, pacer.startTick(start + milliseconds(230)));
+    EXPECT_EQ(milliseconds(30), pacer.getSkew());
+    EXPECT_EQ(2u, pacer.getTicks());
+}
+
+TEST_F(tick_pacer_tests, lateTickCatchesUp) {
+    TickPacer pacer(milliseconds(100), milliseconds(0), false, start);
+
+    EXPECT_EQ(1, pacer.startTick(start + milliseconds(100)));
+    EXPECT_EQ(3, pacer.startTick(start + milliseconds(420)));
+    EXPECT_EQ(milliseconds(220), pacer.getSkew());
+}
+
+TEST_F(tick_pacer_tests, fixedStepIgnoresTheClock) {
+    TickPacer pacer(milliseconds(100), milliseconds(0), true, start);
+
+    EXPECT_EQ(1, pacer.startTick(start));
+    EXPECT_EQ(1, pacer.startTick(start));
+    EXPECT_EQ(1, pacer.startTick(start + milliseconds(1000)));
+    EXPECT_EQ(milliseconds(0), pacer.getSkew());
+    EXPECT_EQ(3u, pacer.getTicks());
+}
+
+TEST_F(tick_pacer_tests, reportsOverrunsAgainstTheBudget) {
+    TickPacer pacer(milliseconds(100), milliseconds(50), false, start);
+
+    pacer.startTick(start + milliseconds(100));
+    EXPECT_FALSE(pacer.isOverBudget(start + milliseconds(140)));
+    EXPECT_TRUE(pacer.isOverBudget(start + milliseconds(160)));
+    EXPECT_EQ(milliseconds(25), pacer.finishTick(start + milliseconds(175)));
+    EXPECT_TRUE(pacer.wasOverBudget());
+
+    pacer.startTick(start + milliseconds(200));
+    EXPECT_EQ(milliseconds(0), pacer.finishTick(start + milliseconds(210)));
+    EXPECT_FALSE(pacer.wasOverBudget());
+}
+
+TEST_F(tick_pacer_tests, zeroBudgetNeverOverruns) {
+    TickPacer pacer(milliseconds(100), milliseconds(0), false, start);
+
+    pacer.startTick(start + milliseconds(100));
+    EXPECT_FALSE(pacer.isOverBudget(start + milliseconds(10000)));
+    EXPECT_EQ(milliseconds(0), pacer.finishTick(start + milliseconds(10000)));
+    EXPECT_FALSE(pacer.wasOverBudget());
+}
+
+TEST_F(tick_pacer_tests, fixedStepNeverDefers) {
+    TickPacer pacer(milliseconds(100), milliseconds(50), true, start);
+
+    pacer.startTick(start);
+    EXPECT_FALSE(pacer.isOverBudget(start + milliseconds(1000)));
+    EXPECT_EQ(milliseconds(950), pacer.finishTick(start + milliseconds(1000)));
+    EXPECT_FALSE(pacer.wasOverBudget());
+}
+
+TEST_F(tick_pacer_tests, countsStepsNotTicks) {
+    TickPacer clocked(milliseconds(100), milliseconds(0), false, start);
+    clocked.startTick(start + milliseconds(100));
+    clocked.startTick(start + milliseconds(420));
+    EXPECT_EQ(4u, clocked.getSteps());
+
+    TickPacer fixed(milliseconds(100), milliseconds(0), true, start);
+    fixed.startTick(start + milliseconds(100));
+    fixed.startTick(start + milliseconds(420));
+    EXPECT_EQ(2u, fixed.getSteps());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,69 @@
+#include <gmock/gmock.h>
+
+#include <vector>
+#include "TimingWheel.hpp"
+
+class timing_wheel_tests : public ::testing::Test {
+public:
+    TimingWheel wheel;
+
+    std::vector<TYPE_OF_CHARACTER_ID> advance() {
+        std::vector<TYPE_OF_CHARACTER_ID> due;
+
+        wheel.advance([&due](TYPE_OF_CHARACTER_ID id, int32_t) {
+            due.push_back(id);
+        });
+
+        return due;
+    }
+
+    int32_t advanceUntilDue(TYPE_OF_CHARACTER_ID id) {
+        while (wheel.size() > 0) {
+            for (const auto &due : advance()) {
+                if (due == id) {
+                    return wheel.getTime();
+                }
+            }
+        }
+
+        return -1;
+    }
+};
+
+TEST_F(timing_wheel_tests, entryIsDueInItsTick) {
+    wheel.schedule(1, 3);
+    EXPECT_TRUE(advance().empty());
+    EXPECT_TRUE(advance().empty());
+    EXPECT_EQ(std::vector<TYPE_OF_CHARACTER_ID>{1}, advance());
+    EXPECT_EQ(0, wheel.size());
+}
+
+TEST_F(timing_wheel_tests, pastEntryIsDueInNextTick) {
+    advance();
+    wheel.schedule(1, -5);
+    EXPECT_EQ(std::vector<TYPE_OF_CHARACTER_ID>{1}, advance());
+}
+
+TEST_F(timing_wheel_tests, distantEntriesAreDueOnTime) {
+    wheel.schedule(1, 64);
+    wheel.schedule(2, 4100);
+    wheel.schedule(3, 300000);
+    wheel.schedule(4, 20000000);
+    EXPECT_EQ(64, advanceUntilDue(1));
+    EXPECT_EQ(4100, advanceUntilDue(2));
+    EXPECT_EQ(300000, advanceUntilDue(3));
+    EXPECT_EQ(20000000, advanceUntilDue(4));
+}
+
+TEST_F(timing_wheel_tests, entryScheduledWhileAdvancingIsDueLater) {
+    wheel.schedule(1, 1);
+    wheel.advance([this](TYPE_OF_CHARACTER_ID id, int32_t) {
+        wheel.schedule(id + 1, wheel.getTime());
+    });
+    EXPECT_EQ(std::vector<TYPE_OF_CHARACTER_ID>{2}, advance());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <vector>
+#include "WorkerPool.hpp"
+
+void expectEveryIndexOnce(WorkerPool &pool, size_t count) {
+    std::vector<std::atomic<int>> calls(count);
+
+    for (auto &call : calls) {
+        call = 0;
+    }
+
+    pool.run(count, [&calls](size_t i) {
+        ++calls[i];
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(1, calls[i]) << "index " << i;
+    }
+}
+
+TEST(worker_pool_tests, runsOnCallerWithoutThreads) {
+    WorkerPool pool(0);
+    EXPECT_EQ(0u, pool.size());
+    expectEveryIndexOnce(pool, 1000);
+}
+
+TEST(worker_pool_tests, runsEveryIndexOnce) {
+    WorkerPool pool(3);
+    EXPECT_EQ(3u, pool.size());
+
+    for (size_t count : {0, 1, 16, 17, 1000, 10007}) {
+        expectEveryIndexOnce(pool, count);
+    }
+}
+
+TEST(worker_pool_tests, canBeReusedManyTimes) {
+    WorkerPool pool(2);
+    long sum = 0;
+
+    for (int round = 0; round < 1000; ++round) {
+        std::vector<int> values(100);
+
+        pool.run(values.size(), [&values](size_t i) {
+            values[i] = i;
+        });
+
+        for (int value : values) {
+            sum += value;
+        }
+    }
+
+    EXPECT_EQ(1000 * 4950, sum);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,42 @@
+#include <gmock/gmock.h>
+
+#include "WorldShards.hpp"
+
+TEST(world_shards_tests, noneKeepsEverythingInShardZero) {
+    WorldShards shards;
+    EXPECT_TRUE(shards.configure("none"));
+    EXPECT_EQ(1u, shards.size());
+    EXPECT_EQ(0u, shards.getShard(position(100, -100, 3)));
+}
+
+TEST(world_shards_tests, levelsGoToTheirShards) {
+    WorldShards shards;
+    EXPECT_TRUE(shards.configure("z:0;z:..-1"));
+    EXPECT_EQ(3u, shards.size());
+    EXPECT_EQ(1u, shards.getShard(position(5, 5, 0)));
+    EXPECT_EQ(2u, shards.getShard(position(5, 5, -7)));
+    EXPECT_EQ(0u, shards.getShard(position(5, 5, 2)));
+}
+
+TEST(world_shards_tests, firstMatchingBoxWins) {
+    WorldShards shards;
+    EXPECT_TRUE(shards.configure("x:..499,z:0;x:0..999,y:0..999"));
+    EXPECT_EQ(1u, shards.getShard(position(499, 10, 0)));
+    EXPECT_EQ(2u, shards.getShard(position(500, 10, 0)));
+    EXPECT_EQ(2u, shards.getShard(position(100, 10, 1)));
+    EXPECT_EQ(0u, shards.getShard(position(100, 1000, 1)));
+}
+
+TEST(world_shards_tests, invalidSpecsLeaveOneShard) {
+    WorldShards shards;
+
+    for (const char *spec : {"z", "z:", "w:1", "z:1..a", "z:5..1", "z:0;;z:1", "x:..,z:0"}) {
+        EXPECT_FALSE(shards.configure(spec)) << spec;
+        EXPECT_EQ(1u, shards.size()) << spec;
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}